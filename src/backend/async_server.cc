@@ -0,0 +1,188 @@
+#include "async_server.hh"
+
+/**
+ * AsyncStreamCall
+ *
+ */
+AsyncStreamCall::AsyncStreamCall(AsyncBackendServer* server, grpc::ServerCompletionQueue* cq):
+                                 server_(server),
+                                 cq_(cq),
+                                 stream_(&ctx_),
+                                 writing_(false),
+                                 reads_done_(false),
+                                 broken_(false),
+                                 finishing_(false)
+{
+    connect_tag_ = Tag{this, CONNECT};
+    read_tag_ = Tag{this, READ};
+    write_tag_ = Tag{this, WRITE};
+    finish_tag_ = Tag{this, FINISH};
+}
+
+AsyncStreamCall::~AsyncStreamCall() {}
+
+void AsyncStreamCall::Proceed(Op op, bool ok) {
+    switch (op) {
+    case CONNECT:
+        if (!ok) {
+            // the server is shutting down
+            return;
+        }
+        LOG_INFO("AsyncStreamCall new stream from %s", ctx_.peer().c_str());
+        server_->SpawnCall(cq_);
+        stream_.Read(&request_, &read_tag_);
+        break;
+    case READ: {
+        if (!ok) {
+            // the frontend closed its side of the stream
+            std::lock_guard<std::mutex> lock(mutex_);
+            reads_done_ = true;
+            // the queries still in the pipeline reply later
+            if (!writing_ && !referenced()) {
+                finishLocked();
+            }
+            return;
+        }
+        LOG_INFO("ElasticcdcService receive rpc DataTransStream, id: %ld, filename: %s, scale: %s, modle name: %s, data size: %ld",
+                 request_.id(), request_.filename().c_str(), request_.scale().c_str(), request_.model_name().c_str(), request_.data().size());
+        server_->GetBackend()->Exec(MakeImageArgs(request_, this));
+        stream_.Read(&request_, &read_tag_);
+        break;
+    }
+    case WRITE: {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_ = false;
+        if (!ok) {
+            LOG_ERROR("AsyncStreamCall write failed, drop %ld replies", pending_.size());
+            broken_ = true;
+            pending_.clear();
+        }
+        if (!pending_.empty()) {
+            // the reply is serialized by Write, it can be dropped right away
+            writing_ = true;
+            stream_.Write(pending_.front(), &write_tag_);
+            pending_.pop_front();
+        } else if (reads_done_ && !referenced()) {
+            finishLocked();
+        }
+        break;
+    }
+    case FINISH:
+        LOG_INFO("AsyncStreamCall stream from %s finished", ctx_.peer().c_str());
+        {
+            // unreferenced() may still hold the mutex after starting the
+            // finish
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        // the reference of the stream itself, the call may be gone after it
+        Unref();
+        break;
+    }
+}
+
+bool AsyncStreamCall::Write(const ElasticcdcReply& reply) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (broken_ || finishing_) {
+        return false;
+    }
+    if (writing_) {
+        pending_.push_back(reply);
+        return true;
+    }
+    writing_ = true;
+    stream_.Write(reply, &write_tag_);
+    return true;
+}
+
+void AsyncStreamCall::unreferenced() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reads_done_ && !writing_) {
+        finishLocked();
+    }
+}
+
+void AsyncStreamCall::released() {
+    server_->EraseCall(this);
+}
+
+void AsyncStreamCall::finishLocked() {
+    if (finishing_) {
+        return;
+    }
+    finishing_ = true;
+    stream_.Finish(Status::OK, &finish_tag_);
+}
+
+/**
+ * AsyncBackendServer
+ *
+ */
+AsyncBackendServer::AsyncBackendServer(std::shared_ptr<Backend> backend, int cq_threads):
+                                       backend_(backend),
+                                       cq_threads_(std::max(cq_threads, 1)),
+                                       service_(backend.get())
+{
+}
+
+AsyncBackendServer::~AsyncBackendServer() {
+    Shutdown();
+}
+
+void AsyncBackendServer::Register(grpc::ServerBuilder& builder) {
+    builder.RegisterService(&service_);
+    for (int i = 0; i < cq_threads_; i++) {
+        cqs_.emplace_back(builder.AddCompletionQueue());
+    }
+}
+
+void AsyncBackendServer::SpawnCall(grpc::ServerCompletionQueue* cq) {
+    auto call = std::make_unique<AsyncStreamCall>(this, cq);
+    AsyncStreamCall* raw = call.get();
+    {
+        std::lock_guard<std::mutex> lock(calls_mtx_);
+        calls_.emplace(raw, std::move(call));
+    }
+    service_.RequestDataTransStream(raw->Context(), raw->Stream(), cq, cq, raw->ConnectTag());
+}
+
+void AsyncBackendServer::EraseCall(AsyncStreamCall* call) {
+    std::unique_ptr<AsyncStreamCall> erased;
+    {
+        std::lock_guard<std::mutex> lock(calls_mtx_);
+        auto it = calls_.find(call);
+        if (it == calls_.end()) {
+            return;
+        }
+        erased = std::move(it->second);
+        calls_.erase(it);
+    }
+}
+
+void AsyncBackendServer::Run() {
+    LOG_INFO("AsyncBackendServer polling %d completion queues", cq_threads_);
+    for (auto& cq : cqs_) {
+        SpawnCall(cq.get());
+    }
+    for (auto& cq : cqs_) {
+        threads_.emplace_back(&AsyncBackendServer::poll, this, cq.get());
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+void AsyncBackendServer::Shutdown() {
+    for (auto& cq : cqs_) {
+        cq->Shutdown();
+    }
+}
+
+void AsyncBackendServer::poll(grpc::ServerCompletionQueue* cq) {
+    void* tag;
+    bool ok;
+    while (cq->Next(&tag, &ok)) {
+        auto call_tag = static_cast<AsyncStreamCall::Tag*>(tag);
+        call_tag->call_->Proceed(call_tag->op_, ok);
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "../inc/inc.hh"
+#include "../common/logger.hh"
+#include "backend.hh"
+#include "reply_stream.hh"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+class AsyncBackendServer;
+
+/**
+ * AsyncStreamCall
+ * One DataTransStream of the async server. Its reads complete on the
+ * completion queue it was requested on, and each request is handed to the
+ * backend by that polling thread. The replies come from the ReplyWorker and
+ * are written one at a time, the next one is started when the previous
+ * write completes. The stream is finished once the frontend closed its
+ * side, every query of the stream is answered and the replies are written.
+ * The call is freed when the finish completes.
+ */
+class AsyncStreamCall : public ReplyStream {
+public:
+    enum Op {
+        CONNECT,
+        READ,
+        WRITE,
+        FINISH
+    };
+
+    struct Tag {
+        AsyncStreamCall* call_;
+        Op op_;
+    };
+
+    AsyncStreamCall(AsyncBackendServer* server, grpc::ServerCompletionQueue* cq);
+    ~AsyncStreamCall();
+
+    bool Write(const ElasticcdcReply& reply) override;
+    // called by the polling thread when an operation of the call completes
+    void Proceed(Op op, bool ok);
+
+    grpc::ServerContext* Context() { return &ctx_; }
+    grpc::ServerAsyncReaderWriter<ElasticcdcReply, ElasticcdcRequest>* Stream() { return &stream_; }
+    void* ConnectTag() { return &connect_tag_; }
+
+protected:
+    void unreferenced() override;
+    void released() override;
+
+private:
+    // called with mutex_ held
+    void finishLocked();
+
+    AsyncBackendServer* server_;
+    grpc::ServerCompletionQueue* cq_;
+    grpc::ServerContext ctx_;
+    grpc::ServerAsyncReaderWriter<ElasticcdcReply, ElasticcdcRequest> stream_;
+    ElasticcdcRequest request_;
+
+    Tag connect_tag_;
+    Tag read_tag_;
+    Tag write_tag_;
+    Tag finish_tag_;
+
+    std::mutex mutex_;
+    // replies waiting for the write in flight to complete
+    std::deque<ElasticcdcReply> pending_;
+    bool writing_;
+    bool reads_done_;
+    bool broken_;
+    bool finishing_;
+};
+
+/**
+ * AsyncFeatureService
+ * DataTransStream is served on the completion queues, FetchFeatures is rare
+ * and answered from the FeatureStore by the sync threads of grpc.
+ */
+class AsyncFeatureService : public ElasticcdcService::WithAsyncMethod_DataTransStream<ElasticcdcService::Service> {
+public:
+    AsyncFeatureService(Backend* backend): backend_(backend) {}
+
+    grpc::Status FetchFeatures(grpc::ServerContext* context, const ElasticcdcRequest* request,
+                               ElasticcdcReply* reply) override {
+        backend_->FetchFeatures(*request, reply);
+        return grpc::Status::OK;
+    }
+
+private:
+    Backend* backend_;
+};
+
+/**
+ * AsyncBackendServer
+ * Serves DataTransStream with completion queues, one per polling thread. The
+ * polling threads convert the requests and push them to the batchers of the
+ * backend themselves.
+ */
+class AsyncBackendServer {
+public:
+    AsyncBackendServer(std::shared_ptr<Backend> backend, int cq_threads);
+    ~AsyncBackendServer();
+
+    // adds the service and the completion queues, before the server is built
+    void Register(grpc::ServerBuilder& builder);
+    // polls the completion queues until they are shut down
+    void Run();
+    void Shutdown();
+
+    Backend* GetBackend() { return backend_.get(); }
+    // waits for the next stream on 'cq'
+    void SpawnCall(grpc::ServerCompletionQueue* cq);
+    // frees a call whose stream is finished and no longer referred to
+    void EraseCall(AsyncStreamCall* call);
+
+private:
+    void poll(grpc::ServerCompletionQueue* cq);
+
+    std::shared_ptr<Backend> backend_;
+    int cq_threads_;
+    AsyncFeatureService service_;
+    std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+    std::vector<std::thread> threads_;
+
+    // the calls waiting for a stream or serving one, and the finished ones
+    // whose queries are still in the pipeline
+    std::mutex calls_mtx_;
+    std::unordered_map<AsyncStreamCall*, std::unique_ptr<AsyncStreamCall>> calls_;
+};
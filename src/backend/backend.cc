@@ -1,94 +1,270 @@
 #include "backend.hh"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <unistd.h>
 
+// set by SIGTERM, which most clouds send ahead of a preemption
+static std::atomic<bool> drain_signal(false);
+
+static void onDrainSignal(int) {
+    drain_signal.store(true);
+}
+
+std::string ResultCacheKey(const std::string& model_name, const std::string& data,
+                           const std::string& feature_precision, uint32_t top_k) {
+    size_t hash = std::hash<std::string_view>()(std::string_view(data.data(), data.size()));
+    char suffix[64];
+    if (top_k > 0) {
+        snprintf(suffix, sizeof(suffix), "/%016zx/%zu/top%u", hash, data.size(), top_k);
+    } else {
+        snprintf(suffix, sizeof(suffix), "/%016zx/%zu", hash, data.size());
+    }
+    return model_name + "/" + feature_precision + suffix;
+}
+
+ImageArgs MakeImageArgs(ElasticcdcRequest& request, ReplyStream* stream) {
+    ImageArgs request_info;
+    request_info.filename = request.filename();
+    request_info.model_name = request.model_name();
+    request_info.id = request.id();
+    request_info.scale = request.scale();
+    // the payload is moved, the request is only read again afterwards
+    request_info.data.swap(*request.mutable_data());
+    request_info.stream = stream;
+    request_info.cdc_infer_time = request.cdc_infer_time();
+    request_info.backup_infer_time = request.backup_infer_time();
+    request_info.decode_time = request.decode_time();
+    request_info.encode_type = request.encode_type();
+    request_info.front_id = request.frontend_id();
+    request_info.end_signal = request.end_signal();
+    request_info.recompute = request.recompute();
+    request_info.has_deadline = request.has_deadline_ms();
+    request_info.deadline_ms = request.deadline_ms();
+    request_info.top_k = request.output_mode() == ElasticcdcRequest::TOPK ? std::max<uint32_t>(request.top_k(), 1) : 0;
+    request_info.retain = request.output_mode() == ElasticcdcRequest::RETAIN;
+    request_info.compressed = request.compressed();
+    return request_info;
+}
 
 /**
  * Backend
  * 
  */ 
-Backend::Backend(const std::string& conf_path) {
+Backend::Backend(const std::string& conf_path): draining_(false), stop_drain_(false) {
+    auto start = std::chrono::steady_clock::now();
     conf_ = std::make_shared<Config>(conf_path);
     conf_->parse();
-    SetCache(conf_->getCacheConfig());
-    batch_size_1_ = conf_->batch_size_1;
-    batch_size_2_ = conf_->batch_size_2;
-    batch_size_adjust = conf_->batch_mode == "auto" ? true : false;
-    first_adjust = true;
-
-    rep_recv_queue_ = std::make_shared<SingleQueryQueue>();
-    cdc_recv_queue_ = std::make_shared<SingleQueryQueue>();
-    batch_queue_ = std::make_shared<BatchQueryQueue>();
-    infer_queue_ = std::make_shared<BatchQueryQueue>();
+    // the disk tier of the cache is opened while the models load
+    double cache_ms = 0;
+    std::thread cache_thread([this, &cache_ms] {
+        auto cache_start = std::chrono::steady_clock::now();
+        SetCache(conf_->getCacheConfig());
+        cache_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                   (std::chrono::steady_clock::now() - cache_start).count();
+    });
+    if (conf_->engine == "torch") {
+        torch_engine_ = std::make_shared<TorchEngine>(conf_);
+    } else {
+        triton_pool_ = std::make_shared<TritonPool>(conf_->triton_urls);
+    }
 
-    rep_recv_mutex_ = std::make_shared<std::mutex>();
-    cdc_recv_mutex_ = std::make_shared<std::mutex>();
-    batch_mutex_ = std::make_shared<std::mutex>();
-    infer_mutex_ = std::make_shared<std::mutex>();
-
-    rep_recv_cv_ = std::make_shared<std::condition_variable>();
-    cdc_recv_cv_ = std::make_shared<std::condition_variable>();
-    batch_cv_ = std::make_shared<std::condition_variable>();
-    infer_cv_ = std::make_shared<std::condition_variable>();
-
-    rep_batch_worker_ = std::make_shared<BatchWorker>(conf_, batch_size_1_, rep_recv_queue_, rep_recv_mutex_, rep_recv_cv_, batch_queue_, batch_mutex_, batch_cv_);
-    cdc_batch_worker_ = std::make_shared<BatchWorker>(conf_, batch_size_2_, cdc_recv_queue_, cdc_recv_mutex_, cdc_recv_cv_, batch_queue_, batch_mutex_, batch_cv_);
-    infer_worker_ = std::make_shared<InferWorker>(conf_, batch_queue_, batch_mutex_, batch_cv_, infer_queue_, infer_mutex_, infer_cv_);
-    reply_worker_ = std::make_shared<ReplyWorker>(conf_, infer_queue_, infer_mutex_, infer_cv_, nullptr, nullptr, nullptr);
-    LOG_INFO("Backend created");
-}
+    infer_queue_ = std::make_shared<BatchQueryQueue>();
+    feature_store_ = std::make_shared<FeatureStore>(conf_->retained_feature_ttl_ms, conf_->retained_feature_bytes);
 
-Backend::~Backend() {}
+    // the batchers of all models hand their batches to the scheduler
+    batch_scheduler_ = std::make_shared<BatchScheduler>(conf_, conf_->model_names);
 
-void Backend::SetCache(const Json::Value& cache_config) {
-    const std::string strategy = cache_config.get("strategy", "").asString();
-    if (strategy == "lru") {
-        cache_ = std::make_shared<LruCache<std::string, std::string>>(cache_config);
-    } else if (strategy == "lfu") {
-        assert(false && "not implemented yet");
-    } else {
-        assert(false && "undefine cache strategy");
+    // one set of receive queues and batchers per served model
+    auto models_start = std::chrono::steady_clock::now();
+    registry_ = std::make_shared<ModelRegistry>(conf_, triton_pool_, batch_scheduler_, torch_engine_);
+    double models_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                       (std::chrono::steady_clock::now() - models_start).count();
+    preprocess_queue_ = std::make_shared<SingleQueryQueue>();
+    preprocess_worker_ = std::make_shared<PreprocessWorker>(conf_, preprocess_queue_, registry_, conf_->preprocess_threads);
+    // a sync InferWorker waits for each of its batches, so one worker per
+    // endpoint keeps all the endpoints busy
+    for (uint32_t i = 0; i < conf_->infer_workers; i++) {
+        infer_workers_.push_back(std::make_shared<InferWorker>(conf_, registry_, batch_scheduler_, infer_queue_,
+                                                               triton_pool_, torch_engine_));
     }
-}
+    cache_thread.join();
+    reply_worker_ = std::make_shared<ReplyWorker>(conf_, infer_queue_, cache_->enabled() ? cache_ : nullptr,
+                                                  feature_store_);
+    if (conf_->batch_mode == "auto") {
+        batch_controller_ = std::make_shared<BatchController>(conf_, registry_);
+    }
+    auto warmup_start = std::chrono::steady_clock::now();
+    warmUp();
+    double warmup_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                       (std::chrono::steady_clock::now() - warmup_start).count();
 
-bool Backend::ifAdjustBatch() {
-    return batch_size_adjust;
+    // a second SIGTERM kills the backend as before
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onDrainSignal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    drain_thread_ = std::thread(&Backend::watchDrain, this);
+    double ready_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                      (std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Backend ready in %lf ms, cache: %lf ms, models: %lf ms, warm-up: %lf ms",
+             ready_ms, cache_ms, models_ms, warmup_ms);
 }
 
-bool Backend::ifFirstAdjust() {
-    return first_adjust;
+Backend::~Backend() {
+    {
+        std::lock_guard<std::mutex> lock(drain_mtx_);
+        stop_drain_ = true;
+    }
+    drain_cv_.notify_all();
+    drain_thread_.join();
 }
 
-void Backend::setAdjustBatch(bool value) {
-    batch_size_adjust = value;
+void Backend::warmUp() {
+    if (conf_->warmup_rounds == 0) {
+        return;
+    }
+    // the InferWorkers send any batch to any endpoint, so every endpoint
+    // gets every size, all of them at once
+    if (torch_engine_ != nullptr) {
+        warmUpSession(nullptr);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < triton_pool_->Size(); i++) {
+        threads.emplace_back(&Backend::warmUpSession, this, triton_pool_->Session(i));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
 }
 
-void Backend::setFirstAdjust(bool value) {
-    first_adjust = value;
+void Backend::warmUpSession(TritonSession* session) {
+    BatchBufferPool buffers;
+    for (const auto& model_name : registry_->ModelNames()) {
+        ModelEntry* model = registry_->Get(model_name);
+        size_t sample_size = session != nullptr ? session->GetModel(model_name)->info_.input_byte_size_ :
+                                                  torch_engine_->SampleInputSize(model_name);
+        std::vector<uint8_t> sample(sample_size, 0);
+        for (int batch_size : warmUpBatchSizes(*model)) {
+            for (uint32_t round = 0; round < conf_->warmup_rounds; round++) {
+                BatchQuery batch_query(model_name, conf_->scale, std::vector<std::string>(batch_size), -1,
+                                       std::vector<ReplyStream*>(batch_size, nullptr), "Warmup",
+                                       std::vector<int>(batch_size, -1));
+                batch_query.input_ = buffers.Acquire(batch_size * sample_size);
+                for (int i = 0; i < batch_size; i++) {
+                    batch_query.input_->Append(sample.data(), sample_size);
+                }
+                auto start = std::chrono::steady_clock::now();
+                if (session != nullptr) {
+                    ImageClassify(*session, batch_query);
+                } else {
+                    torch_engine_->Infer(batch_query);
+                }
+                double latency = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                                 (std::chrono::steady_clock::now() - start).count();
+                // the first round of a size is the cold one, the others
+                // give the batch controller its first measurements
+                if (round > 0) {
+                    model->profile_->Record(batch_size, latency);
+                }
+                LOG_INFO("warm-up model: %s, endpoint: %s, batch size: %d, round: %d, latency: %lf ms",
+                         model_name.c_str(), session != nullptr ? session->Url().c_str() : "torch",
+                         batch_size, round, latency);
+                batch_query.releaseOutputs();
+            }
+        }
+    }
 }
 
-void Backend::forwardBatchSize(int value) {
-    batch_size_1_ += value;
-    batch_size_2_ -= value;
+std::vector<int> Backend::warmUpBatchSizes(const ModelEntry& model) {
+    std::vector<int> batch_sizes;
+    if (!conf_->warmup_batch_sizes.empty()) {
+        for (uint32_t batch_size : conf_->warmup_batch_sizes) {
+            batch_sizes.push_back(std::min<int>(batch_size, model.max_batch_size_));
+        }
+        std::sort(batch_sizes.begin(), batch_sizes.end());
+        batch_sizes.erase(std::unique(batch_sizes.begin(), batch_sizes.end()), batch_sizes.end());
+        return batch_sizes;
+    }
+    // a flushed batch can have any size up to a full one, and the batch
+    // controller picks any size up to max_batch_size
+    int largest = std::max({model.batch_size_1_, model.batch_size_2_, model.recompute_batch_size_});
+    if (conf_->batch_mode == "auto") {
+        largest = std::max<int>(largest, conf_->max_batch_size);
+    }
+    largest = std::min(largest, model.max_batch_size_);
+    for (int batch_size = 1; batch_size <= largest; batch_size++) {
+        batch_sizes.push_back(batch_size);
+    }
+    return batch_sizes;
 }
 
-void Backend::backwardBatchSize(double value) {
-    batch_size_1_ *= (1 - conf_->dec_value);
-    batch_size_2_ *= (1 + conf_->dec_value);
+void Backend::SetCache(const Json::Value& cache_config) {
+    const std::string strategy = cache_config.get("strategy", "").asString();
+    if (strategy == "lru") {
+        cache_ = std::make_shared<LruCache<std::string, std::string>>(cache_config);
+    } else if (strategy == "lfu") {
+        cache_ = std::make_shared<LfuCache<std::string, std::string>>(cache_config);
+    } else if (strategy == "arc") {
+        cache_ = std::make_shared<ArcCache<std::string, std::string>>(cache_config);
+    } else {
+        assert(false && "undefine cache strategy");
+    }
+    // the disk tier keeps the results across restarts, the memory cache is
+    // filled back from it on demand
+    if (cache_->enabled() && !cache_config.get("disk", Json::Value()).get("path", "").asString().empty()) {
+        auto disk = std::make_shared<MmapCache>(cache_config);
+        if (disk->enabled()) {
+            cache_ = std::make_shared<TieredCache<std::string, std::string>>(cache_config, cache_, disk);
+        }
+    }
 }
 
 /**
- * 1. check cache
+ * 1. check the result cache
  * 2. if cache miss, transform request into query, push query into recv queue
- * 3. update cache
+ * 3. the ReplyWorker stores the result in the cache
  */
-void Backend::Exec(const ImageArgs& request) {
-    // 1. check cache
-    std::string reply_info;
-    if (cache_->get(request.filename, reply_info)) {
-        LOG_INFO("cache hit, request info: %s", request.filename.c_str());
-        // reply
+void Backend::Exec(ImageArgs&& request) {
+    // 1. check the result cache, the backups and the recomputes of an image
+    // carry the same tensor
+    std::string cache_key;
+    if (cache_->enabled() && !request.end_signal && !request.data.empty()) {
+        cache_key = ResultCacheKey(request.model_name, request.data, conf_->feature_precision, request.top_k);
+        std::string reply_info;
+        if (cache_->get(cache_key, reply_info)) {
+            LOG_INFO("result cache hit, query: %d, filename: %s", request.id, request.filename.c_str());
+            ElasticcdcReply reply;
+            reply.set_id(request.id);
+            // the cached reply is a FULL one, a RETAIN query keeps its
+            // feature map here as on a miss
+            auto dataset = DATASETS.find(request.model_name);
+            size_t feature_size = dataset == DATASETS.end() ? 0 :
+                FeatureWireSize(ParseFeaturePrecision(conf_->feature_precision), dataset->second.first);
+            if (request.retain && feature_size > 0 && reply_info.size() > feature_size) {
+                reply.set_reply_info(reply_info.substr(feature_size));
+                reply_info.resize(feature_size);
+                feature_store_->Put(request.front_id, request.id, std::move(reply_info));
+            } else {
+                reply.set_reply_info(std::move(reply_info));
+            }
+            request.stream->Write(reply);
+            return;
+        }
+    }
+    // a draining backend only answers from the cache, the frontend sends
+    // the query elsewhere. The end signals still go to the batchers, which
+    // flush what came before them
+    if (draining_.load(std::memory_order_relaxed) && !request.end_signal) {
         ElasticcdcReply reply;
-        reply.set_reply_info(reply_info);
+        reply.set_id(request.id);
+        reply.set_rejected(true);
         request.stream->Write(reply);
+        LOG_INFO("backend draining, reject query: %d", request.id);
         return;
     }
     // 2. if cache miss, transform request into query, push query into recv queue
@@ -104,70 +280,92 @@ void Backend::Exec(const ImageArgs& request) {
     // request_info.data.assign(request.data.begin(), request.data.end());
     // request_info.stream = request.stream;
 
-    // adjust bacth size based on the last latency
-    if (request.cdc_infer_time > 0 && request.backup_infer_time > 0 && request.decode_time != 0 && ifAdjustBatch()) {
-        // assert(request.backup_infer_time > 0);
-        // assert(request.cdc_infer_time > 0);
-        LOG_INFO("backup infer time: %lf, cdc infer time: %lf", request.backup_infer_time, request.cdc_infer_time);
-        LOG_INFO("before ajust: backup batch size: %d, cdc batch size: %d", batch_size_1_, batch_size_2_);
-        if (request.backup_infer_time < request.cdc_infer_time) {
-            if (ifFirstAdjust())
-                forwardBatchSize(conf_->inc_value);
-            else {
-                setAdjustBatch(false);
-            }
-        }
-        else if (request.backup_infer_time >= request.cdc_infer_time) {
-            backwardBatchSize(conf_->dec_value);
-            if (ifFirstAdjust())
-                setFirstAdjust(false);
-        }
-        else {
-            setAdjustBatch(false);
-        }
-        LOG_INFO("after ajust: backup batch size: %d, cdc batch size: %d", batch_size_1_, batch_size_2_);
-    }
 
-    std::vector<uint8_t> data;
-    data.assign(request.data.begin(), request.data.end());
     LOG_INFO("push query: %d to recv queue", request.id);
     auto query = new SingleQuery(request.model_name, 
                                     request.scale, 
                                     request.filename, 
-                                    request.id, data, 
+                                    request.id, std::move(request.data), 
                                     request.encode_type, 
                                     request.stream, 
                                     request.front_id, 
                                     request.end_signal,
                                     request.recompute);
+    query->cache_key_ = std::move(cache_key);
+    query->top_k_ = request.top_k;
+    query->retain_ = request.retain;
+    query->compressed_ = request.compressed;
+    if (request.has_deadline) {
+        // the frontend sends the time left rather than a time point, so the
+        // clocks of the two machines need not agree
+        query->deadline_ = query->arrival_time_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                           std::chrono::duration<double, std::milli>(request.deadline_ms));
+    }
     std::cout << "query->encode_type_:" << query->encode_type_ << std::endl;
     std::cout << "query->end_signal:" << query->end_signal_ << std::endl;
     std::cout << "query->recompute_:" << query->recompute_ << std::endl;
-    if (query->recompute_) {
-        // std::cout << "recompute: push to rep queue" << std::endl;
-        rep_recv_queue_->Push(query);
-        rep_recv_cv_->notify_all();
-    }
-    else if (query->end_signal_) {
-        rep_recv_queue_->Push(query);
-        cdc_recv_queue_->Push(query);
-        rep_recv_cv_->notify_all();
-        cdc_recv_cv_->notify_all();
-    }
-    else if (query->encode_type_ == "Backup") {
-        rep_recv_queue_->Push(query);
-        rep_recv_cv_->notify_all();
-    }
-    else if (query->encode_type_ == "CDC") {
-        // std::cout << "1" << std::endl;
-        // std::cout << req
-        cdc_recv_queue_->Push(query);
-        cdc_recv_cv_->notify_all();
-        // std::cout << "2" << std::endl;
+    if (query->compressed_) {
+        // the image is decoded and resized by the preprocess threads, which
+        // hand the query to the batchers of its model
+        preprocess_queue_->Push(query);
+        return;
     }
+    registry_->Dispatch(query);
     // recv_lock.unlock(); 
     // notify batch_query_thread_(wait for batch queue full)
+}
 
-    // 3. update cache
-    // cache_->put(request.filename, reply_info);
+void Backend::FetchFeatures(const ElasticcdcRequest& request, ElasticcdcReply* reply) {
+    reply->set_id(request.id());
+    std::string feature;
+    for (int64_t id : request.feature_ids()) {
+        if (feature_store_->Take(request.frontend_id(), id, feature)) {
+            auto retained = reply->add_features();
+            retained->set_id(id);
+            retained->set_data(std::move(feature));
+        }
+    }
+    FeatureStore::Stats stats = feature_store_->GetStats();
+    LOG_INFO("fetch features of frontend %d: %d/%d found, retained: %ld, bytes: %ld, expired: %ld, evicted: %ld",
+             request.frontend_id(), reply->features_size(), request.feature_ids_size(),
+             stats.size, stats.bytes, stats.expired, stats.evicted);
+}
+
+void Backend::Drain(const std::string& reason) {
+    bool expected = false;
+    if (!draining_.compare_exchange_strong(expected, true)) {
+        return;
+    }
+    LOG_INFO("Backend drains on %s, the queued batches are rejected in %d ms",
+             reason.c_str(), conf_->drain_timeout_ms);
+    registry_->Drain();
+}
+
+void Backend::watchDrain() {
+    // the notice file stands for the metadata endpoint of the cloud, which
+    // is polled the same way
+    auto poll = std::chrono::milliseconds(conf_->drain_poll_ms);
+    while (!draining_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(drain_mtx_);
+            if (drain_cv_.wait_for(lock, poll, [this] { return stop_drain_; })) {
+                return;
+            }
+        }
+        if (drain_signal.load()) {
+            Drain("SIGTERM");
+        } else if (!conf_->drain_notice_file.empty() && access(conf_->drain_notice_file.c_str(), F_OK) == 0) {
+            Drain("notice file " + conf_->drain_notice_file);
+        }
+    }
+    // the batches still queued by then would not finish before the
+    // instance is reclaimed
+    {
+        std::unique_lock<std::mutex> lock(drain_mtx_);
+        if (drain_cv_.wait_for(lock, std::chrono::milliseconds(conf_->drain_timeout_ms),
+                               [this] { return stop_drain_; })) {
+            return;
+        }
+    }
+    batch_scheduler_->Reject();
 }
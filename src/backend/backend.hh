@@ -3,59 +3,97 @@
 #include "../common/logger.hh"
 #include "../common/conf.hh"
 #include "../common/cache.hh"
+#include "../common/mmap_cache.hh"
 #include "../util/json/json.h"
 #include "image_classify.hh"
 #include "worker.hh"
+#include "model_registry.hh"
+#include "triton_pool.hh"
+#include "torch_engine.hh"
+#include "batch_controller.hh"
+#include "batch_scheduler.hh"
 #include "../common/concurrency_queue.hh"
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 using elasticcdc::ElasticcdcReply;
 using grpc::ServerWriter;
 
+// the query fields of a request, the replies go to 'stream'. The payload is
+// moved out of 'request'.
+ImageArgs MakeImageArgs(ElasticcdcRequest& request, ReplyStream* stream);
+
+// the key of the result of 'data' by 'model_name' in the result cache, a
+// hash of the tensor and its size. The full replies carry the feature map in
+// 'feature_precision', so a disk cache written under another precision
+// misses. The top-k replies are kept apart from the full ones
+std::string ResultCacheKey(const std::string& model_name, const std::string& data,
+                           const std::string& feature_precision, uint32_t top_k = 0);
+
 class Backend {
 public:
     Backend(const std::string& _conf_path);
     ~Backend();
 
     void SetCache(const Json::Value& cache_config);
-    void Exec(const ImageArgs& request);
+    // thread safe, called by every thread receiving requests. The payload
+    // is moved into the query.
+    void Exec(ImageArgs&& request);
+    // the features of request.feature_ids() kept for request.frontend_id(),
+    // thread safe
+    void FetchFeatures(const ElasticcdcRequest& request, ElasticcdcReply* reply);
+    // the backend is about to be preempted: the new queries are rejected,
+    // the batchers send what they hold at once and the batches left after
+    // drain_timeout_ms are rejected. Called on SIGTERM or once the notice
+    // file exists, thread safe
+    void Drain(const std::string& reason);
+
+    const std::shared_ptr<Config>& GetConfig() const { return conf_; }
 
 private:
     std::shared_ptr<Config> conf_;
+    // the replies of the tensors inferred recently, keyed by ResultCacheKey
     std::shared_ptr<BasicCache<std::string, std::string>> cache_;
+    // the feature maps of the RETAIN queries, until they are fetched
+    std::shared_ptr<FeatureStore> feature_store_;
+    // the batches are inferred by one of the two, see Config::engine
+    std::shared_ptr<TritonPool> triton_pool_;
+    std::shared_ptr<TorchEngine> torch_engine_;
 
-    std::shared_ptr<BatchWorker> rep_batch_worker_;
-    std::shared_ptr<BatchWorker> cdc_batch_worker_;
-    std::shared_ptr<InferWorker> infer_worker_;
+    std::shared_ptr<ModelRegistry> registry_;
+    // the compressed queries wait here to be preprocessed
+    std::shared_ptr<SingleQueryQueue> preprocess_queue_;
+    std::shared_ptr<PreprocessWorker> preprocess_worker_;
+    std::vector<std::shared_ptr<InferWorker>> infer_workers_;
     std::shared_ptr<ReplyWorker> reply_worker_;
 
-    std::shared_ptr<SingleQueryQueue> rep_recv_queue_;
-    std::shared_ptr<std::mutex> rep_recv_mutex_;
-    std::shared_ptr<std::condition_variable> rep_recv_cv_;
-
-    std::shared_ptr<SingleQueryQueue> cdc_recv_queue_;
-    std::shared_ptr<std::mutex> cdc_recv_mutex_;
-    std::shared_ptr<std::condition_variable> cdc_recv_cv_;
-    
-    std::shared_ptr<BatchQueryQueue> batch_queue_;
-    std::shared_ptr<std::mutex> batch_mutex_;
-    std::shared_ptr<std::condition_variable> batch_cv_;
+    std::shared_ptr<BatchScheduler> batch_scheduler_;
 
     std::shared_ptr<BatchQueryQueue> infer_queue_;
-    std::shared_ptr<std::mutex> infer_mutex_;
-    std::shared_ptr<std::condition_variable> infer_cv_;
-
-    void forwardBatchSize(int value);
-    void backwardBatchSize(double value);
-    bool ifAdjustBatch();
-    void setAdjustBatch(bool value);
-    bool ifFirstAdjust();
-    void setFirstAdjust(bool value);
-    int batch_size_1_;
-    int batch_size_2_;
-    bool batch_size_adjust;
-    bool first_adjust;
+
+    // only in the auto batch mode
+    std::shared_ptr<BatchController> batch_controller_;
+
+    // infers synthetic batches of every model on every endpoint before the
+    // first query, see Config::warmup_rounds
+    void warmUp();
+    // on the in-process engine when 'session' is null
+    void warmUpSession(TritonSession* session);
+    std::vector<int> warmUpBatchSizes(const ModelEntry& model);
+
+    // waits for the preemption notice, then for the drain timeout, returns
+    // early once the backend is destroyed
+    void watchDrain();
+    std::atomic<bool> draining_;
+    bool stop_drain_;
+    std::mutex drain_mtx_;
+    std::condition_variable drain_cv_;
+    std::thread drain_thread_;
 
 };
\ No newline at end of file
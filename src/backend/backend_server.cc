@@ -16,96 +16,79 @@
 #include "image_classify.hh"
 #include "../common/logger.hh"
 #include "backend.hh"
-
-using RequestQueue = std::queue<std::pair<ElasticcdcRequest, grpcStream*>>;
-
-RequestQueue requestQueue;
-std::mutex queueMutex;
-std::condition_variable queueCV;
-
-std::mutex m;
-
-void processRequests(const std::string conf_path) {
-    auto backend_ = std::make_shared<Backend>(conf_path);
-    while(true) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        queueCV.wait(lock, [] { return !requestQueue.empty(); });
-
-        auto [request, stream] = requestQueue.front();
-        LOG_INFO("pop request %ld from the requestQueue", request.id());
-        requestQueue.pop();
-        lock.unlock();
-
-        // send reply
-        ImageArgs request_info;
-        request_info.filename = request.filename();
-        request_info.model_name = request.model_name();
-        request_info.id = request.id();
-        request_info.scale = request.scale();
-        request_info.data = request.data();
-        request_info.stream = stream;
-        request_info.cdc_infer_time = request.cdc_infer_time();
-        request_info.backup_infer_time = request.backup_infer_time();
-        request_info.decode_time = request.decode_time();
-        request_info.encode_type = request.encode_type();
-        request_info.front_id = request.frontend_id();
-        request_info.end_signal = request.end_signal();
-        request_info.recompute = request.recompute();
-        // std::string reply_info;
-        // std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        backend_->Exec(request_info);
-    }
-}
+#include "async_server.hh"
 
 class ElasticcdcServiceImpl final : public ElasticcdcService::Service {
 public:
-    ElasticcdcServiceImpl(const std::string conf_path) : ElasticcdcService::Service() {
+    ElasticcdcServiceImpl(std::shared_ptr<Backend> backend) : ElasticcdcService::Service(), backend_(backend) {
         LOG_INFO("init ElasticcdcService done");
     }
 
     Status DataTransStream(ServerContext* context, grpcStream* stream) override {
         
         // std::string prefix("ImageClassify ");
+        // the requests of the stream are pushed to the batchers by this
+        // grpc thread, the reply stream is not freed as queries of the
+        // stream may still be in the pipeline when it ends
+        SyncReplyStream* reply_stream = new SyncReplyStream(stream);
         ElasticcdcRequest request;
         while(stream->Read(&request) ) 
         {
             LOG_INFO("ElasticcdcService receive rpc DataTransStream, id: %ld, filename: %s, scale: %s, modle name: %s, data size: %ld",
                          request.id(), request.filename().c_str(), request.scale().c_str(), request.model_name().c_str(), request.data().size());
-            std::lock_guard<std::mutex> lock(queueMutex);
-            requestQueue.emplace(request, stream);
-
-            queueCV.notify_one();
+            backend_->Exec(MakeImageArgs(request, reply_stream));
         }
         
         // need to wait for the procession completed
         return Status::OK;
     }
 
+    Status FetchFeatures(ServerContext* context, const ElasticcdcRequest* request, ElasticcdcReply* reply) override {
+        backend_->FetchFeatures(*request, reply);
+        return Status::OK;
+    }
+
+private:
+    std::shared_ptr<Backend> backend_;
 };
 
+// the time since 'start' in ms. From the start of RunServer until the
+// server listens is the time to ready, the models are warmed up by then
+static double ReadyMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+           (std::chrono::steady_clock::now() - start).count();
+}
+
 void RunServer(const std::string conf_path) {
+    auto start = std::chrono::steady_clock::now();
     std::string server_address("0.0.0.0:50051");
-    ElasticcdcServiceImpl service(conf_path);
+    auto backend = std::make_shared<Backend>(conf_path);
+    const auto& conf = backend->GetConfig();
   
     grpc::EnableDefaultHealthCheckService(true);
     grpc::reflection::InitProtoReflectionServerBuilderPlugin();
     ServerBuilder builder;
     // Listen on the given address without any authentication mechanism.
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
-    // Register "service" as the instance through which we'll communicate with
-    // clients. In this case it corresponds to an *synchronous* service.
-    builder.RegisterService(&service);
-    // Finally assemble the server.
-    std::unique_ptr<Server> server(builder.BuildAndStart());
-    std::cout << "Server listening on " << server_address << std::endl;
 
-    // start a processRequest thread
-    std::thread processor(processRequests, conf_path);
-  
-    // Wait for the server to shutdown. Note that some other thread must be
-    // responsible for shutting down the server for this call to ever return.
-    server->Wait();
-    processor.join();
+    if (conf->server_mode == "sync") {
+        // one grpc thread per stream
+        ElasticcdcServiceImpl service(backend);
+        builder.RegisterService(&service);
+        std::unique_ptr<Server> server(builder.BuildAndStart());
+        std::cout << "Server listening on " << server_address << " (sync), ready in " << ReadyMs(start) << " ms" << std::endl;
+        // Wait for the server to shutdown. Note that some other thread must be
+        // responsible for shutting down the server for this call to ever return.
+        server->Wait();
+    } else {
+        // the streams are served by cq_threads polling threads
+        AsyncBackendServer async_server(backend, conf->cq_threads);
+        async_server.Register(builder);
+        std::unique_ptr<Server> server(builder.BuildAndStart());
+        std::cout << "Server listening on " << server_address << " (async, " << conf->cq_threads << " threads), ready in "
+                  << ReadyMs(start) << " ms" << std::endl;
+        async_server.Run();
+    }
 }
 
 void usage() {
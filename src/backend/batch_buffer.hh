@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "../common/mpmc_queue.hh"
+
+class BatchBufferPool;
+
+/**
+ * The input tensor of one batch, the samples back to back as triton expects
+ * them. It is filled once by the BatchWorker and handed to triton with a
+ * single AppendRaw, then given back to its pool with the outputs.
+ */
+struct BatchBuffer {
+    BatchBufferPool* pool_;
+    std::unique_ptr<uint8_t[]> data_;
+    size_t capacity_;
+    size_t size_;
+
+    void Append(const void* sample, size_t sample_size) {
+        memcpy(data_.get() + size_, sample, sample_size);
+        size_ += sample_size;
+    }
+    const uint8_t* Data() const { return data_.get(); }
+    size_t Size() const { return size_; }
+};
+
+/**
+ * Reuses the batch buffers of a BatchWorker, so that a batch costs no
+ * allocation once the pipeline is warm. A buffer is only reallocated when a
+ * batch does not fit, and is then sized for the largest batch seen.
+ */
+class BatchBufferPool {
+public:
+    explicit BatchBufferPool(size_t max_free = 64) : free_(max_free), allocations_(0) {}
+
+    ~BatchBufferPool() {
+        BatchBuffer* buffer;
+        while (free_.TryPop(buffer)) {
+            delete buffer;
+        }
+    }
+
+    // returns an empty buffer that holds at least 'capacity' bytes
+    BatchBuffer* Acquire(size_t capacity) {
+        BatchBuffer* buffer;
+        if (!free_.TryPop(buffer)) {
+            buffer = new BatchBuffer{this, nullptr, 0, 0};
+        }
+        if (buffer->capacity_ < capacity) {
+            buffer->data_.reset(new uint8_t[capacity]);
+            buffer->capacity_ = capacity;
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        buffer->size_ = 0;
+        return buffer;
+    }
+
+    void Release(BatchBuffer* buffer) {
+        if (!free_.TryPush(buffer)) {
+            delete buffer;
+        }
+    }
+
+    // the buffers allocated or grown so far
+    uint64_t Allocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+private:
+    MpmcQueue<BatchBuffer*> free_;
+    std::atomic<uint64_t> allocations_;
+};
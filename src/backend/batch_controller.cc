@@ -0,0 +1,179 @@
+#include "batch_controller.hh"
+#include "model_registry.hh"
+#include "worker.hh"
+#include <algorithm>
+#include <limits>
+
+/**
+ * LatencyProfile
+ *
+ */
+LatencyProfile::LatencyProfile(size_t max_batch_size, double alpha):
+                               points_(std::max<size_t>(max_batch_size, 1), Point{0, 0}),
+                               alpha_(alpha),
+                               batch_num_(0)
+{
+}
+
+void LatencyProfile::Record(int batch_size, double latency_ms) {
+    if (batch_size < 1) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (size_t(batch_size) > points_.size()) {
+        points_.resize(batch_size, Point{0, 0});
+    }
+    Point& point = points_[batch_size - 1];
+    if (point.count_ == 0) {
+        point.latency_ms_ = latency_ms;
+    } else {
+        point.latency_ms_ = alpha_ * latency_ms + (1 - alpha_) * point.latency_ms_;
+    }
+    point.count_++;
+    batch_num_++;
+}
+
+double LatencyProfile::Predict(int batch_size) {
+    // a size is trusted on its own once it has been seen this many times
+    const uint64_t min_samples = 3;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (batch_num_ == 0) {
+        return 0;
+    }
+    batch_size = std::max(batch_size, 1);
+    if (size_t(batch_size) <= points_.size() && points_[batch_size - 1].count_ >= min_samples) {
+        return points_[batch_size - 1].latency_ms_;
+    }
+
+    // least squares over the sizes seen, the well measured ones weigh more
+    double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int sizes = 0;
+    double x0 = 0, y0 = 0;
+    for (size_t i = 0; i < points_.size(); i++) {
+        if (points_[i].count_ == 0) {
+            continue;
+        }
+        double w = std::min<uint64_t>(points_[i].count_, 10);
+        double x = i + 1;
+        double y = points_[i].latency_ms_;
+        sw += w;
+        sx += w * x;
+        sy += w * y;
+        sxx += w * x * x;
+        sxy += w * x * y;
+        sizes++;
+        x0 = x;
+        y0 = y;
+    }
+    if (sizes == 1) {
+        // with a single size the fixed cost is unknown, assuming the latency
+        // grows in proportion to the batch size errs on the small side
+        return y0 * batch_size / x0;
+    }
+    double slope = (sw * sxy - sx * sy) / (sw * sxx - sx * sx);
+    slope = std::max(slope, 0.0);
+    double intercept = std::max((sy - slope * sx) / sw, 0.0);
+    return intercept + slope * batch_size;
+}
+
+uint64_t LatencyProfile::BatchNum() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return batch_num_;
+}
+
+/**
+ * BatchController
+ *
+ */
+BatchController::BatchController(std::shared_ptr<Config> conf, std::shared_ptr<ModelRegistry> registry):
+                                 conf_(conf),
+                                 registry_(registry),
+                                 max_batch_size_(std::max<int>(conf->max_batch_size, 1)),
+                                 interval_(std::max<uint32_t>(conf->adjust_interval_ms, 1)),
+                                 stop_(false)
+{
+    for (const auto& model_name : registry_->ModelNames()) {
+        ModelEntry* entry = registry_->Get(model_name);
+        // triton refuses batches over the max_batch_size of the model
+        max_batch_size_ = std::min(max_batch_size_, std::max(entry->max_batch_size_, 1));
+        Lane backup{model_name + "/backup", entry->rep_batch_worker_.get(), entry->profile_,
+                    conf_->latency_slo_ms_1, entry->max_queue_delay_us_ / 1000.0,
+                    entry->batch_size_1_, 0, 0};
+        Lane cdc{model_name + "/cdc", entry->cdc_batch_worker_.get(), entry->profile_,
+                 conf_->latency_slo_ms_2, entry->max_queue_delay_us_ / 1000.0,
+                 entry->batch_size_2_, 0, 0};
+        lanes_.push_back(backup);
+        lanes_.push_back(cdc);
+    }
+    LOG_INFO("BatchController adjusting %ld batchers every %ld ms, max batch size: %d, backup slo: %lf ms, cdc slo: %lf ms",
+             lanes_.size(), interval_.count(), max_batch_size_, conf_->latency_slo_ms_1, conf_->latency_slo_ms_2);
+    controller_thread_ = std::thread(&BatchController::run, this);
+}
+
+BatchController::~BatchController() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    controller_thread_.join();
+}
+
+void BatchController::run() {
+    auto last = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            if (cv_.wait_for(lock, interval_, [this] { return stop_; })) {
+                return;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        double elapsed_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(now - last).count();
+        last = now;
+        for (auto& lane : lanes_) {
+            adjust(lane, elapsed_ms);
+        }
+    }
+}
+
+void BatchController::adjust(Lane& lane, double elapsed_ms) {
+    // the queries that left the batcher, the same as the arrivals as long
+    // as it keeps up
+    uint64_t query_num = lane.worker_->QueryNum();
+    double rate = (query_num - lane.last_query_num_) / elapsed_ms;
+    lane.last_query_num_ = query_num;
+    lane.rate_ = lane.rate_ == 0 ? rate : 0.5 * rate + 0.5 * lane.rate_;
+
+    int batch_size = chooseBatchSize(lane);
+    // grow step by step, so that the sizes on the way are measured before
+    // they are relied on, shrink at once
+    batch_size = std::min(batch_size, std::max(lane.batch_size_, 1) * 2);
+    if (batch_size == lane.batch_size_) {
+        return;
+    }
+    LOG_INFO("BatchController %s: arrival rate: %lf queries/ms, batch size: %d -> %d, expected latency: %lf ms",
+             lane.name_.c_str(), lane.rate_, lane.batch_size_, batch_size, lane.profile_->Predict(batch_size));
+    lane.batch_size_ = batch_size;
+    lane.worker_->setBatchSize(batch_size);
+}
+
+int BatchController::chooseBatchSize(const Lane& lane) {
+    if (lane.profile_->BatchNum() == 0) {
+        return lane.batch_size_;
+    }
+    int best = 1;
+    for (int batch_size = 1; batch_size <= max_batch_size_; batch_size++) {
+        // the first query of a batch waits for the others to arrive, unless
+        // the queue delay sends the batch before
+        double fill_ms = lane.rate_ > 0 ? (batch_size - 1) / lane.rate_
+                                        : (batch_size > 1 ? std::numeric_limits<double>::infinity() : 0);
+        if (lane.max_queue_delay_ms_ > 0) {
+            fill_ms = std::min(fill_ms, lane.max_queue_delay_ms_);
+        }
+        if (fill_ms + lane.profile_->Predict(batch_size) <= lane.slo_ms_) {
+            best = batch_size;
+        }
+    }
+    return best;
+}
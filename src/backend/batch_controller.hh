@@ -0,0 +1,85 @@
+#pragma once
+#include "../common/logger.hh"
+#include "../common/conf.hh"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ModelRegistry;
+class BatchWorker;
+
+/**
+ * LatencyProfile
+ * The triton latency of one model against the batch size, learnt from the
+ * batches it served. Every batch size keeps a moving average, and a line
+ * fitted over them predicts the sizes that were not tried yet.
+ */
+class LatencyProfile {
+public:
+    LatencyProfile(size_t max_batch_size, double alpha = 0.2);
+
+    // called by the InferWorkers when a batch comes back
+    void Record(int batch_size, double latency_ms);
+    // the expected latency of a batch of 'batch_size', 0 before the first
+    // batch
+    double Predict(int batch_size);
+    uint64_t BatchNum();
+
+private:
+    struct Point {
+        double latency_ms_;
+        uint64_t count_;
+    };
+    std::vector<Point> points_;
+    double alpha_;
+    uint64_t batch_num_;
+    std::mutex mtx_;
+};
+
+/**
+ * BatchController
+ * Sets the batch sizes of the backup and the CDC batchers of every model.
+ * The latency of a query is the time its batch takes to fill at the current
+ * arrival rate, bounded by the queue delay, plus the triton latency of the
+ * batch. The controller picks the largest batch size whose latency stays
+ * within the SLO of the lane, and does it again every interval so that it
+ * follows the load.
+ */
+class BatchController {
+public:
+    BatchController(std::shared_ptr<Config> conf, std::shared_ptr<ModelRegistry> registry);
+    ~BatchController();
+
+private:
+    // the state of one batcher
+    struct Lane {
+        std::string name_;
+        BatchWorker* worker_;
+        std::shared_ptr<LatencyProfile> profile_;
+        double slo_ms_;
+        double max_queue_delay_ms_;
+        int batch_size_;
+        uint64_t last_query_num_;
+        // moving average of the arrival rate, queries per ms
+        double rate_;
+    };
+
+    void run();
+    void adjust(Lane& lane, double elapsed_ms);
+    int chooseBatchSize(const Lane& lane);
+
+    std::shared_ptr<Config> conf_;
+    std::shared_ptr<ModelRegistry> registry_;
+    std::vector<Lane> lanes_;
+    // the smaller of max_batch_size and that of the served models
+    int max_batch_size_;
+    std::chrono::milliseconds interval_;
+
+    bool stop_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread controller_thread_;
+};
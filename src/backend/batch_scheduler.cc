@@ -0,0 +1,187 @@
+#include "batch_scheduler.hh"
+
+const char* BatchClassName(int batch_class) {
+    switch (batch_class) {
+    case RECOMPUTE_BATCH:
+        return "recompute";
+    case BACKUP_BATCH:
+        return "backup";
+    case CDC_BATCH:
+        return "cdc";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * BatchScheduler
+ *
+ */
+BatchScheduler::BatchScheduler(std::shared_ptr<Config> conf, const std::vector<std::string>& model_names):
+                               size_(0),
+                               rejecting_(false)
+{
+    if (conf->scheduler_policy == "weighted") {
+        policy_ = WEIGHTED;
+    } else if (conf->scheduler_policy == "edf") {
+        policy_ = EDF;
+    } else {
+        policy_ = FIFO;
+    }
+    for (size_t i = 0; i < model_names.size(); i++) {
+        model_index_[model_names[i]] = i;
+    }
+    int weights[BATCH_CLASS_NUM] = {int(conf->recompute_weight), int(conf->backup_weight), int(conf->cdc_weight)};
+    for (int c = 0; c < BATCH_CLASS_NUM; c++) {
+        classes_[c].models_.resize(std::max<size_t>(model_names.size(), 1));
+        classes_[c].next_model_ = 0;
+        classes_[c].size_ = 0;
+        classes_[c].weight_ = std::max(weights[c], 1);
+        classes_[c].current_ = 0;
+        stats_[c] = BatchClassStat{0, 0, 0, 0};
+    }
+    LOG_INFO("BatchScheduler policy: %s, recompute first, weights backup: %d, cdc: %d",
+             conf->scheduler_policy.c_str(), classes_[BACKUP_BATCH].weight_, classes_[CDC_BATCH].weight_);
+}
+
+BatchScheduler::~BatchScheduler() {}
+
+int BatchScheduler::classOf(const BatchQuery* batch_query) {
+    if (batch_query->recompute_) {
+        return RECOMPUTE_BATCH;
+    }
+    if (batch_query->encode_type_ == "CDC") {
+        return CDC_BATCH;
+    }
+    return BACKUP_BATCH;
+}
+
+void BatchScheduler::Push(BatchQuery* batch_query) {
+    size_t model = 0;
+    auto it = model_index_.find(batch_query->model_name_);
+    if (it != model_index_.end()) {
+        model = it->second;
+    }
+    int batch_class = classOf(batch_query);
+    batch_query->enqueue_time_ = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        classes_[batch_class].models_[model].push_back(batch_query);
+        classes_[batch_class].size_++;
+        size_++;
+    }
+    LOG_INFO("push query: %d to batch scheduler, class: %s", batch_query->id_, BatchClassName(batch_class));
+    cv_.notify_one();
+}
+
+BatchQuery* BatchScheduler::Pop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return size_ > 0; });
+    BatchQuery* batch_query = popLocked();
+    batch_query->rejected_ = rejecting_;
+
+    auto now = std::chrono::steady_clock::now();
+    int batch_class = classOf(batch_query);
+    double delay = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                   (now - batch_query->enqueue_time_).count();
+    BatchClassStat& stat = stats_[batch_class];
+    stat.batch_num_++;
+    stat.delay_ms_sum_ += delay;
+    stat.delay_ms_max_ = std::max(stat.delay_ms_max_, delay);
+    if (batch_query->deadline_ < now) {
+        stat.late_num_++;
+    }
+    LOG_INFO("BatchScheduler pop query: %d, class: %s, queue delay: %lf ms, avg queue delay: %lf ms, max queue delay: %lf ms, late batches: %ld/%ld",
+             batch_query->id_, BatchClassName(batch_class), delay, stat.delay_ms_sum_ / stat.batch_num_,
+             stat.delay_ms_max_, stat.late_num_, stat.batch_num_);
+    return batch_query;
+}
+
+void BatchScheduler::Reject() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    rejecting_ = true;
+    LOG_INFO("BatchScheduler rejects the batches from now on, queued: %ld", size_);
+}
+
+std::vector<BatchClassStat> BatchScheduler::Stats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return std::vector<BatchClassStat>(stats_, stats_ + BATCH_CLASS_NUM);
+}
+
+BatchQuery* BatchScheduler::popModel(ClassQueue& queue, size_t model) {
+    BatchQuery* batch_query = queue.models_[model].front();
+    queue.models_[model].pop_front();
+    queue.size_--;
+    size_--;
+    return batch_query;
+}
+
+BatchQuery* BatchScheduler::popClass(ClassQueue& queue) {
+    for (size_t i = 0; i < queue.models_.size(); i++) {
+        size_t model = (queue.next_model_ + i) % queue.models_.size();
+        if (!queue.models_[model].empty()) {
+            queue.next_model_ = model + 1;
+            return popModel(queue, model);
+        }
+    }
+    return nullptr;
+}
+
+BatchQuery* BatchScheduler::popLocked() {
+    if (classes_[RECOMPUTE_BATCH].size_ > 0) {
+        return popClass(classes_[RECOMPUTE_BATCH]);
+    }
+    if (policy_ == WEIGHTED) {
+        // every class with a batch earns its weight, the richest one is
+        // served and pays the total back
+        int total = 0;
+        ClassQueue* best = nullptr;
+        for (auto& queue : classes_) {
+            if (queue.size_ == 0) {
+                continue;
+            }
+            queue.current_ += queue.weight_;
+            total += queue.weight_;
+            if (best == nullptr || queue.current_ > best->current_) {
+                best = &queue;
+            }
+        }
+        best->current_ -= total;
+        return popClass(*best);
+    }
+
+    // fifo and edf look at every queued batch, there are only a few
+    ClassQueue* best_queue = nullptr;
+    size_t best_model = 0;
+    size_t best_pos = 0;
+    BatchQuery* best = nullptr;
+    for (auto& queue : classes_) {
+        for (size_t model = 0; model < queue.models_.size(); model++) {
+            auto& batches = queue.models_[model];
+            for (size_t pos = 0; pos < batches.size(); pos++) {
+                BatchQuery* batch_query = batches[pos];
+                bool better = best == nullptr;
+                if (!better && policy_ == EDF && batch_query->deadline_ != best->deadline_) {
+                    better = batch_query->deadline_ < best->deadline_;
+                } else if (!better) {
+                    better = batch_query->enqueue_time_ < best->enqueue_time_;
+                }
+                if (better) {
+                    best = batch_query;
+                    best_queue = &queue;
+                    best_model = model;
+                    best_pos = pos;
+                }
+                if (policy_ == FIFO) {
+                    // the oldest batch of a queue is at its front
+                    break;
+                }
+            }
+        }
+    }
+    auto& batches = best_queue->models_[best_model];
+    batches.erase(batches.begin() + best_pos);
+    best_queue->size_--;
+    size_--;
+    return best;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "../common/logger.hh"
+#include "../common/conf.hh"
+#include "worker.hh"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum BatchClass {
+    RECOMPUTE_BATCH = 0,
+    BACKUP_BATCH,
+    CDC_BATCH,
+    BATCH_CLASS_NUM
+};
+
+const char* BatchClassName(int batch_class);
+
+/**
+ * BatchClassStat
+ * The time the batches of a class spent in the scheduler.
+ */
+struct BatchClassStat {
+    uint64_t batch_num_;
+    double delay_ms_sum_;
+    double delay_ms_max_;
+    // batches sent to triton after their deadline
+    uint64_t late_num_;
+};
+
+/**
+ * BatchScheduler
+ * Sits between the BatchWorkers of all the models and the InferWorkers, and
+ * decides which ready batch is served next. The recompute batches come
+ * first, their stripes are broken already, then under the policy:
+ *  - fifo: in the order the batches were made
+ *  - weighted: the backup and CDC batches share the InferWorkers in
+ *    proportion to their weights (smooth weighted round robin)
+ *  - edf: the batch with the earliest deadline first, the batches without a
+ *    deadline come after, in order
+ * Within a class the models are served in turn.
+ */
+class BatchScheduler {
+public:
+    BatchScheduler(std::shared_ptr<Config> conf, const std::vector<std::string>& model_names);
+    ~BatchScheduler();
+
+    void Push(BatchQuery* batch_query);
+    // waits for a batch
+    BatchQuery* Pop();
+    // the batches popped from now on are marked rejected_, called when a
+    // draining backend runs out of time
+    void Reject();
+
+    std::vector<BatchClassStat> Stats();
+
+private:
+    enum Policy {
+        FIFO,
+        WEIGHTED,
+        EDF
+    };
+
+    struct ClassQueue {
+        // one queue per model
+        std::vector<std::deque<BatchQuery*>> models_;
+        size_t next_model_;
+        size_t size_;
+        int weight_;
+        int current_;
+    };
+
+    static int classOf(const BatchQuery* batch_query);
+    // called with mtx_ held and a batch queued
+    BatchQuery* popLocked();
+    BatchQuery* popModel(ClassQueue& queue, size_t model);
+    // the next model in turn with a batch, the queue must hold one
+    BatchQuery* popClass(ClassQueue& queue);
+
+    Policy policy_;
+    std::unordered_map<std::string, size_t> model_index_;
+    ClassQueue classes_[BATCH_CLASS_NUM];
+    BatchClassStat stats_[BATCH_CLASS_NUM];
+    size_t size_;
+    bool rejecting_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
@@ -0,0 +1,77 @@
+#include "feature_store.hh"
+
+/**
+ * FeatureStore
+ *
+ */
+FeatureStore::FeatureStore(uint32_t ttl_ms, uint64_t capacity_bytes):
+                           ttl_(std::chrono::milliseconds(ttl_ms)),
+                           capacity_bytes_(capacity_bytes),
+                           next_seq_(1)
+{
+    LOG_INFO("FeatureStore created, ttl: %d ms, capacity: %ld bytes", ttl_ms, capacity_bytes_);
+}
+
+void FeatureStore::Put(uint32_t front_id, int64_t id, std::string&& feature) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t k = key(front_id, id);
+    uint64_t seq = next_seq_++;
+    auto it = entries_.find(k);
+    if (it != entries_.end()) {
+        // a recompute of the query, its previous order is skipped
+        stats_.bytes -= it->second.feature_.size();
+        it->second.feature_ = std::move(feature);
+        it->second.seq_ = seq;
+        stats_.bytes += it->second.feature_.size();
+    } else {
+        stats_.bytes += feature.size();
+        entries_.emplace(k, Entry{std::move(feature), seq});
+    }
+    order_.push_back(Order{now + ttl_, k, seq});
+    stats_.put++;
+    expireLocked(now);
+}
+
+bool FeatureStore::Take(uint32_t front_id, int64_t id, std::string& feature) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expireLocked(Clock::now());
+    auto it = entries_.find(key(front_id, id));
+    if (it == entries_.end()) {
+        stats_.miss++;
+        return false;
+    }
+    feature = std::move(it->second.feature_);
+    stats_.bytes -= feature.size();
+    entries_.erase(it);
+    stats_.hit++;
+    return true;
+}
+
+void FeatureStore::expireLocked(Clock::time_point now) {
+    while (!order_.empty()) {
+        const Order& oldest = order_.front();
+        auto it = entries_.find(oldest.key_);
+        if (it == entries_.end() || it->second.seq_ != oldest.seq_) {
+            order_.pop_front();
+            continue;
+        }
+        if (oldest.expiry_ <= now) {
+            stats_.expired++;
+        } else if (stats_.bytes > capacity_bytes_) {
+            stats_.evicted++;
+        } else {
+            break;
+        }
+        stats_.bytes -= it->second.feature_.size();
+        entries_.erase(it);
+        order_.pop_front();
+    }
+}
+
+FeatureStore::Stats FeatureStore::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.size = entries_.size();
+    return stats;
+}
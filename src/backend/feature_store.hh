@@ -0,0 +1,69 @@
+#pragma once
+#include "../common/logger.hh"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * FeatureStore
+ * The feature maps of the RETAIN queries, kept until the frontend fetches
+ * them for a decode. Most stripes are never decoded, so an entry lives
+ * ttl_ms at most and the oldest entries are dropped first once the store
+ * holds more than capacity_bytes. A fetched entry is dropped, a stripe is
+ * decoded once.
+ */
+class FeatureStore {
+public:
+    FeatureStore(uint32_t ttl_ms, uint64_t capacity_bytes);
+
+    // 'feature' is encoded as in the FULL replies
+    void Put(uint32_t front_id, int64_t id, std::string&& feature);
+    // false if the feature expired, was dropped or was never stored
+    bool Take(uint32_t front_id, int64_t id, std::string& feature);
+
+    struct Stats {
+        uint64_t put = 0;
+        uint64_t hit = 0;
+        uint64_t miss = 0;
+        uint64_t expired = 0;
+        uint64_t evicted = 0;
+        uint64_t size = 0;
+        uint64_t bytes = 0;
+    };
+    Stats GetStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string feature_;
+        uint64_t seq_;
+    };
+
+    struct Order {
+        Clock::time_point expiry_;
+        uint64_t key_;
+        uint64_t seq_;
+    };
+
+    // the query ids are only unique per frontend
+    static uint64_t key(uint32_t front_id, int64_t id) {
+        return uint64_t(front_id) << 32 | uint32_t(id);
+    }
+    // called with mutex_ held
+    void expireLocked(Clock::time_point now);
+
+    Clock::duration ttl_;
+    uint64_t capacity_bytes_;
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    // the puts in time order, an order whose seq_ differs from the one of
+    // its entry was superseded or taken
+    std::deque<Order> order_;
+    uint64_t next_seq_;
+    Stats stats_;
+};
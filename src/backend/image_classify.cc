@@ -530,6 +530,7 @@ ParseModelGrpc(
   for (auto output_metadata : model_metadata.outputs()) {
     bool output_batch_dim = (model_info->max_batch_size_ > 0);
     size_t non_one_cnt = 0;
+    size_t output_byte_size = sizeof(float);
     for (const auto dim : output_metadata.shape()) {
       if (output_batch_dim) {
         output_batch_dim = false;
@@ -537,7 +538,9 @@ ParseModelGrpc(
         std::cerr << "variable-size dimension in model output not supported"
                   << std::endl;
         exit(1);
-      } 
+      } else {
+        output_byte_size *= dim;
+      }
       // else if (dim > 1) {
       //   non_one_cnt += 1;
       //   if (non_one_cnt > 1) {
@@ -546,6 +549,7 @@ ParseModelGrpc(
       //   }
       // }
     }
+    model_info->output_byte_sizes_.push_back(output_byte_size);
   }
   
 
@@ -601,6 +605,8 @@ ParseModelGrpc(
               << "' for model \"" << model_metadata.name() << std::endl;
     exit(1);
   }
+  model_info->input_byte_size_ = model_info->input_c_ * model_info->input_h_ *
+                                 model_info->input_w_ * CV_ELEM_SIZE(model_info->type1_);
 }
 
 
@@ -636,202 +642,121 @@ FileToInputData(
 }  // namespace
 
 
-
-int
-ImageClassify(BatchQuery& batchq, std::vector<std::string>& res)
+/**
+ * TritonSession
+ * 
+ */
+TritonSession::TritonSession(const std::string& url, size_t topk, bool verbose)
+    : url_(url), model_version_(""), topk_(topk), verbose_(verbose)
 {
-  bool verbose = false;
-  bool async = false;
-  bool streaming = false;
-  int batch_size = batchq.batch_size_;
-  int topk = 10;
-  ScaleType scale = ParseScale(batchq.scale_);
-  std::string preprocess_output_filename;
-  std::string model_name = batchq.model_name_;
-  std::string model_version = "";
-  // std::string url("localhost:8000");
-  // ProtocolType protocol = ProtocolType::HTTP;
-  ProtocolType protocol = ProtocolType::GRPC;
-  std::string url("localhost:8001");
-  tc::Headers http_headers;
+  // Create the inference client for the server once, it is reused by all
+  // the batches sent from this backend.
+  tc::Error err = tc::InferenceServerGrpcClient::Create(&client_, url_, verbose_);
+  if (!err.IsOk()) {
+    std::cerr << "error: unable to create client for inference: " << err
+              << std::endl;
+    exit(1);
+  }
+  LOG_INFO("Triton session created, url: %s", url_.c_str());
+}
 
-  static struct option long_options[] = {{"streaming", 0, 0, 0}, {0, 0, 0, 0}};
-
-  // Parse commandline...
-  // int opt;
-  // while ((opt = getopt_long(
-  //             argc, argv, "vau:m:x:b:c:s:p:i:H:", long_options, NULL)) != -1) {
-  //   switch (opt) {
-  //     case 0:
-  //       streaming = true;
-  //       break;
-  //     case 'v':
-  //       verbose = true;
-  //       break;
-  //     case 'a':
-  //       async = true;
-  //       break;
-  //     case 'u':
-  //       url = optarg;
-  //       break;
-  //     case 'm':
-  //       model_name = optarg;
-  //       break;
-  //     case 'x':
-  //       model_version = optarg;
-  //       break;
-  //     case 'b':
-  //       batch_size = std::atoi(optarg);
-  //       break;
-  //     case 'c':
-  //       topk = std::atoi(optarg);
-  //       break;
-  //     case 's':
-  //       scale = ParseScale(optarg);
-  //       break;
-  //     case 'p':
-  //       preprocess_output_filename = optarg;
-  //       break;
-  //     case 'i':
-  //       protocol = ParseProtocol(optarg);
-  //       break;
-  //     case 'H': {
-  //       std::string arg = optarg;
-  //       std::string header = arg.substr(0, arg.find(":"));
-  //       http_headers[header] = arg.substr(header.size() + 1);
-  //       break;
-  //     }
-  //   }
-  // }
+TritonSession::~TritonSession()
+{
+  for (const auto& region : shm_regions_) {
+    client_->UnregisterSystemSharedMemory(region);
+  }
+}
 
+TritonModel*
+TritonSession::GetModel(const std::string& model_name)
+{
+  std::lock_guard<std::mutex> lock(models_mutex_);
+  auto it = models_.find(model_name);
+  if (it != models_.end()) {
+    return it->second.get();
+  }
+  auto model = LoadModel(model_name);
+  auto model_ptr = model.get();
+  models_.emplace(model_name, std::move(model));
+  return model_ptr;
+}
 
-  // Create the inference client for the server. From it
-  // extract and validate that the model meets the requirements for
-  // image classification.
-  TritonClient triton_client;
-  tc::Error err;
-  if (protocol == ProtocolType::HTTP) {
-    err = tc::InferenceServerHttpClient::Create(
-        &triton_client.http_client_, url, verbose);
-  } 
-  else {
-    err = tc::InferenceServerGrpcClient::Create(
-        &triton_client.grpc_client_, url, verbose);
+std::shared_ptr<ShmRing>
+TritonSession::CreateSharedMemory(const std::string& model_name, size_t slot_num)
+{
+  TritonModel* model = GetModel(model_name);
+  const ModelInfo& model_info = model->info_;
+  size_t max_batch_size = std::max(model_info.max_batch_size_, 1);
+  size_t output_size = 0;
+  if (model->output_ptrs_.size() > 1) {
+    output_size = model_info.output_byte_sizes_[1];
   }
+  return std::make_shared<ShmRing>(
+      model_name, slot_num, max_batch_size, model_info.input_byte_size_,
+      output_size);
+}
+
+void
+TritonSession::RegisterSharedMemory(const std::string& model_name, std::shared_ptr<ShmRing> ring)
+{
+  TritonModel* model = GetModel(model_name);
+
+  // The regions are registered once, every batch then only refers to the
+  // offset of its slot.
+  std::lock_guard<std::mutex> lock(client_mutex_);
+  tc::Error err = client_->RegisterSystemSharedMemory(
+      ring->InputRegion(), ring->InputKey(), ring->InputRegionSize());
   if (!err.IsOk()) {
-    std::cerr << "error: unable to create client for inference: " << err
-              << std::endl;
+    std::cerr << "error: unable to register shared memory input region: "
+              << err << std::endl;
     exit(1);
   }
-
-  ModelInfo model_info;
-  if (protocol == ProtocolType::HTTP) {
-    std::string model_metadata;
-    err = triton_client.http_client_->ModelMetadata(
-        &model_metadata, model_name, model_version, http_headers);
-    if (!err.IsOk()) {
-      std::cerr << "error: failed to get model metadata: " << err << std::endl;
-    }
-    rapidjson::Document model_metadata_json;
-    err = tc::ParseJson(&model_metadata_json, model_metadata);
-    if (!err.IsOk()) {
-      std::cerr << "error: failed to parse model metadata: " << err
-                << std::endl;
-    }
-    std::string model_config;
-    err = triton_client.http_client_->ModelConfig(
-        &model_config, model_name, model_version, http_headers);
-    if (!err.IsOk()) {
-      std::cerr << "error: failed to get model config: " << err << std::endl;
-    }
-    rapidjson::Document model_config_json;
-    err = tc::ParseJson(&model_config_json, model_config);
-    if (!err.IsOk()) {
-      std::cerr << "error: failed to parse model config: " << err << std::endl;
-    }
-    ParseModelHttp(
-        model_metadata_json, model_config_json, batch_size, &model_info);
-  } 
-  else {
-    inference::ModelMetadataResponse model_metadata;
-    err = triton_client.grpc_client_->ModelMetadata(
-        &model_metadata, model_name, model_version, http_headers);
+  shm_regions_.push_back(ring->InputRegion());
+  if (ring->OutputSlotSize() > 0) {
+    err = client_->RegisterSystemSharedMemory(
+        ring->OutputRegion(), ring->OutputKey(), ring->OutputRegionSize());
     if (!err.IsOk()) {
-      std::cerr << "error: failed to get model metadata: " << err << std::endl;
-    }
-    inference::ModelConfigResponse model_config;
-    err = triton_client.grpc_client_->ModelConfig(
-        &model_config, model_name, model_version, http_headers);
-    if (!err.IsOk()) {
-      std::cerr << "error: failed to get model config: " << err << std::endl;
+      std::cerr << "error: unable to register shared memory output region: "
+                << err << std::endl;
+      exit(1);
     }
-    ParseModelGrpc(model_metadata, model_config, batch_size, &model_info);
+    shm_regions_.push_back(ring->OutputRegion());
   }
 
-  // Collect the names of the image(s).
-  std::vector<std::string> image_filenames = batchq.filenames_;
-
-  // struct stat name_stat;
-  // if (stat(args.filename.c_str(), &name_stat) != 0) {
-  //   std::cerr << "Failed to find '" << std::string(args.filename)
-  //             << "': " << strerror(errno) << std::endl;
-  //   exit(1);
-  // }
-
-  // if (name_stat.st_mode & S_IFDIR) {
-  //   const std::string dirname = args.filename;
-  //   DIR* dir_ptr = opendir(dirname.c_str());
-  //   struct dirent* d_ptr;
-  //   while ((d_ptr = readdir(dir_ptr)) != NULL) {
-  //     const std::string filename = d_ptr->d_name;
-  //     if ((filename != ".") && (filename != "..")) {
-  //       image_filenames.push_back(dirname + "/" + filename);
-  //     }
-  //   }
-  //   closedir(dir_ptr);
-  // } else {
-  //   image_filenames.push_back(args.filename);
-  // }
+  std::lock_guard<std::mutex> model_lock(model->mutex_);
+  model->shm_ring_ = ring;
+}
 
-  // Sort the filenames so that we always visit them in the same order
-  // (readdir does not guarantee any particular order).
-  // std::sort(image_filenames.begin(), image_filenames.end());
-
-  // Preprocess the images into input data according to model
-  // requirements
-  std::vector<std::vector<uint8_t>> image_data;
-  // for (const auto& fn : image_filenames) {
-  //   image_data.emplace_back();
-  //   FileToInputData(
-  //       fn, model_info.input_c_, model_info.input_h_, model_info.input_w_,
-  //       model_info.input_format_, model_info.type1_, model_info.type3_, scale,
-  //       &(image_data.back()));
-
-  //   if ((image_data.size() == 1) && !preprocess_output_filename.empty()) {
-  //     std::ofstream output_file(preprocess_output_filename);
-  //     std::ostream_iterator<uint8_t> output_iterator(output_file);
-  //     std::copy(image_data[0].begin(), image_data[0].end(), output_iterator);
-  //   }
-  // }
-  for (const auto data : batchq.data_) {
+std::unique_ptr<TritonModel>
+TritonSession::LoadModel(const std::string& model_name)
+{
+  auto start = std::chrono::high_resolution_clock::now();
+  tc::Headers http_headers;
+  auto model = std::make_unique<TritonModel>();
 
-    // std::cout << "format:" << model_info.input_format_ << std::endl;
-    // std::cout << "input datatype:"<< model_info.input_datatype_<< " type1:" << model_info.type1_ << " type3:" <<  model_info.type3_<< std::endl;
-    // std::cout << "c:" << model_info.input_c_ << std::endl;
-    // std::cout << "w:" << model_info.input_w_ << std::endl;
-    // std::cout << "h:" << model_info.input_h_ << std::endl;
-    
-    image_data.emplace_back(data);
+  // Extract and validate that the model meets the requirements for
+  // image classification.
+  inference::ModelMetadataResponse model_metadata;
+  tc::Error err = client_->ModelMetadata(
+      &model_metadata, model_name, model_version_, http_headers);
+  if (!err.IsOk()) {
+    std::cerr << "error: failed to get model metadata: " << err << std::endl;
   }
+  inference::ModelConfigResponse model_config;
+  err = client_->ModelConfig(
+      &model_config, model_name, model_version_, http_headers);
+  if (!err.IsOk()) {
+    std::cerr << "error: failed to get model config: " << err << std::endl;
+  }
+  // the batch size is checked against max_batch_size_ for every batch
+  ParseModelGrpc(model_metadata, model_config, 1, &model->info_);
+  const ModelInfo& model_info = model->info_;
 
+  // Initialize the input, the shape is set again for every batch.
   std::vector<int64_t> shape;
-  // Include the batch dimension if required
-  // std::cout << batch_size << std::endl; 
-  // std::cout << model_info.max_batch_size_ << std::endl;
   if (model_info.max_batch_size_ != 0) {
-    shape.push_back(batch_size);
+    shape.push_back(1);
   }
-  LOG_INFO("expected input shape: batch: %d, channels: %d, height: %d, width: %d\n", batch_size, model_info.input_c_, model_info.input_h_, model_info.input_w_);
   if (model_info.input_format_.compare("FORMAT_NHWC") == 0) {
     shape.push_back(model_info.input_h_);
     shape.push_back(model_info.input_w_);
@@ -841,8 +766,6 @@ ImageClassify(BatchQuery& batchq, std::vector<std::string>& res)
     shape.push_back(model_info.input_h_);
     shape.push_back(model_info.input_w_);
   }
-
-  // Initialize the inputs with the data.
   tc::InferInput* input;
   err = tc::InferInput::Create(
       &input, model_info.input_name_, shape, model_info.input_datatype_);
@@ -850,253 +773,307 @@ ImageClassify(BatchQuery& batchq, std::vector<std::string>& res)
     std::cerr << "unable to get input: " << err << std::endl;
     exit(1);
   }
-  std::shared_ptr<tc::InferInput> input_ptr(input);
-  std::vector<tc::InferInput*> inputs = {input_ptr.get()};
-
-  int output_sizes = model_info.output_names_.size();
-  // std::vector<tc::InferRequestedOutput*> outputs;
-  std::vector<const tc::InferRequestedOutput*> outputs = {};
-  // Set the number of classification expected
-  tc::InferRequestedOutput* output1;
-  tc::InferRequestedOutput* output2;
-
-  std::vector<std::shared_ptr<tc::InferRequestedOutput>> output_ptrs;
-
-  if (model_name.find("irevnet") != std::string::npos) {
-    err = tc::InferRequestedOutput::Create(&output1, model_info.output_names_[0], topk);
+  model->input_.reset(input);
+  model->inputs_ = {model->input_.get()};
+
+  // Set the number of classification expected on the first output, irevnet
+  // models also return the feature map as the second output
+  size_t output_num = model_name.find("irevnet") != std::string::npos ? 2 : 1;
+  for (size_t i = 0; i < output_num; i++) {
+    tc::InferRequestedOutput* output;
+    err = tc::InferRequestedOutput::Create(
+        &output, model_info.output_names_[i], i == 0 ? topk_ : 0);
     if (!err.IsOk()) {
       std::cerr << "unable to get output: " << err << std::endl;
       exit(1);
     }
+    model->output_ptrs_.emplace_back(output);
+    model->outputs_.push_back(output);
+  }
+  model->class_outputs_ = {model->outputs_[0]};
+
+  auto end = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                  (end - start).count();
+  LOG_INFO("Triton model %s loaded in %lf ms, max batch size: %d",
+           model_name.c_str(), duration, model_info.max_batch_size_);
+  return model;
+}
 
-    auto output_ptr1 = std::shared_ptr<tc::InferRequestedOutput>(output1);
-    output_ptrs.push_back(output_ptr1);
-    outputs.push_back(output_ptr1.get());
+tc::Error
+TritonSession::Infer(tc::InferResult** result, const tc::InferOptions& options,
+                     TritonModel* model, bool classes_only)
+{
+  // Infer is not thread-safe on a single client
+  std::lock_guard<std::mutex> lock(client_mutex_);
+  return client_->Infer(result, options, model->inputs_,
+                        classes_only ? model->class_outputs_ : model->outputs_);
+}
 
-    err = tc::InferRequestedOutput::Create(&output2, model_info.output_names_[1]);
-    if (!err.IsOk()) {
-      std::cerr << "unable to get output: " << err << std::endl;
+
+tc::Error
+TritonSession::AsyncInfer(tc::InferenceServerClient::OnCompleteFn callback, const tc::InferOptions& options,
+                          TritonModel* model, bool classes_only)
+{
+  // the request is serialized before AsyncInfer returns, so the input of
+  // the model can be refilled for the next batch right after this call
+  std::lock_guard<std::mutex> lock(client_mutex_);
+  return client_->AsyncInfer(callback, options, model->inputs_,
+                             classes_only ? model->class_outputs_ : model->outputs_);
+}
+
+namespace {
+
+// Fill the cached input of the model with the data of 'batchq'. The caller
+// must hold the mutex of the model until the request has been sent.
+void
+SetBatchInput(TritonModel* model, BatchQuery& batchq)
+{
+  int batch_size = batchq.batch_size_;
+  const ModelInfo& model_info = model->info_;
+
+  // Model specifying maximum batch size of 0 indicates that batching
+  // is not supported and so the input tensors do not expect a "N"
+  // dimension (and 'batch_size' should be 1 so that only a single
+  // image instance is inferred at a time).
+  if (model_info.max_batch_size_ == 0) {
+    if (batch_size != 1) {
+      std::cerr << "batching not supported for model \""
+                << batchq.model_name_ << "\"" << std::endl;
       exit(1);
     }
+  } else if (batch_size > model_info.max_batch_size_) {
+    std::cerr << "expecting batch size <= " << model_info.max_batch_size_
+              << " for model '" << batchq.model_name_ << "'" << std::endl;
+    exit(1);
+  }
 
-    auto output_ptr2 = std::shared_ptr<tc::InferRequestedOutput>(output2);
-    output_ptrs.push_back(output_ptr2);
-    outputs.push_back(output_ptr2.get());
+  std::vector<int64_t> shape;
+  // Include the batch dimension if required
+  if (model_info.max_batch_size_ != 0) {
+    shape.push_back(batch_size);
   }
-  else {
-    // std::cout << "model_info.output_name[0]:" << model_info.output_names_[0] << std::endl;
-    err = tc::InferRequestedOutput::Create(&output1, model_info.output_names_[0], topk);
-    if (!err.IsOk()) {
-      std::cerr << "unable to get output: " << err << std::endl;
-      exit(1);
-    }
-    auto output_ptr1 = std::shared_ptr<tc::InferRequestedOutput>(output1);
-    output_ptrs.push_back(output_ptr1);
-    outputs.push_back(output_ptr1.get());
+  LOG_INFO("expected input shape: batch: %d, channels: %d, height: %d, width: %d\n", batch_size, model_info.input_c_, model_info.input_h_, model_info.input_w_);
+  if (model_info.input_format_.compare("FORMAT_NHWC") == 0) {
+    shape.push_back(model_info.input_h_);
+    shape.push_back(model_info.input_w_);
+    shape.push_back(model_info.input_c_);
+  } else {
+    shape.push_back(model_info.input_c_);
+    shape.push_back(model_info.input_h_);
+    shape.push_back(model_info.input_w_);
   }
-  
-  // Configure context for 'batch_size' and 'topk'
-  tc::InferOptions options(model_name);
-  options.model_version_ = model_version;
-
-  // Send requests of 'batch_size' images. If the number of images
-  // isn't an exact multiple of 'batch_size' then just start over with
-  // the first images until the batch is filled.
-  //
-  // Number of requests sent = ceil(number of images / batch_size)
-  std::vector<std::unique_ptr<tc::InferResult>> results;
-  std::vector<std::vector<std::string>> result_filenames;
-  size_t image_idx = 0;
-  size_t done_cnt = 0;
-  size_t sent_count = 0;
-  bool last_request = false;
-  std::mutex mtx;
-  std::condition_variable cv;
-
-  auto callback_func = [&](tc::InferResult* result) {
-    {
-      // Defer the response retrieval to main thread
-      std::lock_guard<std::mutex> lk(mtx);
-      results.emplace_back(result);
-      done_cnt++;
-    }
-    cv.notify_all();
-  };
 
-  // if (streaming) {
-  //   err = triton_client.grpc_client_->StartStream(
-  //       callback_func, true /* enable_stats */, 0 /* stream_timeout */,
-  //       http_headers);
-  //   if (!err.IsOk()) {
-  //     std::cerr << "failed to establish the stream: " << err << std::endl;
-  //   }
-  // }
+  tc::Error err = model->input_->SetShape(shape);
+  if (!err.IsOk()) {
+    std::cerr << "failed setting input shape: " << err << std::endl;
+    exit(1);
+  }
+  // Reset the input for new request.
+  err = model->input_->Reset();
+  if (!err.IsOk()) {
+    std::cerr << "failed resetting input: " << err << std::endl;
+    exit(1);
+  }
 
-  while (!last_request) {
-    // Reset the input for new request.
-    err = input_ptr->Reset();
+  // The feature map of irevnet is the only raw output, the classification
+  // output is returned through grpc in any case.
+  bool shm_output = model->shm_ring_ != nullptr && model->output_ptrs_.size() > 1;
+  if (batchq.shm_slot_ != nullptr) {
+    // The BatchWorker already wrote the images into the slot, triton reads
+    // them and writes the feature map of the batch back into the slot.
+    ShmSlot* slot = batchq.shm_slot_;
+    err = model->input_->SetSharedMemory(
+        slot->ring_->InputRegion(), batch_size * model_info.input_byte_size_,
+        slot->input_offset_);
     if (!err.IsOk()) {
-      std::cerr << "failed resetting input: " << err << std::endl;
+      std::cerr << "failed setting shared memory input: " << err << std::endl;
       exit(1);
     }
-
-    // Set input to be the next 'batch_size' images (preprocessed).
-    std::vector<std::string> input_filenames;
-    for (int idx = 0; idx < batch_size; ++idx) {
-      input_filenames.push_back(image_filenames[image_idx]);
-      err = input_ptr->AppendRaw(image_data[image_idx]);
-      if (!err.IsOk()) {
-        std::cerr << "failed setting input: " << err << std::endl;
-        exit(1);
-      }
-
-      image_idx = (image_idx + 1) % image_data.size();
-      if (image_idx == 0) {
-        last_request = true;
-      }
-    }
-
-    result_filenames.emplace_back(std::move(input_filenames));
-
-    options.request_id_ = std::to_string(sent_count);
-
-    // Send request.
-    if (!async) {
-      tc::InferResult* result;
-      if (protocol == ProtocolType::HTTP) {
-        err = triton_client.http_client_->Infer(
-            &result, options, inputs, outputs, http_headers);
-      } 
-      else {
-        LOG_INFO("send InferRequest to grpc client");
-        // std::cout << "opt.model_name:" << options.model_name_ << std::endl;
-        // std::cout << "opt.model_version:" << options.model_version_<< std::endl;
-        // std::cout << "opt.request_id:" << options.request_id_<< std::endl;
-        // std::cout << "options.sequence_id_str_:" << options.sequence_id_str_ << std::endl;
-        // for (auto& param: options.request_parameters) {
-        //   std::cout << "options.param.second.value:" << param.second.value << std::endl;
-        // }
-        // for (const auto routput : outputs) {
-        //   std::cout << "output.name:" << routput->Name() << std::endl;
-        // }
-        err = triton_client.grpc_client_->Infer(
-            &result, options, inputs, outputs, http_headers);
-      }
+    if (shm_output) {
+      err = model->output_ptrs_[1]->SetSharedMemory(
+          slot->ring_->OutputRegion(), batch_size * model_info.output_byte_sizes_[1],
+          slot->output_offset_);
       if (!err.IsOk()) {
-        std::cerr << "failed sending synchronous infer request: " << err
-                  << std::endl;
+        std::cerr << "failed setting shared memory output: " << err << std::endl;
         exit(1);
       }
-      results.emplace_back(result);
-    } 
-    // else {
-    //   if (streaming) {
-    //     err = triton_client.grpc_client_->AsyncStreamInfer(
-    //         options, inputs, outputs);
-    //   } else {
-    //     if (protocol == ProtocolType::HTTP) {
-    //       err = triton_client.http_client_->AsyncInfer(
-    //           callback_func, options, inputs, outputs, http_headers);
-    //     } else {
-    //       err = triton_client.grpc_client_->AsyncInfer(
-    //           callback_func, options, inputs, outputs, http_headers);
-    //     }
-    //   }
-    //   if (!err.IsOk()) {
-    //     std::cerr << "failed sending asynchronous infer request: " << err
-    //               << std::endl;
-    //     exit(1);
-    //   }
-    // }
-    sent_count++;
-  }
-
-  // For async, retrieve results according to the send order
-  if (async) {
-    // Wait until all callbacks are invoked
-    {
-      std::unique_lock<std::mutex> lk(mtx);
-      cv.wait(lk, [&]() {
-        if (done_cnt >= sent_count) {
-          return true;
-        } else {
-          return false;
-        }
-      });
     }
+    return;
   }
 
-  // Post-process the results to make prediction(s)
-  std::vector<int64_t> shape1, shape2;
-  if (model_name.find("irevnet") != std::string::npos) {
-    results[0]->Shape(model_info.output_names_[0], &shape1);
-    results[0]->Shape(model_info.output_names_[1], &shape2);
+  if (shm_output) {
+    model->output_ptrs_[1]->UnsetSharedMemory();
   }
-  else {
-    results[0]->Shape(model_info.output_names_[0], &shape1);
-  }
-  
-  // std::cout << "Shape output0: ";
-  // for (auto s : shape1) std::cout << s << " ";
-  // std::cout << "\nShape output1: ";
-  // for (auto s : shape2) std::cout << s << " ";
-  // std::cout << std::endl;
-  
-  // results[0]->RawData(model_info.output_names_[0], &bytes1, &byte_size1);
-  std::vector<std::string> result_data1;
-  err = results[0]->StringData(model_info.output_names_[0], &result_data1);
+  // Set input to be the 'batch_size' images (preprocessed by the frontend),
+  // they are already contiguous so the batch is appended at once. The input
+  // only keeps the pointer, the buffer lives as long as the batch.
+  err = model->input_->AppendRaw(batchq.input_->Data(), batchq.input_->Size());
   if (!err.IsOk()) {
-    std::cerr << "unable to get data for " << model_info.output_names_[0] << std::endl;
+    std::cerr << "failed setting input: " << err << std::endl;
     exit(1);
   }
+}
 
-  // const uint8_t* byte1;
-  // size_t byte_size1;
-  // results[0]->RawData(model_info.output_names_[0], &byte1, &byte_size1);
+// Point the per-sample replies of 'batchq' into the outputs of the batch,
+// nothing is copied here. The result is kept by the batch so the views stay
+// valid until the ReplyWorker has written them.
+void
+ParseBatchResult(const ModelInfo& model_info, tc::InferResult* result,
+                 BatchQuery& batchq)
+{
+  int batch_size = batchq.batch_size_;
+  const std::string& model_name = batchq.model_name_;
+  batchq.result_.reset(result);
+  batchq.reply_views_.assign(batch_size, ReplyView{nullptr, 0, nullptr, 0, nullptr, 0});
+
+  // The classification output is serialized as BYTES elements, each one a
+  // 4-byte length followed by the string. The elements of a sample are
+  // sorted by score so the first one is its prediction.
+  const uint8_t* label_bytes;
+  size_t label_byte_size = 0;
+  std::vector<std::pair<const char*, size_t>>& elements = batchq.classes_;
+  elements.clear();
+  tc::Error err = result->RawData(model_info.output_names_[0], &label_bytes, &label_byte_size);
+  if (err.IsOk() && label_byte_size != 0) {
+    size_t offset = 0;
+    while (offset + sizeof(uint32_t) <= label_byte_size) {
+      uint32_t element_size;
+      memcpy(&element_size, label_bytes + offset, sizeof(uint32_t));
+      elements.emplace_back(
+          reinterpret_cast<const char*>(label_bytes + offset + sizeof(uint32_t)), element_size);
+      offset += sizeof(uint32_t) + element_size;
+    }
+  } else {
+    // the server returned the strings as bytes_contents, keep a copy of
+    // them in the batch
+    err = result->StringData(model_info.output_names_[0], &batchq.labels_);
+    if (!err.IsOk()) {
+      std::cerr << "unable to get data for " << model_info.output_names_[0] << std::endl;
+      exit(1);
+    }
+    for (const auto& label : batchq.labels_) {
+      elements.emplace_back(label.data(), label.size());
+    }
+  }
+  size_t per_sample = elements.size() / batch_size;
+  for (int i = 0; i < batch_size && per_sample > 0; i++) {
+    ReplyView& view = batchq.reply_views_[i];
+    view.classes_ = &elements[i * per_sample];
+    view.class_num_ = per_sample;
+    view.label_ = view.classes_[0].first;
+    view.label_size_ = view.classes_[0].second;
+  }
 
-  const uint8_t* bytes2;
-  size_t byte_size2;
-  if (model_name.find("irevnet") != std::string::npos) {
-    results[0]->RawData(model_info.output_names_[1], &bytes2, &byte_size2);
+  // Only irevnet returns a feature map, which comes before the prediction
+  // in the reply of each sample. It is not asked for when all the samples
+  // reply with their top classes.
+  if (model_name.find("irevnet") == std::string::npos || batchq.classesOnly()) {
+    return;
+  }
+  const uint8_t* feature_bytes;
+  size_t feature_byte_size;
+  ShmSlot* slot = batchq.shm_slot_;
+  if (slot != nullptr && slot->output_ != nullptr) {
+    // triton has written the feature map into the slot
+    feature_bytes = slot->output_;
+    feature_byte_size = batch_size * model_info.output_byte_sizes_[1];
   }
   else {
-    results[0]->RawData(model_info.output_names_[0], &bytes2, &byte_size2);
+    err = result->RawData(model_info.output_names_[1], &feature_bytes, &feature_byte_size);
+    if (!err.IsOk()) {
+      std::cerr << "unable to get data for " << model_info.output_names_[1] << std::endl;
+      exit(1);
+    }
   }
+  size_t feature_size = model_info.output_byte_sizes_[1];
+  if (feature_byte_size < batch_size * feature_size) {
+    std::cerr << "unexpected size of " << model_info.output_names_[1]
+              << ", expected " << batch_size * feature_size << " bytes, got "
+              << feature_byte_size << std::endl;
+    exit(1);
+  }
+  for (int i = 0; i < batch_size; i++) {
+    batchq.reply_views_[i].feature_ = feature_bytes + i * feature_size;
+    batchq.reply_views_[i].feature_size_ = feature_size;
+  }
+}
 
-  // std::cout << "Byte size1: " << byte_size1 << "\nByte size2: " << byte_size2 << std::endl;
-
-  // if (result_data1.size() != (topk * batch_size)) {
-  //   std::cerr << "unexpected number of strings in the result, expected "
-  //             << (topk * batch_size) << ", got " << result_data1.size()
-  //             << std::endl;
-  //   exit(1);
-  // }
-  // std::cout << "result_data1: " << result_data1 << std::endl;
+}  // namespace
 
-  // const float* output1_data = reinterpret_cast<const float*>(bytes2);
-  // size_t output1_elem_count = byte_size2 / sizeof(float);
-  // size_t per_sample_size = 512 * 8 * 8;
 
-  // for (int i = 0; i < batch_size; ++i) {
-  //   std::cout << "Sample " << i << " output1 (first 10 values): ";
-  //   for (int j = 0; j < 10; ++j) {
-  //     std::cout << output1_data[i * per_sample_size + j] << " ";
-  //   }
-  //   std::cout << std::endl;
-  // }
-  std::string bytes2_str = BytesToString(bytes2, byte_size2);
+int
+ImageClassify(TritonSession& session, BatchQuery& batchq)
+{
+  auto prepare_start = std::chrono::high_resolution_clock::now();
+
+  // The metadata, the input and the requested outputs are cached by the
+  // session, only the data of this batch is set here.
+  TritonModel* model = session.GetModel(batchq.model_name_);
+  std::unique_lock<std::mutex> model_lock(model->mutex_);
+  SetBatchInput(model, batchq);
+
+  tc::InferOptions options(batchq.model_name_);
+  options.request_id_ = std::to_string(batchq.id_);
+  auto prepare_end = std::chrono::high_resolution_clock::now();
+
+  // Send request.
+  tc::InferResult* result;
+  LOG_INFO("send InferRequest to grpc client");
+  tc::Error err = session.Infer(&result, options, model, batchq.classesOnly());
+  model_lock.unlock();
+  if (!err.IsOk()) {
+    std::cerr << "failed sending synchronous infer request: " << err
+              << std::endl;
+    exit(1);
+  }
+  auto infer_end = std::chrono::high_resolution_clock::now();
+  double prepare_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                        (prepare_end - prepare_start).count();
+  double infer_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                      (infer_end - prepare_end).count();
+  LOG_DEBUG("ImageClassify batch: %d, prepare time: %lf ms, infer time: %lf ms",
+            batchq.id_, prepare_time, infer_time);
+
+  ParseBatchResult(model->info_, result, batchq);
+  return 0;
+}
 
-  for (int i = 0; i < batch_size; i++) {
-    std::string tmp;
-    int size2 = 4;
-    assert(shape2.size() > 1);
-    for (int i = 1; i < shape2.size(); i++) {
-      size2 *= shape2[i];
+int
+AsyncImageClassify(TritonSession& session, BatchQuery* batchq,
+                   std::function<void(BatchQuery*)> callback)
+{
+  auto prepare_start = std::chrono::high_resolution_clock::now();
+  TritonModel* model = session.GetModel(batchq->model_name_);
+  std::unique_lock<std::mutex> model_lock(model->mutex_);
+  SetBatchInput(model, *batchq);
+
+  tc::InferOptions options(batchq->model_name_);
+  options.request_id_ = std::to_string(batchq->id_);
+
+  // The completion runs on the worker thread of the grpc client, it parses
+  // the outputs into the batch and hands the batch over to 'callback'.
+  auto on_complete = [model, batchq, callback, prepare_start](tc::InferResult* result) {
+    tc::Error err = result->RequestStatus();
+    if (!err.IsOk()) {
+      std::cerr << "failed asynchronous infer request " << batchq->id_
+                << ": " << err << std::endl;
+      exit(1);
     }
-    tmp += bytes2_str.substr(i*size2, (i+1)*size2);
-    tmp += result_data1[i];
-    res.push_back(tmp);
-  }
+    ParseBatchResult(model->info_, result, *batchq);
+    auto end = std::chrono::high_resolution_clock::now();
+    double infer_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                        (end - prepare_start).count();
+    LOG_DEBUG("AsyncImageClassify batch: %d, time: %lf ms", batchq->id_, infer_time);
+    callback(batchq);
+  };
 
+  LOG_INFO("send async InferRequest: %d to grpc client", batchq->id_);
+  tc::Error err = session.AsyncInfer(on_complete, options, model, batchq->classesOnly());
+  if (!err.IsOk()) {
+    std::cerr << "failed sending asynchronous infer request: " << err
+              << std::endl;
+    exit(1);
+  }
   return 0;
 }
@@ -8,12 +8,15 @@
 #include <algorithm>
 #include <condition_variable>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <mutex>
 #include <opencv2/core/version.hpp>
 #include <queue>
 #include <string>
+#include <unordered_map>
 
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
@@ -24,6 +27,8 @@
 #include "json_utils.h"
 #include "worker.hh"
 #include "query.hh"
+#include "shm_ring.hh"
+#include "reply_stream.hh"
 #if CV_MAJOR_VERSION == 2
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -42,12 +47,6 @@
 
 namespace tc = triton::client;
 
-namespace {
-
-// enum ScaleType { NONE = 0, VGG = 1, INCEPTION = 2 };
-
-enum ProtocolType { HTTP = 0, GRPC = 1 };
-
 struct ModelInfo {
   std::string output_name_;
   std::vector<std::string> output_names_;
@@ -62,8 +61,17 @@ struct ModelInfo {
   int type1_;
   int type3_;
   int max_batch_size_;
+  // The size in bytes of one sample of the input/outputs
+  size_t input_byte_size_;
+  std::vector<size_t> output_byte_sizes_;
 };
 
+namespace {
+
+// enum ScaleType { NONE = 0, VGG = 1, INCEPTION = 2 };
+
+enum ProtocolType { HTTP = 0, GRPC = 1 };
+
 void Preprocess(const cv::Mat& img, const std::string& format, int img_type1, int img_type3,
             	size_t img_channels, const cv::Size& img_size, const ScaleType scale,
     			std::vector<uint8_t>* input_data); 
@@ -109,7 +117,7 @@ typedef struct ImageArgs {
   std::string scale;
   std::string filename;
   std::string data;
-  grpcStream* stream;
+  ReplyStream* stream;
   int id;
   int encode_id;
   std::string encode_type;
@@ -120,6 +128,17 @@ typedef struct ImageArgs {
   int front_id;
   bool end_signal;
   bool recompute;
+  // the time left to answer the query when it was sent, if any
+  bool has_deadline;
+  double deadline_ms;
+  // the classes to reply with instead of the full reply, 0 for the full
+  // reply
+  uint32_t top_k;
+  // the feature map stays in the FeatureStore, the reply only carries the
+  // prediction
+  bool retain;
+  // data is the encoded image, it is preprocessed by the backend
+  bool compressed;
 }ImageArgs;
 
 typedef struct ImageClassifyArgs {
@@ -132,5 +151,70 @@ typedef struct ImageClassifyArgs {
 }ImageClassifyArgs;
 
 
+/**
+ * The parsed metadata of a model and the input/output descriptors reused by
+ * every batch sent to it. The input is reset and refilled per batch, so it
+ * must only be touched while holding mutex_.
+ */
+struct TritonModel {
+  ModelInfo info_;
+  std::shared_ptr<tc::InferInput> input_;
+  std::vector<tc::InferInput*> inputs_;
+  std::vector<std::shared_ptr<tc::InferRequestedOutput>> output_ptrs_;
+  std::vector<const tc::InferRequestedOutput*> outputs_;
+  // only the classification output, for the batches without feature maps
+  std::vector<const tc::InferRequestedOutput*> class_outputs_;
+  // set when the batches of the model go through system shared memory
+  std::shared_ptr<ShmRing> shm_ring_;
+  std::mutex mutex_;
+};
+
+/**
+ * A long-lived connection to one triton server. The grpc client and the
+ * per-model metadata are created once and shared by all the batches of the
+ * backend, instead of being rebuilt for every ImageClassify call.
+ */
+class TritonSession {
+public:
+  TritonSession(const std::string& url, size_t topk = 10, bool verbose = false);
+  ~TritonSession();
+
+  // returns the cached model, fetching its metadata/config on the first use
+  TritonModel* GetModel(const std::string& model_name);
+  // creates a ring of 'slot_num' batches sized for the model
+  std::shared_ptr<ShmRing> CreateSharedMemory(const std::string& model_name,
+                                              size_t slot_num);
+  // registers the ring with the server, which must run on the same host
+  void RegisterSharedMemory(const std::string& model_name,
+                            std::shared_ptr<ShmRing> ring);
+  // 'classes_only' leaves out the outputs other than the classification
+  tc::Error Infer(tc::InferResult** result, const tc::InferOptions& options,
+                  TritonModel* model, bool classes_only = false);
+  tc::Error AsyncInfer(tc::InferenceServerClient::OnCompleteFn callback, const tc::InferOptions& options,
+                       TritonModel* model, bool classes_only = false);
+
+  const std::string& Url() const { return url_; }
+  size_t TopK() const { return topk_; }
+
+private:
+  std::unique_ptr<TritonModel> LoadModel(const std::string& model_name);
+
+  std::string url_;
+  std::string model_version_;
+  size_t topk_;
+  bool verbose_;
+  std::unique_ptr<tc::InferenceServerGrpcClient> client_;
+  std::mutex client_mutex_;
+
+  std::unordered_map<std::string, std::unique_ptr<TritonModel>> models_;
+  std::mutex models_mutex_;
+  std::vector<std::string> shm_regions_;
+};
+
 // int ImageClassify(const ImageClassifyArgs& args, std::string& res);
-int ImageClassify(BatchQuery& batchq, std::vector<std::string>& res);
\ No newline at end of file
+// fills the reply_views_ of the batch, see BatchQuery::releaseOutputs
+int ImageClassify(TritonSession& session, BatchQuery& batchq);
+// sends the batch without waiting for it, 'callback' receives the batch
+// with its reply_views_ filled once triton has answered
+int AsyncImageClassify(TritonSession& session, BatchQuery* batchq,
+                       std::function<void(BatchQuery*)> callback);
\ No newline at end of file
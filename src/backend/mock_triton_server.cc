@@ -0,0 +1,505 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include "../inc/inc.hh"
+#include "../common/conf.hh"
+#include "../common/logger.hh"
+
+#include "grpc_service.grpc.pb.h"
+
+/**
+ * A stand-in for a triton server, it answers the ModelMetadata, ModelConfig
+ * and ModelInfer calls the backend makes for the models of DATASETS. The
+ * inference only sleeps for the configured latency of the batch size and
+ * returns outputs of the right shapes, so the frontend/backend pipeline can
+ * be load-tested without a GPU.
+ *
+ * mock_config:
+ *   port: listening port, 8001 by default
+ *   max_batch_size: reported in the model config
+ *   instances: batches executed at the same time, like model instances
+ *   base_ms, per_sample_ms: latency of a batch of n is base + n * per_sample
+ *   batch_latency_ms: {"n": ms}, overrides the formula, sizes in between
+ *                     are interpolated
+ *   jitter_ms: standard deviation of a gaussian noise added to the latency
+ *   straggler_prob, straggler_ms: a batch is delayed by straggler_ms with
+ *                                 probability straggler_prob
+ */
+
+const int kNumClasses = 10;
+const std::string kInputName = "INPUT__0";
+const std::string kLabelName = "OUTPUT__0";
+const std::string kFeatureName = "OUTPUT__1";
+
+struct MockModel {
+    std::string name_;
+    std::vector<int64_t> input_dims_;
+    // the feature map of irevnet, empty for the other models
+    std::vector<int64_t> feature_dims_;
+};
+
+struct MockRegion {
+    uint8_t* addr_;
+    size_t byte_size_;
+};
+
+class MockTritonService final : public inference::GRPCInferenceService::Service {
+public:
+    MockTritonService(std::shared_ptr<Config> conf) : conf_(conf), running_(0) {
+        const Json::Value& mock_config = conf_->mock_config;
+        max_batch_size_ = mock_config.get("max_batch_size", 64).asInt();
+        instances_ = std::max(mock_config.get("instances", 1).asInt(), 1);
+        base_ms_ = mock_config.get("base_ms", 2.0).asDouble();
+        per_sample_ms_ = mock_config.get("per_sample_ms", 0.5).asDouble();
+        jitter_ms_ = mock_config.get("jitter_ms", 0.0).asDouble();
+        straggler_prob_ = mock_config.get("straggler_prob", 0.0).asDouble();
+        straggler_ms_ = mock_config.get("straggler_ms", 0.0).asDouble();
+        auto table = mock_config.get("batch_latency_ms", Json::Value());
+        if (table.isObject()) {
+            for (const auto& key : table.getMemberNames()) {
+                latency_table_[std::stoi(key)] = table[key].asDouble();
+            }
+        }
+
+        for (const auto& model_name : conf_->model_names) {
+            auto it = DATASETS.find(model_name);
+            if (it == DATASETS.end()) {
+                LOG_ERROR("model %s is not in DATASETS, skip it", model_name.c_str());
+                continue;
+            }
+            MockModel model;
+            model.name_ = model_name;
+            model.input_dims_ = {conf_->channels, conf_->height, conf_->width};
+            if (model_name.find("irevnet") != std::string::npos) {
+                // the feature map is 512 channels of a square map
+                int64_t side = std::lround(std::sqrt(it->second.first / sizeof(float) / 512));
+                model.feature_dims_ = {512, side, side};
+            }
+            models_[model_name] = model;
+            LOG_INFO("MockTritonService serves model: %s", model_name.c_str());
+        }
+        LOG_INFO("MockTritonService latency: base %lf ms, per sample %lf ms, jitter %lf ms, straggler %lf ms with p=%lf, instances: %d",
+                 base_ms_, per_sample_ms_, jitter_ms_, straggler_ms_, straggler_prob_, instances_);
+    }
+
+    ~MockTritonService() {
+        for (auto& region : regions_) {
+            munmap(region.second.addr_, region.second.byte_size_);
+        }
+    }
+
+    Status ServerLive(ServerContext* context, const inference::ServerLiveRequest* request,
+                      inference::ServerLiveResponse* response) override {
+        response->set_live(true);
+        return Status::OK;
+    }
+
+    Status ServerReady(ServerContext* context, const inference::ServerReadyRequest* request,
+                       inference::ServerReadyResponse* response) override {
+        response->set_ready(true);
+        return Status::OK;
+    }
+
+    Status ModelReady(ServerContext* context, const inference::ModelReadyRequest* request,
+                      inference::ModelReadyResponse* response) override {
+        response->set_ready(models_.find(request->name()) != models_.end());
+        return Status::OK;
+    }
+
+    Status ModelMetadata(ServerContext* context, const inference::ModelMetadataRequest* request,
+                         inference::ModelMetadataResponse* response) override {
+        auto it = models_.find(request->name());
+        if (it == models_.end()) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown model: " + request->name());
+        }
+        const MockModel& model = it->second;
+        response->set_name(model.name_);
+        response->add_versions("1");
+        response->set_platform("mock");
+
+        auto input = response->add_inputs();
+        input->set_name(kInputName);
+        input->set_datatype("FP32");
+        input->add_shape(-1);
+        for (auto dim : model.input_dims_) {
+            input->add_shape(dim);
+        }
+        auto label = response->add_outputs();
+        label->set_name(kLabelName);
+        label->set_datatype("FP32");
+        label->add_shape(-1);
+        label->add_shape(kNumClasses);
+        if (!model.feature_dims_.empty()) {
+            auto feature = response->add_outputs();
+            feature->set_name(kFeatureName);
+            feature->set_datatype("FP32");
+            feature->add_shape(-1);
+            for (auto dim : model.feature_dims_) {
+                feature->add_shape(dim);
+            }
+        }
+        return Status::OK;
+    }
+
+    Status ModelConfig(ServerContext* context, const inference::ModelConfigRequest* request,
+                       inference::ModelConfigResponse* response) override {
+        auto it = models_.find(request->name());
+        if (it == models_.end()) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown model: " + request->name());
+        }
+        const MockModel& model = it->second;
+        auto config = response->mutable_config();
+        config->set_name(model.name_);
+        config->set_platform("mock");
+        config->set_max_batch_size(max_batch_size_);
+
+        auto input = config->add_input();
+        input->set_name(kInputName);
+        input->set_data_type(inference::TYPE_FP32);
+        input->set_format(inference::ModelInput::FORMAT_NCHW);
+        for (auto dim : model.input_dims_) {
+            input->add_dims(dim);
+        }
+        auto label = config->add_output();
+        label->set_name(kLabelName);
+        label->set_data_type(inference::TYPE_FP32);
+        label->add_dims(kNumClasses);
+        if (!model.feature_dims_.empty()) {
+            auto feature = config->add_output();
+            feature->set_name(kFeatureName);
+            feature->set_data_type(inference::TYPE_FP32);
+            for (auto dim : model.feature_dims_) {
+                feature->add_dims(dim);
+            }
+        }
+        return Status::OK;
+    }
+
+    Status SystemSharedMemoryRegister(ServerContext* context,
+                                      const inference::SystemSharedMemoryRegisterRequest* request,
+                                      inference::SystemSharedMemoryRegisterResponse* response) override {
+        int shm_fd = shm_open(request->key().c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+        if (shm_fd == -1) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "unable to open shared memory: " + request->key());
+        }
+        void* addr = mmap(NULL, request->byte_size(), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, request->offset());
+        close(shm_fd);
+        if (addr == MAP_FAILED) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "unable to map shared memory: " + request->key());
+        }
+        std::lock_guard<std::mutex> lock(regions_mtx_);
+        regions_[request->name()] = MockRegion{static_cast<uint8_t*>(addr), request->byte_size()};
+        LOG_INFO("MockTritonService registered shared memory %s, %ld bytes", request->name().c_str(), request->byte_size());
+        return Status::OK;
+    }
+
+    Status SystemSharedMemoryUnregister(ServerContext* context,
+                                        const inference::SystemSharedMemoryUnregisterRequest* request,
+                                        inference::SystemSharedMemoryUnregisterResponse* response) override {
+        std::lock_guard<std::mutex> lock(regions_mtx_);
+        for (auto it = regions_.begin(); it != regions_.end();) {
+            if (request->name().empty() || it->first == request->name()) {
+                munmap(it->second.addr_, it->second.byte_size_);
+                it = regions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return Status::OK;
+    }
+
+    Status ModelInfer(ServerContext* context, const inference::ModelInferRequest* request,
+                      inference::ModelInferResponse* response) override {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto it = models_.find(request->model_name());
+        if (it == models_.end()) {
+            return Status(grpc::StatusCode::NOT_FOUND, "unknown model: " + request->model_name());
+        }
+        const MockModel& model = it->second;
+        if (request->inputs_size() != 1 || request->inputs(0).shape_size() == 0) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "expecting 1 batched input");
+        }
+        int64_t batch_size = request->inputs(0).shape(0);
+        if (batch_size <= 0 || batch_size > max_batch_size_) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "batch size " + std::to_string(batch_size) + " out of range");
+        }
+
+        // the input is only used to seed the fake predictions
+        const uint8_t* input_data = nullptr;
+        size_t input_size = 0;
+        Status status = tensorData(request->inputs(0).parameters(),
+                                   request->raw_input_contents_size() > 0 ? &request->raw_input_contents(0) : nullptr,
+                                   &input_data, &input_size);
+        if (!status.ok()) {
+            return status;
+        }
+
+        simulateLatency(batch_size);
+
+        response->set_model_name(model.name_);
+        response->set_model_version("1");
+        response->set_id(request->id());
+        if (request->outputs_size() == 0) {
+            addLabels(response, model, batch_size, 0, input_data, input_size);
+            if (!model.feature_dims_.empty()) {
+                status = addFeatures(response, model, batch_size, nullptr);
+            }
+        }
+        for (const auto& output : request->outputs()) {
+            if (output.name() == kLabelName) {
+                auto class_it = output.parameters().find("classification");
+                int64_t class_count = class_it == output.parameters().end() ? 0 : class_it->second.int64_param();
+                addLabels(response, model, batch_size, class_count, input_data, input_size);
+            } else if (output.name() == kFeatureName && !model.feature_dims_.empty()) {
+                status = addFeatures(response, model, batch_size, &output);
+            } else {
+                status = Status(grpc::StatusCode::INVALID_ARGUMENT, "unknown output: " + output.name());
+            }
+            if (!status.ok()) {
+                return status;
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count();
+        LOG_INFO("MockTritonService infer request: %s, model: %s, batch size: %ld, time: %lf ms",
+                 request->id().c_str(), model.name_.c_str(), batch_size, duration);
+        return Status::OK;
+    }
+
+private:
+    using ParameterMap = google::protobuf::Map<std::string, inference::InferParameter>;
+
+    double batchLatency(int64_t batch_size) {
+        if (latency_table_.empty()) {
+            return base_ms_ + per_sample_ms_ * batch_size;
+        }
+        auto upper = latency_table_.lower_bound(batch_size);
+        if (upper == latency_table_.end()) {
+            return std::prev(upper)->second;
+        }
+        if (upper->first == batch_size || upper == latency_table_.begin()) {
+            return upper->second;
+        }
+        auto lower = std::prev(upper);
+        double ratio = double(batch_size - lower->first) / (upper->first - lower->first);
+        return lower->second + ratio * (upper->second - lower->second);
+    }
+
+    // sleeps for the latency of the batch, at most instances_ batches run
+    // at the same time like on a gpu with that many model instances
+    void simulateLatency(int64_t batch_size) {
+        thread_local std::mt19937 generator(std::random_device{}());
+        double latency = batchLatency(batch_size);
+        if (jitter_ms_ > 0) {
+            std::normal_distribution<double> jitter(0, jitter_ms_);
+            latency += jitter(generator);
+        }
+        if (straggler_prob_ > 0) {
+            std::bernoulli_distribution straggler(straggler_prob_);
+            if (straggler(generator)) {
+                latency += straggler_ms_;
+            }
+        }
+        latency = std::max(latency, 0.0);
+
+        std::unique_lock<std::mutex> lock(instances_mtx_);
+        instances_cv_.wait(lock, [this] { return running_ < instances_; });
+        running_++;
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(latency));
+        lock.lock();
+        running_--;
+        lock.unlock();
+        instances_cv_.notify_one();
+    }
+
+    // the data of a tensor either comes with the request or is in a
+    // registered shared memory region
+    Status tensorData(const ParameterMap& parameters, const std::string* raw,
+                      const uint8_t** data, size_t* byte_size) {
+        auto region_it = parameters.find("shared_memory_region");
+        if (region_it == parameters.end()) {
+            *data = raw == nullptr ? nullptr : reinterpret_cast<const uint8_t*>(raw->data());
+            *byte_size = raw == nullptr ? 0 : raw->size();
+            return Status::OK;
+        }
+        uint8_t* addr;
+        return sharedMemory(parameters, &addr, byte_size, data);
+    }
+
+    Status sharedMemory(const ParameterMap& parameters, uint8_t** addr, size_t* byte_size,
+                        const uint8_t** data = nullptr) {
+        const std::string& name = parameters.at("shared_memory_region").string_param();
+        auto size_it = parameters.find("shared_memory_byte_size");
+        auto offset_it = parameters.find("shared_memory_offset");
+        size_t size = size_it == parameters.end() ? 0 : size_it->second.int64_param();
+        size_t offset = offset_it == parameters.end() ? 0 : offset_it->second.int64_param();
+
+        std::lock_guard<std::mutex> lock(regions_mtx_);
+        auto it = regions_.find(name);
+        if (it == regions_.end()) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "unregistered shared memory: " + name);
+        }
+        if (offset + size > it->second.byte_size_) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "out of range of shared memory: " + name);
+        }
+        *addr = it->second.addr_ + offset;
+        *byte_size = size;
+        if (data != nullptr) {
+            *data = *addr;
+        }
+        return Status::OK;
+    }
+
+    // the classification output, 'class_count' strings "score:index" per
+    // sample sorted by score, or the raw scores when class_count is 0
+    void addLabels(inference::ModelInferResponse* response, const MockModel& model, int64_t batch_size,
+                   int64_t class_count, const uint8_t* input_data, size_t input_size) {
+        auto output = response->add_outputs();
+        output->set_name(kLabelName);
+        output->add_shape(batch_size);
+        std::string* contents = response->add_raw_output_contents();
+        size_t sample_size = batch_size > 0 ? input_size / batch_size : 0;
+        for (int64_t i = 0; i < batch_size; i++) {
+            // the predicted class follows the first byte of the sample
+            int top = 0;
+            if (input_data != nullptr && sample_size > 0) {
+                top = input_data[i * sample_size] % kNumClasses;
+            }
+            std::vector<float> scores(kNumClasses);
+            for (int c = 0; c < kNumClasses; c++) {
+                scores[c] = c == top ? 0.9f : 0.1f / (kNumClasses - 1);
+            }
+            if (class_count == 0) {
+                contents->append(reinterpret_cast<const char*>(scores.data()), scores.size() * sizeof(float));
+                continue;
+            }
+            std::vector<int> order(kNumClasses);
+            for (int c = 0; c < kNumClasses; c++) {
+                order[c] = c;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+            for (int64_t k = 0; k < std::min<int64_t>(class_count, kNumClasses); k++) {
+                std::string element = std::to_string(scores[order[k]]) + ":" + std::to_string(order[k]);
+                uint32_t len = element.size();
+                contents->append(reinterpret_cast<const char*>(&len), sizeof(len));
+                contents->append(element);
+            }
+        }
+        if (class_count == 0) {
+            output->set_datatype("FP32");
+            output->add_shape(kNumClasses);
+        } else {
+            output->set_datatype("BYTES");
+            output->add_shape(std::min<int64_t>(class_count, kNumClasses));
+        }
+    }
+
+    // the feature map of irevnet, written into shared memory when the
+    // request asks for it
+    Status addFeatures(inference::ModelInferResponse* response, const MockModel& model, int64_t batch_size,
+                       const inference::ModelInferRequest::InferRequestedOutputTensor* requested) {
+        thread_local std::mt19937 generator(std::random_device{}());
+        std::normal_distribution<float> value(0, 1);
+
+        size_t count = batch_size;
+        for (auto dim : model.feature_dims_) {
+            count *= dim;
+        }
+        auto output = response->add_outputs();
+        output->set_name(kFeatureName);
+        output->set_datatype("FP32");
+        output->add_shape(batch_size);
+        for (auto dim : model.feature_dims_) {
+            output->add_shape(dim);
+        }
+        // the client maps raw contents to the outputs by index, an output in
+        // shared memory keeps an empty entry
+        std::string* contents = response->add_raw_output_contents();
+
+        float* data;
+        if (requested != nullptr && requested->parameters().find("shared_memory_region") != requested->parameters().end()) {
+            uint8_t* addr;
+            size_t byte_size;
+            Status status = sharedMemory(requested->parameters(), &addr, &byte_size);
+            if (!status.ok()) {
+                return status;
+            }
+            if (byte_size < count * sizeof(float)) {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, "shared memory too small for " + kFeatureName);
+            }
+            data = reinterpret_cast<float*>(addr);
+            (*output->mutable_parameters())["shared_memory_region"] = requested->parameters().at("shared_memory_region");
+            (*output->mutable_parameters())["shared_memory_byte_size"].set_int64_param(count * sizeof(float));
+        } else {
+            contents->resize(count * sizeof(float));
+            data = reinterpret_cast<float*>(&(*contents)[0]);
+        }
+        for (size_t i = 0; i < count; i++) {
+            data[i] = value(generator);
+        }
+        return Status::OK;
+    }
+
+    std::shared_ptr<Config> conf_;
+    std::unordered_map<std::string, MockModel> models_;
+    int max_batch_size_;
+
+    double base_ms_;
+    double per_sample_ms_;
+    std::map<int64_t, double> latency_table_;
+    double jitter_ms_;
+    double straggler_prob_;
+    double straggler_ms_;
+
+    int instances_;
+    int running_;
+    std::mutex instances_mtx_;
+    std::condition_variable instances_cv_;
+
+    std::unordered_map<std::string, MockRegion> regions_;
+    std::mutex regions_mtx_;
+};
+
+void RunServer(const std::string& conf_path, int port) {
+    auto conf = std::make_shared<Config>(conf_path);
+    conf->parse();
+    if (port == 0) {
+        port = conf->mock_config.get("port", 8001).asInt();
+    }
+    std::string server_address("0.0.0.0:" + std::to_string(port));
+    MockTritonService service(conf);
+
+    ServerBuilder builder;
+    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    // the feature maps of a large batch exceed the default message size
+    builder.SetMaxReceiveMessageSize(INT32_MAX);
+    builder.SetMaxSendMessageSize(INT32_MAX);
+    builder.RegisterService(&service);
+    std::unique_ptr<Server> server(builder.BuildAndStart());
+    std::cout << "Mock triton server listening on " << server_address << std::endl;
+    server->Wait();
+}
+
+void usage() {
+    std::cout << "Usage: ./mock_triton_server conf_path [port]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2 && argc != 3) {
+        usage();
+        return 0;
+    }
+    std::string conf_path(argv[1]);
+    int port = argc == 3 ? std::stoi(argv[2]) : 0;
+    RunServer(conf_path, port);
+    return 0;
+}
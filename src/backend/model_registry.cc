@@ -0,0 +1,151 @@
+#include "model_registry.hh"
+
+/**
+ * ModelRegistry
+ *
+ */
+ModelRegistry::ModelRegistry(std::shared_ptr<Config> conf,
+                             std::shared_ptr<TritonPool> pool,
+                             std::shared_ptr<BatchScheduler> scheduler,
+                             std::shared_ptr<TorchEngine> torch_engine):
+                             conf_(conf),
+                             pool_(pool),
+                             scheduler_(scheduler),
+                             torch_engine_(torch_engine)
+{
+    // the models are loaded at once, addModel then finds them ready. A
+    // triton endpoint still answers for its models one at a time
+    std::vector<std::thread> loaders;
+    for (const auto& model_name : conf_->model_names) {
+        if (DATASETS.find(model_name) == DATASETS.end()) {
+            continue;
+        }
+        loaders.emplace_back([this, model_name] {
+            if (torch_engine_ != nullptr) {
+                torch_engine_->LoadModel(model_name);
+            } else {
+                pool_->LoadModel(model_name);
+            }
+        });
+    }
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    for (const auto& model_name : conf_->model_names) {
+        addModel(model_name);
+    }
+}
+
+ModelRegistry::~ModelRegistry() {}
+
+void ModelRegistry::addModel(const std::string& model_name) {
+    if (models_.find(model_name) != models_.end()) {
+        return;
+    }
+    if (DATASETS.find(model_name) == DATASETS.end()) {
+        LOG_ERROR("model %s is not in DATASETS, skip it", model_name.c_str());
+        return;
+    }
+    auto entry = std::make_unique<ModelEntry>();
+    entry->model_name_ = model_name;
+
+    // the batch sizes of a model can be overridden under batch_config.models
+    entry->batch_size_1_ = conf_->batch_size_1;
+    entry->batch_size_2_ = conf_->batch_size_2;
+    entry->max_queue_delay_us_ = conf_->max_queue_delay_us;
+    auto model_batch_config = conf_->batch_config.isObject() ?
+        conf_->batch_config.get("models", Json::Value()).get(model_name, Json::Value()) : Json::Value();
+    if (model_batch_config.isObject()) {
+        entry->batch_size_1_ = model_batch_config.get("batch_size_1", entry->batch_size_1_).asInt();
+        entry->batch_size_2_ = model_batch_config.get("batch_size_2", entry->batch_size_2_).asInt();
+        entry->max_queue_delay_us_ = model_batch_config.get("max_queue_delay_us", entry->max_queue_delay_us_).asInt();
+    }
+
+    // fetch the metadata of the model once, before any query arrives. The
+    // in-process engine takes batches of any size
+    int max_batch_size = std::max({entry->batch_size_1_, entry->batch_size_2_, 1,
+                                   conf_->batch_mode == "auto" ? int(conf_->max_batch_size) : 1});
+    if (torch_engine_ != nullptr) {
+        if (!torch_engine_->LoadModel(model_name)) {
+            LOG_ERROR("model %s can not be loaded, skip it", model_name.c_str());
+            return;
+        }
+    } else {
+        max_batch_size = pool_->LoadModel(model_name);
+    }
+    entry->max_batch_size_ = max_batch_size;
+    entry->recompute_batch_size_ = conf_->recompute_batch_size > 0 ?
+        std::min<int>(conf_->recompute_batch_size, max_batch_size) : max_batch_size;
+    if (conf_->use_shm && torch_engine_ == nullptr) {
+        entry->shm_ring_ = pool_->EnableSharedMemory(model_name, conf_->shm_slots);
+    }
+
+    entry->profile_ = std::make_shared<LatencyProfile>(std::max(entry->batch_size_1_, entry->batch_size_2_));
+    entry->rep_recv_queue_ = std::make_shared<SingleQueryQueue>();
+    entry->cdc_recv_queue_ = std::make_shared<SingleQueryQueue>();
+    entry->recompute_recv_queue_ = std::make_shared<SingleQueryQueue>();
+
+    entry->rep_batch_worker_ = std::make_shared<BatchWorker>(conf_, entry->batch_size_1_, entry->max_queue_delay_us_,
+        entry->rep_recv_queue_,
+        scheduler_, entry->shm_ring_);
+    entry->cdc_batch_worker_ = std::make_shared<BatchWorker>(conf_, entry->batch_size_2_, entry->max_queue_delay_us_,
+        entry->cdc_recv_queue_,
+        scheduler_, entry->shm_ring_);
+    entry->recompute_batch_worker_ = std::make_shared<BatchWorker>(conf_, entry->recompute_batch_size_,
+        conf_->recompute_queue_delay_us,
+        entry->recompute_recv_queue_,
+        scheduler_, entry->shm_ring_);
+
+    LOG_INFO("ModelRegistry add model: %s, backup batch size: %d, cdc batch size: %d, recompute batch size: %d, max queue delay: %d us",
+             model_name.c_str(), entry->batch_size_1_, entry->batch_size_2_, entry->recompute_batch_size_,
+             entry->max_queue_delay_us_);
+    models_[model_name] = entry.get();
+    model_names_.push_back(model_name);
+    entries_.push_back(std::move(entry));
+}
+
+ModelEntry* ModelRegistry::Get(const std::string& model_name) {
+    auto it = models_.find(model_name);
+    if (it == models_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void ModelRegistry::Drain() {
+    for (auto& entry : entries_) {
+        entry->rep_batch_worker_->Drain();
+        entry->cdc_batch_worker_->Drain();
+        entry->recompute_batch_worker_->Drain();
+    }
+}
+
+void ModelRegistry::Dispatch(SingleQuery* query) {
+    // the queries of each model are batched separately
+    ModelEntry* model = Get(query->model_name_);
+    if (model == nullptr) {
+        LOG_ERROR("model %s is not served by this backend, drop query: %d", query->model_name_.c_str(), query->id_);
+        delete query;
+        return;
+    }
+    if (query->recompute_) {
+        model->recompute_recv_queue_->Push(query);
+    }
+    else if (query->end_signal_) {
+        // each batcher drops its own copy
+        model->rep_recv_queue_->Push(new SingleQuery(query->model_name_, query->scale_, query->filename_,
+                                                     query->id_, std::string(), query->encode_type_,
+                                                     query->stream_, query->front_id_, true, false));
+        model->cdc_recv_queue_->Push(query);
+    }
+    else if (query->encode_type_ == "Backup") {
+        model->rep_recv_queue_->Push(query);
+    }
+    else if (query->encode_type_ == "CDC") {
+        model->cdc_recv_queue_->Push(query);
+    }
+    else {
+        LOG_ERROR("unknown encode type %s, drop query: %d", query->encode_type_.c_str(), query->id_);
+        delete query;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "../inc/inc.hh"
+#include "../common/logger.hh"
+#include "../common/conf.hh"
+#include "image_classify.hh"
+#include "worker.hh"
+#include "triton_pool.hh"
+#include "torch_engine.hh"
+#include "batch_controller.hh"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ModelEntry
+ * The receive queues and batchers of one served model, so that every batch
+ * only holds queries of a single model.
+ */
+struct ModelEntry {
+    std::string model_name_;
+    int batch_size_1_;
+    int batch_size_2_;
+    int max_queue_delay_us_;
+    int recompute_batch_size_;
+    // the largest batch the engine accepts
+    int max_batch_size_;
+
+    std::shared_ptr<SingleQueryQueue> rep_recv_queue_;
+
+    std::shared_ptr<SingleQueryQueue> cdc_recv_queue_;
+    // the recomputes of the broken stripes, batched together
+    std::shared_ptr<SingleQueryQueue> recompute_recv_queue_;
+
+    std::shared_ptr<ShmRing> shm_ring_;
+
+    std::shared_ptr<BatchWorker> rep_batch_worker_;
+    std::shared_ptr<BatchWorker> cdc_batch_worker_;
+    std::shared_ptr<BatchWorker> recompute_batch_worker_;
+    // triton latency of the model against the batch size
+    std::shared_ptr<LatencyProfile> profile_;
+};
+
+/**
+ * ModelRegistry
+ * The models served by the backend, keyed by model name. The batchers of all
+ * the models hand their batches to the same BatchScheduler.
+ */
+class ModelRegistry {
+public:
+    // the models are loaded by 'torch_engine' when it is set, by the
+    // endpoints of 'pool' otherwise
+    ModelRegistry(std::shared_ptr<Config> conf,
+                  std::shared_ptr<TritonPool> pool,
+                  std::shared_ptr<BatchScheduler> scheduler,
+                  std::shared_ptr<TorchEngine> torch_engine = nullptr);
+    ~ModelRegistry();
+
+    // returns nullptr if the model is not served by this backend
+    ModelEntry* Get(const std::string& model_name);
+    // pushes 'query' to the receive queue of its model and class, the
+    // queries of the models not served are dropped. Thread safe
+    void Dispatch(SingleQuery* query);
+    // the batchers of every model stop waiting for full batches
+    void Drain();
+    const std::vector<std::string>& ModelNames() const { return model_names_; }
+
+private:
+    void addModel(const std::string& model_name);
+
+    std::shared_ptr<Config> conf_;
+    std::shared_ptr<TritonPool> pool_;
+    std::shared_ptr<BatchScheduler> scheduler_;
+    std::shared_ptr<TorchEngine> torch_engine_;
+
+    std::vector<std::string> model_names_;
+    std::vector<std::unique_ptr<ModelEntry>> entries_;
+    std::unordered_map<std::string, ModelEntry*> models_;
+};
@@ -4,6 +4,28 @@
 #include <memory>
 #include <string>
 #include "image_classify.hh"
+#include "shm_ring.hh"
+#include "batch_buffer.hh"
+#include "reply_stream.hh"
+
+namespace triton { namespace client {
+class InferResult;
+}}
+
+/**
+ * ReplyView
+ * The reply of one sample. It points into the outputs of its batch, which
+ * stay alive until the BatchQuery releases them.
+ */
+struct ReplyView {
+    const uint8_t* feature_;
+    size_t feature_size_;
+    const char* label_;
+    size_t label_size_;
+    // the top classes of the sample, best first, label_ is the first one
+    const std::pair<const char*, size_t>* classes_;
+    size_t class_num_;
+};
 
 class Query {
 public:
@@ -26,22 +48,32 @@ public:
                 std::string scale,
                 std::string filename,
                 int id,
-                std::vector<uint8_t> data,
+                std::string data,
                 std::string encode_type,
-                grpcStream* stream,
+                ReplyStream* stream,
                 int front_id,
                 bool end_signal,
                 bool recompute) {
-        model_name_ = model_name;
-        scale_ = scale;
-        filename_ = filename;
+        model_name_ = std::move(model_name);
+        scale_ = std::move(scale);
+        filename_ = std::move(filename);
         id_ = id;
-        data_ = data;
-        encode_type_ = encode_type;
+        data_ = std::move(data);
+        encode_type_ = std::move(encode_type);
         stream_ = stream;
         front_id_ = front_id;
         end_signal_ = end_signal;
         recompute_ = recompute;
+        arrival_time_ = std::chrono::steady_clock::now();
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        if (stream_ != nullptr) {
+            stream_->Ref();
+        }
+    }
+    ~SingleQuery() {
+        if (stream_ != nullptr) {
+            stream_->Unref();
+        }
     }
     // SingleQuery(const ImageArgs& request) {
     //     model_name_ = request.model_name;
@@ -54,9 +86,25 @@ public:
     //     front_id_ = request.front_id;
     //     end_signal_ = request.end_signal;
     // }
-    grpcStream* stream_;
-    std::vector<uint8_t> data_;
+    ReplyStream* stream_;
+    // the payload moved out of the request, it is copied once into the
+    // input of its batch
+    std::string data_;
     std::string reply_info_;
+    // when the query entered the backend, a partial batch is flushed once
+    // its oldest query waited for max_queue_delay_us
+    std::chrono::steady_clock::time_point arrival_time_;
+    // when the frontend needs the reply, max() if it did not say
+    std::chrono::steady_clock::time_point deadline_;
+    // the key of the result in the result cache, empty if not cached
+    std::string cache_key_;
+    // the classes in the reply, without the feature map, 0 for the full
+    // reply
+    uint32_t top_k_ = 0;
+    // the feature map is kept by the backend instead of being sent
+    bool retain_ = false;
+    // data_ is the encoded image until the PreprocessWorker expands it
+    bool compressed_ = false;
 };
 
 class BatchQuery: public Query {
@@ -65,25 +113,93 @@ public:
                 std::string scale,
                 std::vector<std::string> filenames, 
                 int id, 
-                std::vector<std::vector<uint8_t>> data,
-                std::vector<grpcStream*> streams,
+                std::vector<ReplyStream*> streams,
                 std::string encode_type,
                 std::vector<int> ids) 
     {
-        model_name_ = model_name;
-        scale_ = scale;
-        filenames_ = filenames;
+        model_name_ = std::move(model_name);
+        scale_ = std::move(scale);
+        filenames_ = std::move(filenames);
         id_ = id;
-        data_ = data;
-        batch_size_ = data.size();
-        streams_ = streams;
-        encode_type_ = encode_type;
-        ids_ = ids;
+        batch_size_ = ids.size();
+        streams_ = std::move(streams);
+        encode_type_ = std::move(encode_type);
+        ids_ = std::move(ids);
+        input_ = nullptr;
+        shm_slot_ = nullptr;
+        end_signal_ = false;
+        recompute_ = false;
+        rejected_ = false;
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        for (auto stream : streams_) {
+            if (stream != nullptr) {
+                stream->Ref();
+            }
+        }
+    }
+    ~BatchQuery() {
+        for (auto stream : streams_) {
+            if (stream != nullptr) {
+                stream->Unref();
+            }
+        }
     }
     std::vector<int> ids_;
     std::vector<std::string> filenames_;
-    std::vector<std::vector<uint8_t>> data_;
-    std::vector<grpcStream*> streams_;
+    // the samples of the batch back to back, unless they are in shm_slot_
+    BatchBuffer* input_;
+    std::vector<ReplyStream*> streams_;
     int batch_size_;
-    std::vector<std::string> reply_info_;
+    std::vector<ReplyView> reply_views_;
+    // the outputs the views refer to
+    std::shared_ptr<triton::client::InferResult> result_;
+    // or the outputs of the in-process engine
+    std::shared_ptr<void> engine_outputs_;
+    std::vector<std::string> labels_;
+    // the classes of all the samples, the views point into them
+    std::vector<std::pair<const char*, size_t>> classes_;
+    // the input of the batch is already in this slot when it is set
+    ShmSlot* shm_slot_;
+    // the earliest deadline of its queries, the BatchScheduler serves the
+    // batches by it under the edf policy
+    std::chrono::steady_clock::time_point deadline_;
+    // when the batch was handed to the BatchScheduler
+    std::chrono::steady_clock::time_point enqueue_time_;
+    // when its oldest query reached the backend
+    std::chrono::steady_clock::time_point arrival_time_;
+    // the ReplyWorker stores the reply of every sample under its key
+    std::vector<std::string> cache_keys_;
+    // the top_k_ of every sample
+    std::vector<uint32_t> top_ks_;
+    // the retain_ and the frontend of every sample, the retained features
+    // are stored by both
+    std::vector<bool> retains_;
+    std::vector<uint32_t> front_ids_;
+    // set by the BatchScheduler once a draining backend gives up, the batch
+    // is not inferred and its queries are answered as rejected
+    bool rejected_;
+
+    // true when no sample of the batch replies with the feature map, which
+    // need not be computed then
+    bool classesOnly() const {
+        return !top_ks_.empty() && std::all_of(top_ks_.begin(), top_ks_.end(),
+                                               [](uint32_t top_k) { return top_k > 0; });
+    }
+
+    // called once the replies are written
+    void releaseOutputs() {
+        reply_views_.clear();
+        labels_.clear();
+        classes_.clear();
+        result_.reset();
+        engine_outputs_.reset();
+        if (input_ != nullptr) {
+            input_->pool_->Release(input_);
+            input_ = nullptr;
+        }
+        if (shm_slot_ != nullptr) {
+            shm_slot_->ring_->Release(shm_slot_);
+            shm_slot_ = nullptr;
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "../inc/inc.hh"
+#include <atomic>
+#include <mutex>
+
+/**
+ * ReplyStream
+ * Where the replies to the queries of one frontend stream are written. The
+ * queries only keep this pointer, so the ReplyWorker does not depend on
+ * whether the stream is served by the sync or the async server.
+ *
+ * Every query that may reply to the stream holds a reference until it is
+ * deleted, after its reply is written, and the server holds one until the
+ * stream ends. unreferenced() is called once only the server's is left,
+ * released() once that one is dropped too, nothing writes to the stream
+ * then.
+ */
+class ReplyStream {
+public:
+    ReplyStream() : refs_(1) {}
+    virtual ~ReplyStream() {}
+    // returns false if the reply could not be sent, e.g. the stream is closed
+    virtual bool Write(const ElasticcdcReply& reply) = 0;
+
+    void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+    void Unref() {
+        int left = refs_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (left == 0) {
+            released();
+        } else if (left == 1) {
+            unreferenced();
+        }
+    }
+
+protected:
+    // true while a query may still write a reply to the stream
+    bool referenced() const { return refs_.load(std::memory_order_acquire) > 1; }
+    // the last query that referred to the stream is gone
+    virtual void unreferenced() {}
+    // the stream may be freed here, it is not touched afterwards
+    virtual void released() {}
+
+private:
+    std::atomic<int> refs_;
+};
+
+/**
+ * SyncReplyStream
+ * A stream of the sync server, the grpc stream does not allow concurrent
+ * writes from the reply worker and a cache hit, so they are serialized.
+ */
+class SyncReplyStream : public ReplyStream {
+public:
+    SyncReplyStream(grpcStream* stream) : stream_(stream) {}
+
+    bool Write(const ElasticcdcReply& reply) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stream_->Write(reply);
+    }
+
+private:
+    grpcStream* stream_;
+    std::mutex mutex_;
+};
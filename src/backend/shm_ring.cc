@@ -0,0 +1,95 @@
+#include "shm_ring.hh"
+#include "../common/logger.hh"
+#include "shm_utils.h"
+#include <unistd.h>
+
+namespace tc = triton::client;
+
+/**
+ * ShmRing
+ *
+ */
+ShmRing::ShmRing(const std::string& name, size_t slot_num, size_t max_batch_size,
+                 size_t input_size, size_t output_size):
+                 name_(name),
+                 max_batch_size_(max_batch_size),
+                 input_size_(input_size),
+                 output_size_(output_size),
+                 input_slot_size_(max_batch_size * input_size),
+                 input_base_(nullptr),
+                 output_slot_size_(max_batch_size * output_size),
+                 output_base_(nullptr)
+{
+    // the keys are unique per process so that several backends can share
+    // one triton server
+    std::string suffix = name + "_" + std::to_string(getpid());
+    input_region_ = "input_" + suffix;
+    input_key_ = "/input_" + suffix;
+    output_region_ = "output_" + suffix;
+    output_key_ = "/output_" + suffix;
+
+    slots_.resize(slot_num);
+    input_base_ = createRegion(input_key_, InputRegionSize());
+    if (output_slot_size_ > 0) {
+        output_base_ = createRegion(output_key_, OutputRegionSize());
+    }
+
+    for (size_t i = 0; i < slot_num; i++) {
+        ShmSlot& slot = slots_[i];
+        slot.ring_ = this;
+        slot.index_ = i;
+        slot.input_offset_ = i * input_slot_size_;
+        slot.input_ = input_base_ + slot.input_offset_;
+        slot.output_offset_ = i * output_slot_size_;
+        slot.output_ = output_base_ == nullptr ? nullptr : output_base_ + slot.output_offset_;
+        free_slots_.push_back(&slot);
+    }
+    LOG_INFO("ShmRing created, slots: %ld, input slot: %ld bytes, output slot: %ld bytes",
+             slot_num, input_slot_size_, output_slot_size_);
+}
+
+ShmRing::~ShmRing() {
+    destroyRegion(input_key_, input_base_, InputRegionSize());
+    if (output_base_ != nullptr) {
+        destroyRegion(output_key_, output_base_, OutputRegionSize());
+    }
+}
+
+uint8_t* ShmRing::createRegion(const std::string& key, size_t byte_size) {
+    int shm_fd;
+    tc::Error err = tc::CreateSharedMemoryRegion(key, byte_size, &shm_fd);
+    if (!err.IsOk()) {
+        LOG_ERROR("failed to create shared memory %s: %s", key.c_str(), err.Message().c_str());
+        exit(1);
+    }
+    void* addr;
+    err = tc::MapSharedMemory(shm_fd, 0, byte_size, &addr);
+    if (!err.IsOk()) {
+        LOG_ERROR("failed to map shared memory %s: %s", key.c_str(), err.Message().c_str());
+        exit(1);
+    }
+    // the mapping stays valid after the descriptor is closed
+    tc::CloseSharedMemory(shm_fd);
+    return static_cast<uint8_t*>(addr);
+}
+
+void ShmRing::destroyRegion(const std::string& key, uint8_t* addr, size_t byte_size) {
+    tc::UnmapSharedMemory(addr, byte_size);
+    tc::UnlinkSharedMemoryRegion(key);
+}
+
+ShmSlot* ShmRing::Acquire() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return !free_slots_.empty(); });
+    ShmSlot* slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+void ShmRing::Release(ShmSlot* slot) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        free_slots_.push_back(slot);
+    }
+    cv_.notify_one();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ShmRing;
+
+/**
+ * One input/output slot of the ring. A batch is written into input_ by the
+ * BatchWorker and triton writes the outputs of the batch into output_.
+ */
+struct ShmSlot {
+    ShmRing* ring_;
+    int index_;
+    uint8_t* input_;
+    size_t input_offset_;
+    uint8_t* output_;
+    size_t output_offset_;
+};
+
+/**
+ * A fixed number of slots over two system shared memory regions (inputs and
+ * outputs) shared with a co-located triton server. The regions are created
+ * once and registered with triton by the TritonSession.
+ */
+class ShmRing {
+public:
+    // every slot holds up to 'max_batch_size' samples of 'input_size' bytes
+    // and their outputs of 'output_size' bytes
+    ShmRing(const std::string& name, size_t slot_num, size_t max_batch_size,
+            size_t input_size, size_t output_size);
+    ~ShmRing();
+
+    // blocks until a slot is free
+    ShmSlot* Acquire();
+    void Release(ShmSlot* slot);
+
+    const std::string& Name() const { return name_; }
+    size_t MaxBatchSize() const { return max_batch_size_; }
+    size_t SampleInputSize() const { return input_size_; }
+    size_t SampleOutputSize() const { return output_size_; }
+
+    const std::string& InputRegion() const { return input_region_; }
+    const std::string& InputKey() const { return input_key_; }
+    size_t InputRegionSize() const { return input_slot_size_ * slots_.size(); }
+    size_t InputSlotSize() const { return input_slot_size_; }
+
+    const std::string& OutputRegion() const { return output_region_; }
+    const std::string& OutputKey() const { return output_key_; }
+    size_t OutputRegionSize() const { return output_slot_size_ * slots_.size(); }
+    size_t OutputSlotSize() const { return output_slot_size_; }
+
+private:
+    uint8_t* createRegion(const std::string& key, size_t byte_size);
+    void destroyRegion(const std::string& key, uint8_t* addr, size_t byte_size);
+
+    std::string name_;
+    size_t max_batch_size_;
+    size_t input_size_;
+    size_t output_size_;
+
+    std::string input_region_;
+    std::string input_key_;
+    size_t input_slot_size_;
+    uint8_t* input_base_;
+
+    std::string output_region_;
+    std::string output_key_;
+    size_t output_slot_size_;
+    uint8_t* output_base_;
+
+    std::vector<ShmSlot> slots_;
+    std::vector<ShmSlot*> free_slots_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
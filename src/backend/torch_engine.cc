@@ -0,0 +1,173 @@
+#include "torch_engine.hh"
+#include <cstdio>
+
+// the classes kept per sample, as many as a TritonSession asks for
+static const int64_t kTorchEngineTopK = 10;
+
+/**
+ * TorchEngine
+ *
+ */
+TorchEngine::TorchEngine(std::shared_ptr<Config> conf): conf_(conf) {
+    // the thread pools of libtorch are global to the process
+    if (conf_->intra_op_threads > 0) {
+        torch::set_num_threads(conf_->intra_op_threads);
+    }
+    if (conf_->inter_op_threads > 0) {
+        try {
+            torch::set_num_interop_threads(conf_->inter_op_threads);
+        } catch (const c10::Error& e) {
+            // it can only be set before the first parallel work
+            LOG_ERROR("TorchEngine failed to set the inter-op threads: %s", e.what());
+        }
+    }
+    LOG_INFO("TorchEngine created, model dir: %s, intra-op threads: %d, inter-op threads: %d",
+             conf_->torch_model_dir.c_str(), conf_->intra_op_threads, conf_->inter_op_threads);
+}
+
+TorchEngine::~TorchEngine() {}
+
+bool TorchEngine::LoadModel(const std::string& model_name) {
+    if (getModel(model_name) != nullptr) {
+        return true;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    auto model = std::make_unique<TorchModel>();
+    std::string path = conf_->torch_model_dir + "/" + model_name + ".pt";
+    try {
+        model->module_ = torch::jit::load(path, torch::kCPU);
+        model->module_.eval();
+    } catch (const c10::Error& e) {
+        LOG_ERROR("TorchEngine failed to load %s: %s", path.c_str(), e.what());
+        return false;
+    }
+
+    model->input_shape_ = {conf_->channels, conf_->height, conf_->width};
+    auto shapes = conf_->triton_config.get("torch_input_shapes", Json::Value());
+    auto shape = shapes.isObject() ? shapes.get(model_name, Json::Value()) : Json::Value();
+    if (shape.isArray() && shape.size() > 0) {
+        model->input_shape_.clear();
+        for (Json::Value::ArrayIndex i = 0; i < shape.size(); ++i) {
+            model->input_shape_.push_back(shape[i].asInt64());
+        }
+    }
+    model->input_byte_size_ = sizeof(float);
+    for (auto dim : model->input_shape_) {
+        model->input_byte_size_ *= dim;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count();
+    LOG_INFO("Torch model %s loaded in %lf ms, sample input: %ld bytes",
+             model_name.c_str(), duration, model->input_byte_size_);
+    std::lock_guard<std::mutex> lock(models_mutex_);
+    models_.emplace(model_name, std::move(model));
+    return true;
+}
+
+size_t TorchEngine::SampleInputSize(const std::string& model_name) {
+    TorchModel* model = getModel(model_name);
+    return model != nullptr ? model->input_byte_size_ : 0;
+}
+
+TorchModel* TorchEngine::getModel(const std::string& model_name) {
+    std::lock_guard<std::mutex> lock(models_mutex_);
+    auto it = models_.find(model_name);
+    if (it == models_.end()) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+int TorchEngine::Infer(BatchQuery& batchq) {
+    auto start = std::chrono::high_resolution_clock::now();
+    int batch_size = batchq.batch_size_;
+    batchq.reply_views_.assign(batch_size, ReplyView{nullptr, 0, nullptr, 0, nullptr, 0});
+
+    TorchModel* model = getModel(batchq.model_name_);
+    if (model == nullptr) {
+        LOG_ERROR("TorchEngine: model %s is not loaded, batch: %d", batchq.model_name_.c_str(), batchq.id_);
+        return -1;
+    }
+    size_t input_size = batchq.input_ != nullptr ? batchq.input_->Size() : 0;
+    if (input_size != batch_size * model->input_byte_size_) {
+        LOG_ERROR("TorchEngine: batch %d has %ld bytes, expected %ld",
+                  batchq.id_, input_size, batch_size * model->input_byte_size_);
+        return -1;
+    }
+
+    // the tensor only points to the batch input, which outlives the call
+    std::vector<int64_t> shape = {batch_size};
+    shape.insert(shape.end(), model->input_shape_.begin(), model->input_shape_.end());
+    torch::Tensor input = torch::from_blob(const_cast<uint8_t*>(batchq.input_->Data()), shape, torch::kFloat32);
+
+    torch::Tensor logits;
+    torch::Tensor features;
+    try {
+        torch::InferenceMode guard;
+        std::vector<torch::jit::IValue> inputs = {input};
+        auto output = model->module_.forward(inputs);
+        if (output.isTuple()) {
+            auto elements = output.toTuple()->elements();
+            logits = elements[0].toTensor();
+            if (elements.size() > 1) {
+                features = elements[1].toTensor();
+            }
+        } else {
+            logits = output.toTensor();
+        }
+        logits = logits.to(torch::kFloat32).reshape({batch_size, -1}).contiguous();
+        if (features.defined()) {
+            features = features.to(torch::kFloat32).reshape({batch_size, -1}).contiguous();
+        }
+    } catch (const c10::Error& e) {
+        LOG_ERROR("TorchEngine: batch %d of %s failed: %s", batchq.id_, batchq.model_name_.c_str(), e.what());
+        return -1;
+    }
+    auto infer_end = std::chrono::high_resolution_clock::now();
+
+    // the top classes of a sample, best first, as the classification
+    // output of triton
+    int64_t k = std::min(kTorchEngineTopK, logits.size(1));
+    auto top = logits.topk(k, 1);
+    torch::Tensor scores = std::get<0>(top).contiguous();
+    torch::Tensor indices = std::get<1>(top).contiguous();
+    const float* score = scores.data_ptr<float>();
+    const int64_t* index = indices.data_ptr<int64_t>();
+    batchq.labels_.resize(batch_size * k);
+    batchq.classes_.resize(batch_size * k);
+    for (int64_t j = 0; j < batch_size * k; j++) {
+        char label[64];
+        int size = snprintf(label, sizeof(label), "%f:%ld", score[j], index[j]);
+        batchq.labels_[j].assign(label, size);
+        batchq.classes_[j] = {batchq.labels_[j].data(), batchq.labels_[j].size()};
+    }
+    for (int i = 0; i < batch_size && k > 0; i++) {
+        ReplyView& view = batchq.reply_views_[i];
+        view.classes_ = &batchq.classes_[i * k];
+        view.class_num_ = k;
+        view.label_ = view.classes_[0].first;
+        view.label_size_ = view.classes_[0].second;
+    }
+
+    // the views point into the feature map, the batch keeps it until the
+    // replies are written
+    if (features.defined()) {
+        size_t feature_size = features.size(1) * sizeof(float);
+        const uint8_t* feature_bytes = reinterpret_cast<const uint8_t*>(features.data_ptr<float>());
+        for (int i = 0; i < batch_size; i++) {
+            batchq.reply_views_[i].feature_ = feature_bytes + i * feature_size;
+            batchq.reply_views_[i].feature_size_ = feature_size;
+        }
+        batchq.engine_outputs_ = std::make_shared<torch::Tensor>(features);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double infer_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                        (infer_end - start).count();
+    double parse_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                        (end - infer_end).count();
+    LOG_INFO("TorchEngine batch: %d, size: %d, infer time: %lf ms, parse time: %lf ms",
+             batchq.id_, batch_size, infer_time, parse_time);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "../inc/inc.hh"
+#include "../common/logger.hh"
+#include "../common/conf.hh"
+#include "worker.hh"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * TorchModel
+ * A TorchScript module loaded in the backend process, and the shape of one
+ * sample of its input.
+ */
+struct TorchModel {
+    torch::jit::script::Module module_;
+    std::vector<int64_t> input_shape_;
+    size_t input_byte_size_;
+};
+
+/**
+ * TorchEngine
+ * Runs the batches on the cpu of the backend instead of sending them to a
+ * triton server, which saves the network hop and the serialization of every
+ * batch. The models are TorchScript files, <torch_model_dir>/<model>.pt,
+ * that take a float batch and return the logits, or a tuple of the logits
+ * and the feature map. The shape of a sample is the preprocess config one,
+ * or triton_config.torch_input_shapes.<model> when set.
+ * The replies are laid out as with triton: the feature map if any, then the
+ * top class as "score:index", and the top 10 classes are kept for the
+ * top-k replies.
+ */
+class TorchEngine {
+public:
+    TorchEngine(std::shared_ptr<Config> conf);
+    ~TorchEngine();
+
+    // loads the model once, before any query arrives. Several models can
+    // be loaded at once
+    bool LoadModel(const std::string& model_name);
+    // the bytes of one sample of the input, 0 if the model is not loaded
+    size_t SampleInputSize(const std::string& model_name);
+    // fills the reply_views_ of the batch, see BatchQuery::releaseOutputs.
+    // The InferWorkers run their batches concurrently, each one on the
+    // intra-op threads of libtorch. The views are left empty on failure
+    int Infer(BatchQuery& batchq);
+
+private:
+    TorchModel* getModel(const std::string& model_name);
+
+    std::shared_ptr<Config> conf_;
+    std::unordered_map<std::string, std::unique_ptr<TorchModel>> models_;
+    std::mutex models_mutex_;
+};
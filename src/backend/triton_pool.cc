@@ -0,0 +1,83 @@
+#include "triton_pool.hh"
+
+/**
+ * TritonPool
+ *
+ */
+TritonPool::TritonPool(const std::vector<std::string>& urls, double latency_alpha):
+                       latency_alpha_(latency_alpha)
+{
+    for (const auto& url : urls) {
+        TritonEndpoint endpoint;
+        endpoint.session_ = std::make_shared<TritonSession>(url);
+        endpoint.outstanding_ = 0;
+        endpoint.latency_ms_ = 0;
+        endpoint.batch_num_ = 0;
+        endpoints_.push_back(endpoint);
+    }
+    LOG_INFO("TritonPool created with %ld endpoints", endpoints_.size());
+}
+
+TritonPool::~TritonPool() {}
+
+TritonSession* TritonPool::Acquire() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // the expected finish time of a new batch on an endpoint is roughly its
+    // queue length times its latency, an endpoint without any measurement
+    // yet is tried first
+    size_t best = 0;
+    double best_cost = -1;
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        auto& endpoint = endpoints_[i];
+        double cost = (endpoint.outstanding_ + 1) * endpoint.latency_ms_;
+        if (best_cost < 0 || cost < best_cost ||
+            (cost == best_cost && endpoint.outstanding_ < endpoints_[best].outstanding_)) {
+            best = i;
+            best_cost = cost;
+        }
+    }
+    endpoints_[best].outstanding_++;
+    return endpoints_[best].session_.get();
+}
+
+void TritonPool::Release(TritonSession* session, double latency_ms) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& endpoint : endpoints_) {
+        if (endpoint.session_.get() != session) {
+            continue;
+        }
+        endpoint.outstanding_--;
+        endpoint.batch_num_++;
+        if (endpoint.batch_num_ == 1) {
+            endpoint.latency_ms_ = latency_ms;
+        } else {
+            endpoint.latency_ms_ = latency_alpha_ * latency_ms + (1 - latency_alpha_) * endpoint.latency_ms_;
+        }
+        LOG_INFO("TritonPool endpoint: %s, outstanding: %d, latency: %lf ms, avg latency: %lf ms, batches: %ld",
+                 session->Url().c_str(), endpoint.outstanding_, latency_ms, endpoint.latency_ms_, endpoint.batch_num_);
+        return;
+    }
+}
+
+int TritonPool::LoadModel(const std::string& model_name) {
+    std::vector<std::thread> loaders;
+    for (auto& endpoint : endpoints_) {
+        loaders.emplace_back([&endpoint, &model_name] { endpoint.session_->GetModel(model_name); });
+    }
+    int max_batch_size = 0;
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        loaders[i].join();
+        // 0 for a model without batching
+        int endpoint_max = std::max(endpoints_[i].session_->GetModel(model_name)->info_.max_batch_size_, 1);
+        max_batch_size = max_batch_size == 0 ? endpoint_max : std::min(max_batch_size, endpoint_max);
+    }
+    return std::max(max_batch_size, 1);
+}
+
+std::shared_ptr<ShmRing> TritonPool::EnableSharedMemory(const std::string& model_name, size_t slot_num) {
+    auto ring = endpoints_[0].session_->CreateSharedMemory(model_name, slot_num);
+    for (auto& endpoint : endpoints_) {
+        endpoint.session_->RegisterSharedMemory(model_name, ring);
+    }
+    return ring;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "../common/logger.hh"
+#include "image_classify.hh"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * TritonEndpoint
+ * One triton server of the pool and the load it currently has.
+ */
+struct TritonEndpoint {
+    std::shared_ptr<TritonSession> session_;
+    // batches sent to the endpoint and not answered yet
+    int outstanding_;
+    // moving average of the batch latency in ms, 0 before the first batch
+    double latency_ms_;
+    uint64_t batch_num_;
+};
+
+/**
+ * TritonPool
+ * The triton servers a backend can send batches to. A batch goes to the
+ * endpoint with the fewest outstanding batches, weighted by the latency of
+ * the endpoint so that a slow replica gets less work.
+ */
+class TritonPool {
+public:
+    TritonPool(const std::vector<std::string>& urls, double latency_alpha = 0.2);
+    ~TritonPool();
+
+    // picks an endpoint for the next batch, to be given back with Release
+    TritonSession* Acquire();
+    void Release(TritonSession* session, double latency_ms);
+
+    // the metadata of the model is fetched from every endpoint at once,
+    // which also connects to them. Returns the largest batch all of them
+    // accept
+    int LoadModel(const std::string& model_name);
+    // one ring registered with every endpoint, they must all run on this host
+    std::shared_ptr<ShmRing> EnableSharedMemory(const std::string& model_name, size_t slot_num);
+
+    size_t Size() const { return endpoints_.size(); }
+    // the session of an endpoint, bypassing the load balancing
+    TritonSession* Session(size_t index) { return endpoints_[index].session_.get(); }
+
+private:
+    std::vector<TritonEndpoint> endpoints_;
+    double latency_alpha_;
+    std::mutex mtx_;
+};
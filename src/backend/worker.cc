@@ -1,4 +1,79 @@
 #include "worker.hh"
+#include "model_registry.hh"
+#include "batch_scheduler.hh"
+#include "triton_pool.hh"
+#include "torch_engine.hh"
+
+/**
+ * PreprocessWorker
+ *
+ */
+PreprocessWorker::PreprocessWorker(std::shared_ptr<Config> conf,
+                                   std::shared_ptr<SingleQueryQueue> queue_1,
+                                   std::shared_ptr<ModelRegistry> registry,
+                                   uint32_t threads):
+                                   queue_1_(queue_1),
+                                   registry_(registry),
+                                   conf_(conf),
+                                   type1_(0),
+                                   type3_(0),
+                                   query_num_(0),
+                                   compressed_bytes_(0),
+                                   input_bytes_(0)
+{
+    Preprocessor preprocessor;
+    if (!preprocessor.ParseType(conf_->dtype, &type1_, &type3_)) {
+        LOG_ERROR("PreprocessWorker: unexpected input datatype %s", conf_->dtype.c_str());
+    }
+    for (uint32_t i = 0; i < threads; i++) {
+        preprocess_threads_.emplace_back(&PreprocessWorker::run, this);
+    }
+    LOG_INFO("PreprocessWorker created, threads: %d, input: %s %dx%dx%d",
+             threads, conf_->format.c_str(), conf_->channels, conf_->height, conf_->width);
+}
+
+PreprocessWorker::~PreprocessWorker() {
+    for (auto& thread : preprocess_threads_) {
+        thread.join();
+    }
+}
+
+void PreprocessWorker::run() {
+    while (true) {
+        auto query = queue_1_->Pop();
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t compressed_size = query->data_.size();
+        if (!preprocess(query)) {
+            LOG_ERROR("PreprocessWorker: unable to decode the image of query: %d, filename: %s, drop it",
+                      query->id_, query->filename_.c_str());
+            delete query;
+            continue;
+        }
+        uint64_t query_num = ++query_num_;
+        compressed_bytes_ += compressed_size;
+        input_bytes_ += query->data_.size();
+        auto end = std::chrono::high_resolution_clock::now();
+        LOG_INFO("PreprocessWorker query: %d, %ld -> %ld bytes in %lf ms, avg compressed bytes: %lf, avg input bytes: %lf",
+                 query->id_, compressed_size, query->data_.size(),
+                 std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count(),
+                 double(compressed_bytes_) / query_num, double(input_bytes_) / query_num);
+        registry_->Dispatch(query);
+    }
+}
+
+bool PreprocessWorker::preprocess(SingleQuery* query) {
+    cv::Mat img = cv::imdecode(cv::Mat(1, query->data_.size(), CV_8UC1, query->data_.data()), cv::IMREAD_UNCHANGED);
+    if (img.empty()) {
+        return false;
+    }
+    Preprocessor preprocessor;
+    std::vector<uint8_t> input_data;
+    preprocessor.Preprocess(img, conf_->format, type1_, type3_, conf_->channels,
+                            cv::Size(conf_->width, conf_->height), preprocessor.ParseScale(query->scale_), &input_data);
+    query->data_.assign(input_data.begin(), input_data.end());
+    query->compressed_ = false;
+    return true;
+}
 
 /**
  * BatchWorker
@@ -6,19 +81,23 @@
  */
 BatchWorker::BatchWorker(std::shared_ptr<Config> conf,
                         int batch_size,
+                        int max_queue_delay_us,
                         std::shared_ptr<SingleQueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
-                        std::shared_ptr<BatchQueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2):
+                        std::shared_ptr<BatchScheduler> scheduler,
+                        std::shared_ptr<ShmRing> shm_ring):
                         queue_1_(queue_1), 
-                        mtx_1_(mtx_1),
-                        cv_1_(cv_1),
-                        queue_2_(queue_2),
-                        mtx_2_(mtx_2),
-                        cv_2_(cv_2),
-                        conf_(conf)
+                        scheduler_(scheduler),
+                        conf_(conf),
+                        shm_ring_(shm_ring),
+                        max_queue_delay_(max_queue_delay_us),
+                        draining_(false),
+                        batch_num_(0),
+                        fill_ratio_sum_(0),
+                        queue_wait_ms_sum_(0),
+                        query_num_(0),
+                        copied_bytes_(0),
+                        fair_(conf->fairness_policy == "drr"),
+                        next_flow_(0)
 {
     batch_size_ = batch_size;
     batch_thread_ = std::thread(&BatchWorker::run, this);
@@ -28,159 +107,300 @@ BatchWorker::~BatchWorker() {
     batch_thread_.join();
 }
 
-BatchQuery* BatchWorker::createBatchQuery(std::shared_ptr<SingleQueryQueue> queue, 
-                                            std::shared_ptr<std::mutex> mutex, 
-                                            std::shared_ptr<std::condition_variable> cv,
-                                            int batch_size) {
-    std::unique_lock<std::mutex> lock(*mutex);                               
-    SingleQuery* query = queue->Pop();
-    LOG_INFO("pop query: %d from recv queue", query->id_);
+BatchWorker::Flow& BatchWorker::flow(uint32_t front_id) {
+    auto it = flows_.find(front_id);
+    if (it == flows_.end()) {
+        auto weight = conf_->frontend_weights.find(front_id);
+        Flow flow{weight == conf_->frontend_weights.end() ? 1 : weight->second, 0, FrontendQueueStat{0, 0, 0, 0}};
+        it = flows_.emplace(front_id, flow).first;
+    }
+    return it->second;
+}
 
-    std::vector<std::vector<uint8_t>> batch_data;
-    std::vector<grpcStream*> streams;
-    std::vector<int> ids;
-    std::string model_name = query->model_name_;
-    std::string scale = query->scale_;
-    std::vector<std::string> filenames;
-    std::string encode_type = query->encode_type_;
-    int id = query->id_;
+std::vector<SingleQuery*> BatchWorker::takeQueries(int batch_size, size_t window) {
+    std::vector<SingleQuery*> queries;
+    queries.reserve(batch_size);
+    std::lock_guard<std::mutex> lock(flows_mtx_);
+    if (!fair_ || window <= size_t(batch_size)) {
+        for (int i = 0; i < batch_size; i++) {
+            queries.push_back(pending_.front());
+            pending_.pop_front();
+        }
+    } else {
+        // the positions of the queries of every frontend in the window,
+        // oldest first
+        std::map<uint32_t, std::deque<size_t>> queued;
+        for (size_t i = 0; i < window; i++) {
+            queued[pending_[i]->front_id_].push_back(i);
+        }
+        std::vector<bool> taken(window, false);
+        int taken_num = 0;
+        auto it = queued.lower_bound(next_flow_);
+        while (taken_num < batch_size) {
+            if (it == queued.end()) {
+                it = queued.begin();
+            }
+            Flow& f = flow(it->first);
+            // a turn cut short by a full batch goes on in the next one
+            if (f.deficit_ == 0) {
+                f.deficit_ = f.weight_;
+            }
+            auto& positions = it->second;
+            while (f.deficit_ > 0 && !positions.empty() && taken_num < batch_size) {
+                taken[positions.front()] = true;
+                positions.pop_front();
+                f.deficit_--;
+                taken_num++;
+            }
+            if (positions.empty()) {
+                // a frontend with nothing queued does not save up its turn
+                f.deficit_ = 0;
+                it = queued.erase(it);
+            } else if (f.deficit_ == 0) {
+                ++it;
+            }
+        }
+        next_flow_ = it == queued.end() ? 0 : it->first;
+        std::deque<SingleQuery*> rest;
+        for (size_t i = 0; i < pending_.size(); i++) {
+            if (i < window && taken[i]) {
+                queries.push_back(pending_[i]);
+            } else {
+                rest.push_back(pending_[i]);
+            }
+        }
+        pending_.swap(rest);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::map<uint32_t, int> batch_queries;
+    for (auto query : queries) {
+        FrontendQueueStat& stat = flow(query->front_id_).stat_;
+        double wait = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                      (now - query->arrival_time_).count();
+        stat.queued_--;
+        stat.batched_++;
+        stat.wait_ms_sum_ += wait;
+        stat.wait_ms_max_ = std::max(stat.wait_ms_max_, wait);
+        batch_queries[query->front_id_]++;
+    }
+    for (const auto& frontend : batch_queries) {
+        const FrontendQueueStat& stat = flow(frontend.first).stat_;
+        LOG_INFO("BatchWorker frontend: %d, in batch: %d, queued: %ld, batched: %ld, avg wait: %lf ms, max wait: %lf ms",
+                 frontend.first, frontend.second, stat.queued_, stat.batched_,
+                 stat.wait_ms_sum_ / stat.batched_, stat.wait_ms_max_);
+    }
+    return queries;
+}
+
+std::vector<std::pair<uint32_t, FrontendQueueStat>> BatchWorker::FrontendStats() {
+    std::lock_guard<std::mutex> lock(flows_mtx_);
+    std::vector<std::pair<uint32_t, FrontendQueueStat>> stats;
+    for (const auto& f : flows_) {
+        stats.emplace_back(f.first, f.second.stat_);
+    }
+    return stats;
+}
 
-    batch_data.emplace_back(query->data_);
-    streams.emplace_back(query->stream_);
-    filenames.emplace_back(query->filename_);
-    ids.emplace_back(query->id_);
+BatchQuery* BatchWorker::createBatchQuery(int batch_size, size_t window) {
+    int target_batch_size = std::max(batch_size_.load(), 1);
+    // wait for a free slot before taking the queries, the slot is given
+    // back once the outputs of the batch have been read
+    ShmSlot* slot = nullptr;
+    if (shm_ring_ != nullptr && batch_size <= shm_ring_->MaxBatchSize()) {
+        slot = shm_ring_->Acquire();
+    }
 
-    for (int i = 0; i < batch_size - 1; i++) {
-        SingleQuery* query = queue->Pop();
+    std::vector<SingleQuery*> queries = takeQueries(batch_size, window);
+    std::vector<ReplyStream*> streams;
+    std::vector<int> ids;
+    std::vector<std::string> filenames;
+    std::vector<std::string> cache_keys;
+    std::vector<uint32_t> top_ks;
+    std::vector<bool> retains;
+    std::vector<uint32_t> front_ids;
+    streams.reserve(batch_size);
+    ids.reserve(batch_size);
+    filenames.reserve(batch_size);
+    cache_keys.reserve(batch_size);
+    top_ks.reserve(batch_size);
+    retains.reserve(batch_size);
+    front_ids.reserve(batch_size);
+    size_t input_size = 0;
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    auto arrival_time = std::chrono::steady_clock::time_point::max();
+    for (SingleQuery* query : queries) {
         LOG_INFO("pop query: %d from recv queue", query->id_);
-        batch_data.emplace_back(query->data_);
         streams.emplace_back(query->stream_);
-        filenames.emplace_back(query->filename_);
+        filenames.emplace_back(std::move(query->filename_));
         ids.emplace_back(query->id_);
+        cache_keys.emplace_back(std::move(query->cache_key_));
+        top_ks.emplace_back(query->top_k_);
+        retains.push_back(query->retain_);
+        front_ids.emplace_back(query->front_id_);
+        input_size += query->data_.size();
+        deadline = std::min(deadline, query->deadline_);
+        arrival_time = std::min(arrival_time, query->arrival_time_);
     }
-    
-    auto batch_query = new BatchQuery(model_name, scale, filenames, id, batch_data, streams, encode_type, ids);
-    lock.unlock();
-    cv->notify_all();
-    return batch_query;
-}
-
-// bool BatchWorker::ifAdjustBatch() {
-//     return batch_size_adjust;
-// }
+    std::string model_name = queries[0]->model_name_;
+    std::string scale = queries[0]->scale_;
+    std::string encode_type = queries[0]->encode_type_;
+    int id = queries[0]->id_;
+    bool recompute = queries[0]->recompute_;
 
-// bool BatchWorker::ifFirstAdjust() {
-//     return first_adjust;
-// }
+    double queue_wait = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                        (std::chrono::steady_clock::now() - arrival_time).count();
+    double fill_ratio = double(queries.size()) / target_batch_size;
+    batch_num_++;
+    fill_ratio_sum_ += fill_ratio;
+    queue_wait_ms_sum_ += queue_wait;
+    LOG_INFO("BatchWorker batch: %d, size: %ld/%d, fill ratio: %lf, queue wait: %lf ms, avg fill ratio: %lf, avg queue wait: %lf ms",
+             id, queries.size(), target_batch_size, fill_ratio, queue_wait,
+             fill_ratio_sum_ / batch_num_, queue_wait_ms_sum_ / batch_num_);
 
-// void BatchWorker::setAdjustBatch(bool value) {
-//     batch_size_adjust = value;
-// }
+    // the samples are written straight into the slot when they all have the
+    // size expected by the model
+    if (slot != nullptr && model_name != shm_ring_->Name()) {
+        shm_ring_->Release(slot);
+        slot = nullptr;
+    }
+    if (slot != nullptr) {
+        for (auto q : queries) {
+            if (q->data_.size() != shm_ring_->SampleInputSize()) {
+                LOG_ERROR("query: %d has %ld bytes, expected %ld, not using shared memory",
+                          q->id_, q->data_.size(), shm_ring_->SampleInputSize());
+                shm_ring_->Release(slot);
+                slot = nullptr;
+                break;
+            }
+        }
+    }
+    // otherwise into one buffer sized for a full batch, so that it can be
+    // reused by the next batches
+    BatchBuffer* input = nullptr;
+    if (slot == nullptr) {
+        size_t sample_size = input_size / batch_size;
+        input = buffer_pool_.Acquire(std::max(input_size, sample_size * std::max(target_batch_size, batch_size)));
+    }
+    for (size_t i = 0; i < queries.size(); i++) {
+        if (slot != nullptr) {
+            memcpy(slot->input_ + i * shm_ring_->SampleInputSize(),
+                   queries[i]->data_.data(), queries[i]->data_.size());
+        } else {
+            input->Append(queries[i]->data_.data(), queries[i]->data_.size());
+        }
+    }
+    query_num_ += queries.size();
+    copied_bytes_ += input_size;
+    LOG_INFO("BatchWorker copied bytes per query: %lf, batch buffer allocations: %ld",
+             double(copied_bytes_) / query_num_.load(), buffer_pool_.Allocations());
 
-// void BatchWorker::setFirstAdjust(bool value) {
-//     first_adjust = value;
-// }
+    auto batch_query = new BatchQuery(std::move(model_name), std::move(scale), std::move(filenames), id,
+                                      std::move(streams), std::move(encode_type), std::move(ids));
+    batch_query->input_ = input;
+    batch_query->shm_slot_ = slot;
+    batch_query->recompute_ = recompute;
+    batch_query->deadline_ = deadline;
+    batch_query->arrival_time_ = arrival_time;
+    batch_query->cache_keys_ = std::move(cache_keys);
+    batch_query->top_ks_ = std::move(top_ks);
+    batch_query->retains_ = std::move(retains);
+    batch_query->front_ids_ = std::move(front_ids);
+    // the payload is in the batch now and the batch holds the streams,
+    // nothing else refers to the queries
+    for (auto query : queries) {
+        delete query;
+    }
+    return batch_query;
+}
 
-// void BatchWorker::forwardBatchSize(int value) {
-//     batch_size_1_ += value;
-//     batch_size_2_ -= value;
-// }
+void BatchWorker::pushBatch(BatchQuery* batch_query) {
+    scheduler_->Push(batch_query);
+}
 
-// void BatchWorker::backwardBatchSize(double value) {
-//     batch_size_1_ *= (1-conf_->dec_value);
-//     batch_size_2_ *= (1+conf_->dec_value);
-// }
+void BatchWorker::dispatch() {
+    LOG_DEBUG("BatchWorker batch size: %d, pending: %ld", batch_size_.load(), pending_.size());
+    while (!pending_.empty()) {
+        int batch_size = std::max(batch_size_.load(), 1);
+        // the queries before an end signal are sent without waiting, the
+        // signal itself is dropped
+        auto end_signal = std::find_if(pending_.begin(), pending_.end(),
+                                       [](SingleQuery* query) { return query->end_signal_; });
+        if (end_signal != pending_.end()) {
+            LOG_DEBUG("BatchWorker receive end signal, flush %ld queries", end_signal - pending_.begin());
+            int last_batch_size = end_signal - pending_.begin();
+            while (last_batch_size > 0) {
+                int size = std::min(last_batch_size, batch_size);
+                pushBatch(createBatchQuery(size, last_batch_size));
+                last_batch_size -= size;
+            }
+            delete pending_.front();
+            pending_.pop_front();
+            continue;
+        }
+        if (pending_.size() >= size_t(batch_size)) {
+            pushBatch(createBatchQuery(batch_size, pending_.size()));
+            continue;
+        }
+        if (draining_.load(std::memory_order_relaxed)) {
+            LOG_INFO("BatchWorker draining, flush %ld queries", pending_.size());
+            pushBatch(createBatchQuery(pending_.size(), pending_.size()));
+            continue;
+        }
+        if (max_queue_delay_.count() > 0 &&
+            std::chrono::steady_clock::now() >= pending_.front()->arrival_time_ + max_queue_delay_) {
+            LOG_INFO("BatchWorker queue delay expired, flush %ld queries", pending_.size());
+            pushBatch(createBatchQuery(pending_.size(), pending_.size()));
+            continue;
+        }
+        break;
+    }
+}
 
 void BatchWorker::setBatchSize(int value) {
-    std::unique_lock<std::mutex> lock(batch_size_mtx_);
-    batch_size_ = value;
+    batch_size_.store(value);
+}
+
+void BatchWorker::Drain() {
+    draining_.store(true);
+    // wakes the batcher up, a full queue wakes it up anyway
+    queue_1_->TryPush(nullptr);
 }
 
 void BatchWorker::run() {
+    std::vector<SingleQuery*> popped;
     while(true) {
         auto start = std::chrono::high_resolution_clock::now();
-        {
-            std::unique_lock<std::mutex> lock(*mtx_1_);
-            LOG_INFO("BatchWorker waiting...");
-            std::cout << "Batchsize: " << batch_size_ << std::endl;
-            cv_1_->wait(lock, [this] { return (queue_1_->Size() >= batch_size_ || 
-                                                queue_1_->Back()->end_signal_ ||
-                                                queue_1_->Front()->recompute_); });
-        }
-        // pop query from recv queue
-        // batch
-        std::cout << "batch_size:" << batch_size_ << std::endl;
-        if (queue_1_->Front()->recompute_) {
-            std::cout << "receive recompute 1" << std::endl;
-            int recompute_batch_size = 1;
-            auto batch_query = createBatchQuery(queue_1_, mtx_1_, cv_1_, recompute_batch_size);
-            std::unique_lock<std::mutex> batch_lock(*mtx_2_);
-            queue_2_->Push(batch_query);
-            LOG_INFO("push query: %d to batch queue", batch_query->id_);
-            batch_lock.unlock();
-            cv_2_->notify_all();
+        // a partial batch is sent once its oldest query waited for
+        // max_queue_delay_, like the dynamic batcher of triton
+        std::chrono::microseconds timeout(-1);
+        if (!pending_.empty() && max_queue_delay_.count() > 0) {
+            auto deadline = pending_.front()->arrival_time_ + max_queue_delay_;
+            timeout = std::max(std::chrono::microseconds(0),
+                               std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()));
         }
-        else if (queue_1_->Back()->end_signal_) {
-            std::cout << "receive end signal 1" << std::endl;
-            int last_batch_size_1 = queue_1_->Size()-1;
-            if (last_batch_size_1 != 0) {
-                auto batch_query = createBatchQuery(queue_1_, mtx_1_, cv_1_, last_batch_size_1);
-                std::unique_lock<std::mutex> batch_lock(*mtx_2_);
-                queue_2_->Push(batch_query);
-                LOG_INFO("push query: %d to batch queue", batch_query->id_);
-                batch_lock.unlock();
-                cv_2_->notify_all();
+        LOG_INFO("BatchWorker waiting...");
+        // take everything that is queued in one go instead of one query
+        // per wakeup
+        popped.clear();
+        queue_1_->PopBulk(popped, queue_1_->Capacity(), timeout);
+        // the nullptr pushed by Drain only wakes the batcher up
+        std::copy_if(popped.begin(), popped.end(), std::back_inserter(pending_),
+                     [](SingleQuery* query) { return query != nullptr; });
+        {
+            std::lock_guard<std::mutex> lock(flows_mtx_);
+            for (auto query : popped) {
+                if (query != nullptr && !query->end_signal_) {
+                    flow(query->front_id_).stat_.queued_++;
+                }
             }
-            queue_1_->Pop();
-            std::cout << "receive end signal 2" << std::endl;
         }
-        else if (queue_1_->Size() >= batch_size_) {
-            auto batch_query = createBatchQuery(queue_1_, mtx_1_, cv_1_, batch_size_);
-            std::unique_lock<std::mutex> batch_lock(*mtx_2_);
-            queue_2_->Push(batch_query);
-            LOG_INFO("push query: %d to batch queue", batch_query->id_);
-            batch_lock.unlock();
-            cv_2_->notify_all();
-        }
-        // SingleQuery* query = queue_1_->Pop();
-        // LOG_INFO("pop query: %d from recv queue", query->id_);
-
-        // std::vector<std::vector<uint8_t>> batch_data;
-        // std::vector<grpcStream*> streams;
-        // std::vector<int> ids;
-        // std::string model_name = query->model_name_;
-        // std::string scale = query->scale_;
-        // std::vector<std::string> filenames;
-        // // std::string filename = query->filename_;
-        // std::string encode_type = query->encode_type_;
-        // int id = query->id_;
-
-        // batch_data.emplace_back(query->data_);
-        // streams.emplace_back(query->stream_);
-        // filenames.emplace_back(query->filename_);
-        // ids.emplace_back(query->id_);
-
-        // for (int i = 0; i < batch_size_-1; i++) {
-        //     SingleQuery* query = queue_1_->Pop();
-        //     LOG_INFO("pop query: %d from recv queue", query->id_);
-        //     batch_data.emplace_back(query->data_);
-        //     streams.emplace_back(query->stream_);
-        //     filenames.emplace_back(query->filename_);
-        //     ids.emplace_back(query->id_);
-        // }
-        
-        // // push batch query into batch queue
-        // auto batch_query = new BatchQuery(model_name, scale, filenames, id, batch_data, streams, encode_type, ids);
-
-        // std::unique_lock<std::mutex> batch_lock(*mtx_2_);
-        // queue_2_->Push(batch_query);
-        // LOG_INFO("push query: %d to batch queue", id);
-        // batch_lock.unlock();
-        // cv_2_->notify_all();
+        dispatch();
+
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
                             (end_time - start).count();
-        std::cout << "Batch Worker time: " << duration_time << std::endl;
+        LOG_DEBUG("BatchWorker time: %lf ms", duration_time);
     }
 }
 
@@ -189,21 +409,25 @@ void BatchWorker::run() {
  * 
  */
 InferWorker::InferWorker(std::shared_ptr<Config> conf,
-                        std::shared_ptr<BatchQueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
+                        std::shared_ptr<ModelRegistry> registry,
+                        std::shared_ptr<BatchScheduler> scheduler,
                         std::shared_ptr<BatchQueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2):
-                        queue_1_(queue_1), 
-                        mtx_1_(mtx_1),
-                        cv_1_(cv_1),
+                        std::shared_ptr<TritonPool> pool,
+                        std::shared_ptr<TorchEngine> torch_engine):
+                        registry_(registry),
+                        scheduler_(scheduler),
                         queue_2_(queue_2),
-                        mtx_2_(mtx_2),
-                        cv_2_(cv_2),
+                        pool_(pool),
+                        torch_engine_(torch_engine),
+                        inflight_(0),
+                        max_inflight_(conf->max_inflight),
                         conf_(conf)
 {
-    infer_thread_ = std::thread(&InferWorker::run, this);
+    if (conf_->infer_mode == "async") {
+        infer_thread_ = std::thread(&InferWorker::asyncRun, this);
+    } else {
+        infer_thread_ = std::thread(&InferWorker::run, this);
+    }
 }
 
 InferWorker::~InferWorker() {
@@ -213,55 +437,122 @@ InferWorker::~InferWorker() {
 void InferWorker::run() {
     while(true) {
         auto start1 = std::chrono::high_resolution_clock::now();
-        {
-            std::unique_lock<std::mutex> lock(*mtx_1_);
-            LOG_INFO("InferWorker waiting...");
-            cv_1_->wait(lock, [this] { return queue_1_->Size() > 0; });
-        }
-        
-        auto batch_query = queue_1_->Pop();
+        // several InferWorkers take batches from the scheduler
+        LOG_INFO("InferWorker waiting...");
+        BatchQuery* batch_query = scheduler_->Pop();
         LOG_INFO("pop query: %d from batch queue", batch_query->id_);
+        if (batch_query->rejected_) {
+            pushReply(batch_query);
+            continue;
+        }
         
         auto start = std::chrono::high_resolution_clock::now();
-        // exec image classify task
-        ImageClassify(*batch_query, batch_query->reply_info_);
+        double latency;
+        if (torch_engine_ != nullptr) {
+            if (torch_engine_->Infer(*batch_query) != 0) {
+                // the outputs are missing, the frontend recomputes the
+                // queries elsewhere rather than getting an empty reply
+                LOG_ERROR("InferWorker batch: %d failed, reject its %d queries", batch_query->id_, batch_query->batch_size_);
+                batch_query->rejected_ = true;
+                pushReply(batch_query);
+                continue;
+            }
+            latency = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                      (std::chrono::high_resolution_clock::now() - start).count();
+        } else {
+            // exec image classify task on the least loaded triton endpoint
+            TritonSession* session = pool_->Acquire();
+            ImageClassify(*session, *batch_query);
+            latency = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                      (std::chrono::high_resolution_clock::now() - start).count();
+            pool_->Release(session, latency);
+        }
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        recordLatency(batch_query, latency);
 
         LOG_INFO("Infer time: %ld ms", duration);
 
         // push query into infer queue
-        std::unique_lock<std::mutex> infer_lock(*mtx_2_);
-        queue_2_->Push(batch_query);
-        LOG_INFO("push query: %d to infer queue", batch_query->id_);
-        infer_lock.unlock();
-        cv_2_->notify_all();
+        pushReply(batch_query);
 
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
                             (end_time - start1).count();
-        std::cout << "Infer Worker time: " << duration_time << std::endl;
+        LOG_DEBUG("InferWorker time: %lf ms", duration_time);
     }
 }
 
+void InferWorker::asyncRun() {
+    LOG_INFO("InferWorker runs in async mode, max inflight batches: %d", max_inflight_);
+    while(true) {
+        // keep at most max_inflight_ batches outstanding at triton
+        {
+            std::unique_lock<std::mutex> lock(inflight_mtx_);
+            inflight_cv_.wait(lock, [this] { return inflight_ < max_inflight_; });
+            inflight_++;
+        }
+
+        LOG_INFO("InferWorker waiting...");
+        BatchQuery* batch_query = scheduler_->Pop();
+        LOG_INFO("pop query: %d from batch queue", batch_query->id_);
+        if (batch_query->rejected_) {
+            pushReply(batch_query);
+            {
+                std::lock_guard<std::mutex> lock(inflight_mtx_);
+                inflight_--;
+            }
+            continue;
+        }
+
+        // the reply is pushed by the completion callback, so the next batch
+        // can be sent while this one is still computed
+        auto start = std::chrono::high_resolution_clock::now();
+        TritonSession* session = pool_->Acquire();
+        AsyncImageClassify(*session, batch_query, [this, session, start](BatchQuery* done) {
+            auto end = std::chrono::high_resolution_clock::now();
+            double latency = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count();
+            pool_->Release(session, latency);
+            recordLatency(done, latency);
+            pushReply(done);
+            {
+                std::lock_guard<std::mutex> lock(inflight_mtx_);
+                inflight_--;
+            }
+            inflight_cv_.notify_one();
+        });
+    }
+}
+
+void InferWorker::recordLatency(BatchQuery* batch_query, double latency_ms) {
+    ModelEntry* model = registry_->Get(batch_query->model_name_);
+    if (model != nullptr) {
+        model->profile_->Record(batch_query->batch_size_, latency_ms);
+    }
+}
+
+void InferWorker::pushReply(BatchQuery* batch_query) {
+    queue_2_->Push(batch_query);
+    LOG_INFO("push query: %d to infer queue", batch_query->id_);
+}
+
 /**
  * ReplyWorker
  * 
  */
 ReplyWorker::ReplyWorker(std::shared_ptr<Config> conf,
                         std::shared_ptr<BatchQueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
-                        std::shared_ptr<BatchQueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2):
+                        std::shared_ptr<BasicCache<std::string, std::string>> cache,
+                        std::shared_ptr<FeatureStore> feature_store):
                         queue_1_(queue_1), 
-                        mtx_1_(mtx_1),
-                        cv_1_(cv_1),
-                        queue_2_(queue_2),
-                        mtx_2_(mtx_2),
-                        cv_2_(cv_2),
-                        conf_(conf)
+                        cache_(cache),
+                        feature_store_(feature_store),
+                        conf_(conf),
+                        feature_precision_(ParseFeaturePrecision(conf->feature_precision)),
+                        recompute_batch_num_(0),
+                        recompute_query_num_(0),
+                        recompute_latency_ms_sum_(0),
+                        recompute_latency_ms_max_(0)
 {
     reply_thread_ = std::thread(&ReplyWorker::run, this);
 }
@@ -273,31 +564,98 @@ ReplyWorker::~ReplyWorker() {
 void ReplyWorker::run() {
     while(true) {
         auto start1 = std::chrono::high_resolution_clock::now();
-        std::unique_lock<std::mutex> lock(*mtx_1_);
         LOG_INFO("ReplyWorker waiting...");
-        cv_1_->wait(lock, [this] { return queue_1_->Size() > 0; });
-
         auto batch_query = queue_1_->Pop();
         LOG_INFO("pop query: %d from infer queue", batch_query->id_);
+
+        if (batch_query->rejected_) {
+            // the backend is going away, the frontend recomputes the queries
+            // elsewhere without waiting for its monitor
+            for (int i = 0; i < batch_query->batch_size_; i++) {
+                elasticcdc::ElasticcdcReply reply;
+                reply.set_id(batch_query->ids_[i]);
+                reply.set_rejected(true);
+                batch_query->streams_[i]->Write(reply);
+            }
+            LOG_INFO("reject batch: %d, size: %d", batch_query->id_, batch_query->batch_size_);
+            batch_query->releaseOutputs();
+            delete batch_query;
+            continue;
+        }
         
-        assert(batch_query->batch_size_ == batch_query->data_.size());
         assert(batch_query->batch_size_ == batch_query->streams_.size());
-        assert(batch_query->batch_size_ == batch_query->reply_info_.size());
+        assert(batch_query->batch_size_ == batch_query->reply_views_.size());
         assert(batch_query->batch_size_ == batch_query->ids_.size());
 
-        // reply to frontend
+        // reply to frontend, the outputs are copied once from the triton
+        // result into the reply, the features are encoded on the way
         for(int i = 0; i < batch_query->batch_size_; i++) {
+            const ReplyView& view = batch_query->reply_views_[i];
             elasticcdc::ElasticcdcReply reply;
             reply.set_id(batch_query->ids_[i]);
-            reply.set_reply_info(batch_query->reply_info_[i]);
-            LOG_INFO("reply_info_size: %ld", batch_query->reply_info_[i].size());
+            std::string* reply_info = reply.mutable_reply_info();
+            if (batch_query->top_ks_[i] > 0) {
+                // only the top classes, "score:index" separated by ';'
+                size_t class_num = std::min<size_t>(batch_query->top_ks_[i], view.class_num_);
+                for (size_t c = 0; c < class_num; c++) {
+                    if (c > 0) {
+                        reply_info->push_back(';');
+                    }
+                    reply_info->append(view.classes_[c].first, view.classes_[c].second);
+                }
+            } else if (batch_query->retains_[i] && feature_store_ != nullptr && view.feature_size_ > 0) {
+                // the prediction only, the feature map waits in the store.
+                // The cache keeps the full reply, as for a FULL query
+                std::string feature;
+                QuantizeFeature(view.feature_, view.feature_size_ / sizeof(float), feature_precision_, &feature);
+                reply_info->assign(view.label_, view.label_size_);
+                if (cache_ != nullptr && !batch_query->cache_keys_[i].empty()) {
+                    cache_->put(batch_query->cache_keys_[i], feature + *reply_info);
+                    batch_query->cache_keys_[i].clear();
+                }
+                feature_store_->Put(batch_query->front_ids_[i], batch_query->ids_[i], std::move(feature));
+            } else {
+                reply_info->reserve(FeatureWireSize(feature_precision_, view.feature_size_) + view.label_size_);
+                if (view.feature_size_ > 0) {
+                    QuantizeFeature(view.feature_, view.feature_size_ / sizeof(float), feature_precision_, reply_info);
+                }
+                if (view.label_size_ > 0) {
+                    reply_info->append(view.label_, view.label_size_);
+                }
+            }
+            LOG_INFO("reply_info_size: %ld", reply_info->size());
+            // an empty reply is never cached, it would be served again
+            if (cache_ != nullptr && !batch_query->cache_keys_[i].empty() && !reply_info->empty()) {
+                cache_->put(batch_query->cache_keys_[i], *reply_info);
+            }
             batch_query->streams_[i]->Write(reply);
             LOG_INFO("send query: %d to client", batch_query->ids_[i]);
         }
+        batch_query->releaseOutputs();
+        if (batch_query->recompute_) {
+            // from the arrival of the oldest query of the batch, the batch
+            // sizes tell how many triton calls a storm of recomputes costs
+            double latency = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                             (std::chrono::steady_clock::now() - batch_query->arrival_time_).count();
+            recompute_batch_num_++;
+            recompute_query_num_ += batch_query->batch_size_;
+            recompute_latency_ms_sum_ += latency;
+            recompute_latency_ms_max_ = std::max(recompute_latency_ms_max_, latency);
+            LOG_INFO("recompute batch: %d, size: %d, latency: %lf ms, avg latency: %lf ms, max latency: %lf ms, avg batch size: %lf",
+                     batch_query->id_, batch_query->batch_size_, latency,
+                     recompute_latency_ms_sum_ / recompute_batch_num_, recompute_latency_ms_max_,
+                     double(recompute_query_num_) / recompute_batch_num_);
+        }
+        delete batch_query;
+        if (cache_ != nullptr) {
+            CacheStats stats = cache_->getCacheStats();
+            LOG_INFO("result cache entries: %ld, bytes: %ld/%ld, hit: %ld, miss: %ld, eviction: %ld",
+                     stats.size, stats.bytes, stats.capacity_bytes, stats.hit, stats.miss, stats.eviction);
+        }
 
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
                             (end_time - start1).count();
-        std::cout << "Reply Worker time: " << duration_time << std::endl;
+        LOG_DEBUG("ReplyWorker time: %lf ms", duration_time);
     }
 }
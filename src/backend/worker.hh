@@ -1,18 +1,37 @@
 #pragma once
 #include "../inc/inc.hh"
 #include "../common/concurrency_queue.hh"
+#include "../common/mpmc_queue.hh"
 #include "../common/logger.hh"
 #include "../common/conf.hh"
+#include "../common/quantize.hh"
+#include "../common/cache.hh"
+#include <cstring>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <string>
 #include "image_classify.hh"
 #include "query.hh"
+#include "shm_ring.hh"
+#include "feature_store.hh"
+#include "../common/preprocessor.hh"
 
 using grpc::ServerWriter;
 
-using SingleQueryQueue = ConcurrencyQueue<SingleQuery*>;
-using BatchQueryQueue = ConcurrencyQueue<BatchQuery*>;
+class TritonSession;
+class TritonPool;
+class TorchEngine;
+class ModelRegistry;
+class BatchScheduler;
+
+// the stages hand queries over through lock-free queues, the consumers
+// wait inside the queue so the stages share no mutex
+using SingleQueryQueue = MpmcQueue<SingleQuery*>;
+using BatchQueryQueue = MpmcQueue<BatchQuery*>;
 
 // class Worker {
 // public:
@@ -27,84 +46,172 @@ using BatchQueryQueue = ConcurrencyQueue<BatchQuery*>;
 //     std::shared_ptr<std::condition_variable> cv_2_;
 // };
 
+/**
+ * PreprocessWorker
+ * Decodes and resizes the compressed queries as the frontend does, on
+ * 'threads' threads, then hands them to the batchers of their model. The
+ * frontend sends the backups as the image it received, which is often ten
+ * times smaller than the input tensor.
+ */
+class PreprocessWorker {
+public:
+    PreprocessWorker(std::shared_ptr<Config> conf,
+                     std::shared_ptr<SingleQueryQueue> queue_1,
+                     std::shared_ptr<ModelRegistry> registry,
+                     uint32_t threads);
+    ~PreprocessWorker();
+
+    std::vector<std::thread> preprocess_threads_;
+
+private:
+    void run();
+    // false if the image can not be decoded
+    bool preprocess(SingleQuery* query);
+
+    std::shared_ptr<SingleQueryQueue> queue_1_;
+    std::shared_ptr<ModelRegistry> registry_;
+    std::shared_ptr<Config> conf_;
+    // the opencv types of the input, from the preprocess config
+    int type1_;
+    int type3_;
+    std::atomic<uint64_t> query_num_;
+    std::atomic<uint64_t> compressed_bytes_;
+    std::atomic<uint64_t> input_bytes_;
+};
+
+/**
+ * FrontendQueueStat
+ * The queries of one frontend in a batcher.
+ */
+struct FrontendQueueStat {
+    // taken from the receive queue and not batched yet
+    uint64_t queued_;
+    uint64_t batched_;
+    // the time the batched queries spent in the backend before their batch
+    double wait_ms_sum_;
+    double wait_ms_max_;
+};
+
 class BatchWorker {
 public:
     BatchWorker(std::shared_ptr<Config> conf,
                 int batch_size,
+                int max_queue_delay_us,
                 std::shared_ptr<SingleQueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
-                std::shared_ptr<BatchQueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2);
+                std::shared_ptr<BatchScheduler> scheduler,
+                std::shared_ptr<ShmRing> shm_ring = nullptr);
     ~BatchWorker();
 
-    // void forwardBatchSize(int value);
-    // void backwardBatchSize(double value);
-    // bool ifAdjustBatch();
-    // void setAdjustBatch(bool value);
-    // bool ifFirstAdjust();
-    // void setFirstAdjust(bool value);
+    // takes effect from the next batch, called by the BatchController
     void setBatchSize(int value);
+    // from now on the pending queries are sent without waiting for a full
+    // batch, called when the backend drains
+    void Drain();
+    // the queries sent in batches so far
+    uint64_t QueryNum() const { return query_num_.load(std::memory_order_relaxed); }
+    // by frontend id, thread safe
+    std::vector<std::pair<uint32_t, FrontendQueueStat>> FrontendStats();
 
     std::thread batch_thread_;
 
 private:
     void run();
+    // sends the batches that are ready among the pending queries
+    void dispatch();
+    void pushBatch(BatchQuery* batch_query);
     std::shared_ptr<SingleQueryQueue> queue_1_;
-    std::shared_ptr<std::mutex> mtx_1_;
-    std::shared_ptr<std::condition_variable> cv_1_;
+    // queries taken from queue_1_ that are not batched yet, oldest first
+    std::deque<SingleQuery*> pending_;
 
-    std::shared_ptr<BatchQueryQueue> queue_2_;
-    std::shared_ptr<std::mutex> mtx_2_;
-    std::shared_ptr<std::condition_variable> cv_2_;
+    // shared by the batchers of all models, it decides which batch the
+    // InferWorkers serve next
+    std::shared_ptr<BatchScheduler> scheduler_;
 
     void BatchInputData();
-    std::mutex batch_size_mtx_;
-    std::condition_variable batch_size_cv_;
-    int batch_size_;
+    std::atomic<int> batch_size_;
     // bool batch_size_adjust;
     // bool first_adjust;
     std::shared_ptr<Config> conf_;
-    BatchQuery* createBatchQuery(std::shared_ptr<SingleQueryQueue> queue, std::shared_ptr<std::mutex> mutex, 
-        std::shared_ptr<std::condition_variable> cv, int batch_size);
+    // batches are assembled directly into a slot of the ring when it is set
+    std::shared_ptr<ShmRing> shm_ring_;
+    // 0 waits for a full batch
+    std::chrono::microseconds max_queue_delay_;
+    std::atomic<bool> draining_;
+    // fill ratio and queue wait of the batches sent so far
+    uint64_t batch_num_;
+    double fill_ratio_sum_;
+    double queue_wait_ms_sum_;
+    // the batch inputs, and the payload bytes copied into them so far
+    BatchBufferPool buffer_pool_;
+    std::atomic<uint64_t> query_num_;
+    uint64_t copied_bytes_;
+    // takes batch_size of the first 'window' queries of pending_
+    BatchQuery* createBatchQuery(int batch_size, size_t window);
+
+    // the queries of one frontend, and its share of the batches under drr
+    struct Flow {
+        uint32_t weight_;
+        // the queries it may still send in its current turn
+        uint32_t deficit_;
+        FrontendQueueStat stat_;
+    };
+    // called with flows_mtx_ held
+    Flow& flow(uint32_t front_id);
+    // the oldest batch_size of the window under fifo. Under drr the
+    // frontends take turns in the order of their ids, each one sending up
+    // to its weight of queries per turn, so a frontend flooding the backend
+    // does not hold the queries of the others back
+    std::vector<SingleQuery*> takeQueries(int batch_size, size_t window);
+    bool fair_;
+    std::map<uint32_t, Flow> flows_;
+    // the frontend whose turn comes next
+    uint32_t next_flow_;
+    std::mutex flows_mtx_;
 };
 
 class InferWorker {
 public:
     InferWorker(std::shared_ptr<Config> conf,
-                std::shared_ptr<BatchQueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
+                std::shared_ptr<ModelRegistry> registry,
+                std::shared_ptr<BatchScheduler> scheduler,
                 std::shared_ptr<BatchQueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2);
+                std::shared_ptr<TritonPool> pool,
+                std::shared_ptr<TorchEngine> torch_engine = nullptr);
     ~InferWorker();
 
     std::thread infer_thread_;
 
 private:
     void run();
-    std::shared_ptr<BatchQueryQueue> queue_1_;
-    std::shared_ptr<std::mutex> mtx_1_;
-    std::shared_ptr<std::condition_variable> cv_1_;
+    void asyncRun();
+    void pushReply(BatchQuery* batch_query);
+    // feeds the latency profile of the model of the batch
+    void recordLatency(BatchQuery* batch_query, double latency_ms);
+    // the latency profiles of the models are in the registry
+    std::shared_ptr<ModelRegistry> registry_;
+    std::shared_ptr<BatchScheduler> scheduler_;
 
     std::shared_ptr<BatchQueryQueue> queue_2_;
-    std::shared_ptr<std::mutex> mtx_2_;
-    std::shared_ptr<std::condition_variable> cv_2_;
-    
+
+    std::shared_ptr<TritonPool> pool_;
+    // runs the batches in process instead of the pool when it is set
+    std::shared_ptr<TorchEngine> torch_engine_;
+    // batches sent to triton whose results have not come back yet
+    uint32_t inflight_;
+    uint32_t max_inflight_;
+    std::mutex inflight_mtx_;
+    std::condition_variable inflight_cv_;
     std::shared_ptr<Config> conf_;
 }; 
 
 class ReplyWorker {
 public:
+    // the replies are stored in 'cache' when it is set, and the feature
+    // maps of the RETAIN queries in 'feature_store'
     ReplyWorker(std::shared_ptr<Config> conf,
                 std::shared_ptr<BatchQueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
-                std::shared_ptr<BatchQueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2);
+                std::shared_ptr<BasicCache<std::string, std::string>> cache = nullptr,
+                std::shared_ptr<FeatureStore> feature_store = nullptr);
     ~ReplyWorker();
 
     std::thread reply_thread_;
@@ -112,14 +219,16 @@ public:
 private:
     void run();
     std::shared_ptr<BatchQueryQueue> queue_1_;
-    std::shared_ptr<std::mutex> mtx_1_;
-    std::shared_ptr<std::condition_variable> cv_1_;
-
-    std::shared_ptr<BatchQueryQueue> queue_2_;
-    std::shared_ptr<std::mutex> mtx_2_;
-    std::shared_ptr<std::condition_variable> cv_2_;
+    std::shared_ptr<BasicCache<std::string, std::string>> cache_;
+    std::shared_ptr<FeatureStore> feature_store_;
 
     std::shared_ptr<Config> conf_;
+    FeaturePrecision feature_precision_;
+    // the recompute batches answered so far
+    uint64_t recompute_batch_num_;
+    uint64_t recompute_query_num_;
+    double recompute_latency_ms_sum_;
+    double recompute_latency_ms_max_;
 }; 
 
 class Ajustor {
@@ -2,70 +2,473 @@
 #include <list>
 #include <unordered_map>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <iostream>
 #include <cassert>
+#include <string>
+#include <vector>
 #include "../util/json/json.h"
 #include "../common/logger.hh"
 using namespace std;
 
+/**
+ * The counters of a cache, summed over its shards.
+ */
+struct CacheStats {
+    uint64_t hit = 0;
+    uint64_t miss = 0;
+    uint64_t insert = 0;
+    uint64_t update = 0;
+    uint64_t eviction = 0;
+    // entries larger than a shard, not cached
+    uint64_t reject = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+    // only counted when the cache has a byte budget
+    size_t bytes = 0;
+    size_t capacity_bytes = 0;
+    // the lower tier of a TieredCache
+    uint64_t lower_hit = 0;
+    size_t lower_size = 0;
+};
+
+// what an entry counts against a byte budget
+template<typename K, typename V>
+size_t CacheEntryBytes(const K& key, const V& value) {
+    return sizeof(K) + sizeof(V);
+}
+
+inline size_t CacheEntryBytes(const std::string& key, const std::string& value) {
+    return key.size() + value.size();
+}
 
 template<typename K, typename V>
 class BasicCache {
 public:
-    BasicCache(const Json::Value& config) { 
+    BasicCache(const Json::Value& config) {
         use_cache_ = config.get("use_cache", false).asBool();
+        capacity_ = 0;
+        capacity_bytes_ = 0;
         if (use_cache_) {
+            // a byte budget replaces the entry count when it is set
+            capacity_bytes_ = config.get("capacity_bytes", 0).asUInt64();
             capacity_  = config.get("capacity", 0).asInt();
-            assert(capacity_ > 0 && "capacity should be greater than 0");
+            assert((capacity_ > 0 || capacity_bytes_ > 0) && "capacity should be greater than 0");
         }
     }
-    
+    virtual ~BasicCache() {}
+
     virtual bool get(const K& key, V& value) = 0;
 
     virtual void put(const K& key, const V& value) = 0;
 
+    virtual CacheStats getCacheStats() = 0;
+
+    bool enabled() const { return use_cache_; }
+
     std::pair<double, double> getCacheInfo() {
-        std::lock_guard<std::mutex> lck(mutex_);
-        if(cache_info_.hit + cache_info_.miss == 0) {
+        CacheStats stats = getCacheStats();
+        if(stats.hit + stats.miss == 0) {
             return {0, 0};
         }
-        double hitRate = (double)cache_info_.hit / (cache_info_.hit + cache_info_.miss);
-        double missRate = (double)cache_info_.miss / (cache_info_.hit + cache_info_.miss);
+        double hitRate = (double)stats.hit / (stats.hit + stats.miss);
+        double missRate = (double)stats.miss / (stats.hit + stats.miss);
         return {hitRate, missRate};
     }
 
 protected:
     bool use_cache_;
     int capacity_;
+    uint64_t capacity_bytes_;
+};
+
+/*
+ * The policies below are not thread safe, the ShardedCache locks around
+ * them. Every entry has a charge, 1 when the cache counts entries or its
+ * size when it has a byte budget, and the charges of the entries stay
+ * within the capacity. put() returns the number of entries evicted to make
+ * room, the caller never passes a charge larger than the capacity.
+ */
+
+/**
+ * LruPolicy
+ * Least recently used. The list holds the entries most recent first, and
+ * every node keeps its key so that the tail is evicted in O(1).
+ */
+template<typename K, typename V>
+class LruPolicy {
+public:
+    explicit LruPolicy(size_t capacity) : capacity_(capacity), charge_(0) {}
+
+    bool get(const K& key, V& value) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return false;
+        }
+        list_.splice(list_.begin(), list_, it->second);
+        value = it->second->value_;
+        return true;
+    }
 
-    unordered_map<K, typename list<V>::iterator> map_;
-    list<V> list_;
-    std::mutex mutex_;
-    struct cache_info {
-        int miss = 0;
-        int hit = 0;
-    } cache_info_;
+    size_t put(const K& key, const V& value, size_t charge, bool& inserted) {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            Node& node = *it->second;
+            charge_ = charge_ - node.charge_ + charge;
+            node.value_ = value;
+            node.charge_ = charge;
+            list_.splice(list_.begin(), list_, it->second);
+            inserted = false;
+            // a larger value can push the others out, never itself
+            return evict(0);
+        }
+        size_t evicted = evict(charge);
+        list_.push_front(Node{key, value, charge});
+        map_[key] = list_.begin();
+        charge_ += charge;
+        inserted = true;
+        return evicted;
+    }
+
+    size_t size() const { return map_.size(); }
+    size_t charge() const { return charge_; }
+
+private:
+    struct Node {
+        K key_;
+        V value_;
+        size_t charge_;
+    };
+
+    // evicts from the tail until 'charge' more fits
+    size_t evict(size_t charge) {
+        size_t evicted = 0;
+        while (!list_.empty() && charge_ + charge > capacity_) {
+            charge_ -= list_.back().charge_;
+            map_.erase(list_.back().key_);
+            list_.pop_back();
+            evicted++;
+        }
+        return evicted;
+    }
+
+    size_t capacity_;
+    size_t charge_;
+    list<Node> list_;
+    unordered_map<K, typename list<Node>::iterator> map_;
 };
 
-template <typename K, typename V>
-class LruCache : public BasicCache<K, V> {
+/**
+ * LfuPolicy
+ * Least frequently used in O(1): the keys are bucketed by their use count,
+ * each bucket in recency order, and the least recent key of the lowest count
+ * is evicted.
+ */
+template<typename K, typename V>
+class LfuPolicy {
+public:
+    explicit LfuPolicy(size_t capacity) : capacity_(capacity), charge_(0), min_freq_(0) {}
+
+    bool get(const K& key, V& value) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return false;
+        }
+        touch(it->second);
+        value = it->second.value_;
+        return true;
+    }
+
+    size_t put(const K& key, const V& value, size_t charge, bool& inserted) {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            // taken out while making room, so that a larger value does not
+            // push itself out, and put back as a use
+            uint64_t freq = it->second.freq_ + 1;
+            unlink(it);
+            size_t evicted = evict(charge);
+            link(key, value, charge, freq);
+            min_freq_ = std::min(min_freq_, freq);
+            inserted = false;
+            return evicted;
+        }
+        size_t evicted = evict(charge);
+        link(key, value, charge, 1);
+        min_freq_ = 1;
+        inserted = true;
+        return evicted;
+    }
+
+    size_t size() const { return map_.size(); }
+    size_t charge() const { return charge_; }
 
+private:
+    struct Entry {
+        V value_;
+        size_t charge_;
+        uint64_t freq_;
+        typename list<K>::iterator it_;
+    };
+
+    // moves the key of 'entry' to the bucket of the next count
+    void touch(Entry& entry) {
+        // find the bucket after adding the next one, the insert can rehash
+        auto& next = freqs_[entry.freq_ + 1];
+        auto bucket = freqs_.find(entry.freq_);
+        next.splice(next.begin(), bucket->second, entry.it_);
+        if (bucket->second.empty()) {
+            freqs_.erase(bucket);
+            if (min_freq_ == entry.freq_) {
+                min_freq_++;
+            }
+        }
+        entry.freq_++;
+    }
+
+    void link(const K& key, const V& value, size_t charge, uint64_t freq) {
+        auto& bucket = freqs_[freq];
+        bucket.push_front(key);
+        map_.emplace(key, Entry{value, charge, freq, bucket.begin()});
+        charge_ += charge;
+    }
+
+    // min_freq_ may be left on a bucket that is gone, below the others
+    void unlink(typename unordered_map<K, Entry>::iterator it) {
+        auto bucket = freqs_.find(it->second.freq_);
+        bucket->second.erase(it->second.it_);
+        if (bucket->second.empty()) {
+            freqs_.erase(bucket);
+        }
+        charge_ -= it->second.charge_;
+        map_.erase(it);
+    }
+
+    size_t evict(size_t charge) {
+        size_t evicted = 0;
+        while (!map_.empty() && charge_ + charge > capacity_) {
+            auto bucket = freqs_.find(min_freq_);
+            if (bucket == freqs_.end()) {
+                // an eviction or an update emptied the lowest bucket
+                min_freq_ = std::min_element(freqs_.begin(), freqs_.end(),
+                    [](const auto& a, const auto& b) { return a.first < b.first; })->first;
+                bucket = freqs_.find(min_freq_);
+            }
+            auto victim = map_.find(bucket->second.back());
+            charge_ -= victim->second.charge_;
+            map_.erase(victim);
+            bucket->second.pop_back();
+            if (bucket->second.empty()) {
+                freqs_.erase(bucket);
+            }
+            evicted++;
+        }
+        return evicted;
+    }
+
+    size_t capacity_;
+    size_t charge_;
+    uint64_t min_freq_;
+    unordered_map<K, Entry> map_;
+    unordered_map<uint64_t, list<K>> freqs_;
+};
+
+/**
+ * ArcPolicy
+ * Adaptive replacement cache (Megiddo & Modha). T1 holds the keys seen once
+ * recently and T2 the keys seen at least twice. B1 and B2 remember the keys
+ * evicted from them without their values. A put of a key found in B1 means
+ * T1 was too small, so the target size p of T1 grows. A key found in B2
+ * shrinks p. A scan therefore only flushes T1, and the frequently used keys
+ * stay in T2. The sizes of the lists are the charges of their keys, so with
+ * a charge of 1 per entry this is the original algorithm.
+ */
+template<typename K, typename V>
+class ArcPolicy {
 public:
-    LruCache(const Json::Value& config) : BasicCache<K, V>(config) {}
+    explicit ArcPolicy(size_t capacity) : capacity_(capacity), p_(0), charges_{0, 0, 0, 0} {}
+
+    bool get(const K& key, V& value) {
+        auto it = map_.find(key);
+        if (it == map_.end() || !resident(it->second.where_)) {
+            return false;
+        }
+        moveTo(it->second, T2);
+        value = it->second.value_;
+        return true;
+    }
+
+    size_t put(const K& key, const V& value, size_t charge, bool& inserted) {
+        auto it = map_.find(key);
+        size_t evicted = 0;
+        if (it != map_.end() && resident(it->second.where_)) {
+            Entry& entry = it->second;
+            entry.value_ = value;
+            setCharge(entry, charge);
+            moveTo(entry, T2);
+            // the entry is at the front of T2, only the others are replaced
+            while (charges_[T1] + charges_[T2] > capacity_) {
+                evicted += replace(false, 1);
+            }
+            trimGhosts();
+            inserted = false;
+            return evicted;
+        }
+        inserted = true;
+        if (it != map_.end()) {
+            // a ghost hit, adapt p and take the key back into T2
+            Entry& entry = it->second;
+            if (entry.where_ == B1) {
+                p_ = std::min(capacity_, p_ + std::max<size_t>(charges_[B2] / charges_[B1], 1) * charge);
+            } else {
+                size_t delta = std::max<size_t>(charges_[B1] / charges_[B2], 1) * charge;
+                p_ = p_ > delta ? p_ - delta : 0;
+            }
+            bool in_b2 = entry.where_ == B2;
+            while (charges_[T1] + charges_[T2] + charge > capacity_) {
+                evicted += replace(in_b2);
+            }
+            entry.value_ = value;
+            setCharge(entry, charge);
+            moveTo(entry, T2);
+            trimGhosts();
+            return evicted;
+        }
+
+        if (charges_[T1] + charges_[B1] + charge > capacity_) {
+            while (!lists_[B1].empty() && charges_[T1] + charges_[B1] + charge > capacity_) {
+                dropLru(B1);
+            }
+            // B1 is empty, T1 alone fills the cache
+            while (!lists_[T1].empty() && charges_[T1] + charge > capacity_) {
+                dropLru(T1);
+                evicted++;
+            }
+        }
+        while (!lists_[B2].empty() && total() + charge > 2 * capacity_) {
+            dropLru(B2);
+        }
+        while (charges_[T1] + charges_[T2] + charge > capacity_) {
+            evicted += replace(false);
+        }
+        lists_[T1].push_front(key);
+        map_.emplace(key, Entry{value, charge, T1, lists_[T1].begin()});
+        charges_[T1] += charge;
+        return evicted;
+    }
+
+    size_t size() const { return lists_[T1].size() + lists_[T2].size(); }
+    size_t charge() const { return charges_[T1] + charges_[T2]; }
+
+private:
+    enum Where {
+        T1 = 0,
+        T2,
+        B1,
+        B2
+    };
+
+    struct Entry {
+        V value_;
+        size_t charge_;
+        int where_;
+        typename list<K>::iterator it_;
+    };
+
+    static bool resident(int where) { return where == T1 || where == T2; }
+
+    size_t total() const { return charges_[T1] + charges_[T2] + charges_[B1] + charges_[B2]; }
+
+    void setCharge(Entry& entry, size_t charge) {
+        charges_[entry.where_] = charges_[entry.where_] - entry.charge_ + charge;
+        entry.charge_ = charge;
+    }
+
+    // moves the key of 'entry' to the front of list 'to'
+    void moveTo(Entry& entry, int to) {
+        lists_[to].splice(lists_[to].begin(), lists_[entry.where_], entry.it_);
+        charges_[entry.where_] -= entry.charge_;
+        charges_[to] += entry.charge_;
+        entry.where_ = to;
+    }
+
+    void dropLru(int where) {
+        auto it = map_.find(lists_[where].back());
+        charges_[where] -= it->second.charge_;
+        map_.erase(it);
+        lists_[where].pop_back();
+    }
+
+    // a key whose charge grew can take the directory over 2c
+    void trimGhosts() {
+        for (int ghost : {B2, B1}) {
+            while (!lists_[ghost].empty() && total() > 2 * capacity_) {
+                dropLru(ghost);
+            }
+        }
+    }
+
+    // moves the LRU key of T1 or T2 to its ghost list, leaving at least
+    // 't2_keep' keys in T2, returns the number of values evicted
+    size_t replace(bool in_b2, size_t t2_keep = 0) {
+        int from = T2;
+        if (!lists_[T1].empty() && (charges_[T1] > p_ || (in_b2 && charges_[T1] == p_) ||
+                                    lists_[T2].size() <= t2_keep)) {
+            from = T1;
+        }
+        Entry& entry = map_.find(lists_[from].back())->second;
+        entry.value_ = V();
+        moveTo(entry, from == T1 ? B1 : B2);
+        return 1;
+    }
+
+    size_t capacity_;
+    // the target size of T1
+    size_t p_;
+    list<K> lists_[4];
+    size_t charges_[4];
+    unordered_map<K, Entry> map_;
+};
+
+/**
+ * ShardedCache
+ * Splits the capacity over shards picked by the hash of the key, each with
+ * its own mutex, so that the threads receiving requests rarely contend. The
+ * config takes "shards" (16 by default), every shard holds at least 64
+ * entries, or 1 MiB under a byte budget.
+ */
+template<typename K, typename V, typename Policy>
+class ShardedCache : public BasicCache<K, V> {
+public:
+    ShardedCache(const Json::Value& config) : BasicCache<K, V>(config) {
+        if (!use_cache_) {
+            return;
+        }
+        uint64_t capacity = capacity_bytes_ > 0 ? capacity_bytes_ : capacity_;
+        uint64_t min_shard = capacity_bytes_ > 0 ? (1 << 20) : 64;
+        size_t shard_num = std::max(config.get("shards", 16).asUInt(), 1u);
+        // tiny shards evict early, a small cache stays in one shard
+        shard_num = std::min<uint64_t>(shard_num, std::max<uint64_t>(capacity / min_shard, 1));
+        for (size_t i = 0; i < shard_num; i++) {
+            // the remainder goes to the first shards
+            size_t shard_capacity = capacity / shard_num + (i < capacity % shard_num ? 1 : 0);
+            shards_.emplace_back(new Shard(shard_capacity));
+        }
+    }
 
     bool get(const K& key, V& value) override {
         if (!use_cache_) {
             return false;
         }
-        std::lock_guard<std::mutex> lck(this->mutex_);
-        if(this->map_.find(key) == map_.end()) {
-            this->cache_info_.miss++;
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lck(shard.mutex_);
+        if (!shard.policy_.get(key, value)) {
+            shard.stats_.miss++;
             return false;
         }
-        list_.splice(list_.begin(), list_, map_[key]);
-        value = *map_[key];
-        cache_info_.hit++;
+        shard.stats_.hit++;
         return true;
     }
 
@@ -73,28 +476,121 @@ public:
         if (!use_cache_) {
             return ;
         }
-        std::lock_guard<std::mutex> lck(mutex_);
-        if(map_.find(key) != map_.end()) {
-            *map_[key] = value;
-            list_.splice(list_.begin(), list_, map_[key]);
+        size_t charge = capacity_bytes_ > 0 ? CacheEntryBytes(key, value) : 1;
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lck(shard.mutex_);
+        if (charge > shard.capacity_) {
+            shard.stats_.reject++;
+            return;
+        }
+        bool inserted;
+        shard.stats_.eviction += shard.policy_.put(key, value, charge, inserted);
+        if (inserted) {
+            shard.stats_.insert++;
         } else {
-            if(map_.size() < capacity_) {
-                map_[key] = list_.insert(list_.begin(), value);
-            } else {
-                map_.erase(find_if(map_.begin(), map_.end(), [&](const auto x) {
-                    return x.second == (--list_.end());
-                }));
-                list_.pop_back();
-                map_[key] = list_.insert(list_.begin(), value);
+            shard.stats_.update++;
+        }
+    }
+
+    CacheStats getCacheStats() override {
+        CacheStats stats;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lck(shard->mutex_);
+            stats.hit += shard->stats_.hit;
+            stats.miss += shard->stats_.miss;
+            stats.insert += shard->stats_.insert;
+            stats.update += shard->stats_.update;
+            stats.eviction += shard->stats_.eviction;
+            stats.reject += shard->stats_.reject;
+            stats.size += shard->policy_.size();
+            if (capacity_bytes_ > 0) {
+                stats.bytes += shard->policy_.charge();
             }
         }
+        stats.capacity = capacity_;
+        stats.capacity_bytes = capacity_bytes_;
+        return stats;
     }
 
-    
+    size_t shardNum() const { return shards_.size(); }
+
     using BasicCache<K, V>::use_cache_;
     using BasicCache<K, V>::capacity_;
-    using BasicCache<K, V>::map_;
-    using BasicCache<K, V>::list_;
-    using BasicCache<K, V>::mutex_;
-    using BasicCache<K, V>::cache_info_;
-};
\ No newline at end of file
+    using BasicCache<K, V>::capacity_bytes_;
+
+private:
+    struct Shard {
+        explicit Shard(size_t capacity) : capacity_(capacity), policy_(capacity) {}
+        size_t capacity_;
+        std::mutex mutex_;
+        Policy policy_;
+        CacheStats stats_;
+    };
+
+    Shard& shardOf(const K& key) {
+        // the maps of the shards hash the same key again, mix the bits so
+        // that a shard does not only get the keys of a few of its buckets
+        uint64_t h = std::hash<K>()(key) * 0x9E3779B97F4A7C15ull;
+        return *shards_[(h >> 32) % shards_.size()];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * TieredCache
+ * A memory cache in front of a slower one, e.g. on disk. A get that misses
+ * the memory and hits the lower tier brings the entry back into memory,
+ * a put goes to both.
+ */
+template<typename K, typename V>
+class TieredCache : public BasicCache<K, V> {
+public:
+    TieredCache(const Json::Value& config,
+                std::shared_ptr<BasicCache<K, V>> memory,
+                std::shared_ptr<BasicCache<K, V>> lower):
+                BasicCache<K, V>(config),
+                memory_(memory),
+                lower_(lower) {}
+
+    bool get(const K& key, V& value) override {
+        if (memory_->get(key, value)) {
+            return true;
+        }
+        if (lower_->get(key, value)) {
+            memory_->put(key, value);
+            return true;
+        }
+        return false;
+    }
+
+    void put(const K& key, const V& value) override {
+        memory_->put(key, value);
+        lower_->put(key, value);
+    }
+
+    // the hits of both tiers, the misses of the lower one, the entries and
+    // evictions of the memory
+    CacheStats getCacheStats() override {
+        CacheStats stats = memory_->getCacheStats();
+        CacheStats lower = lower_->getCacheStats();
+        stats.hit += lower.hit;
+        stats.miss = lower.miss;
+        stats.lower_hit = lower.hit;
+        stats.lower_size = lower.size;
+        return stats;
+    }
+
+private:
+    std::shared_ptr<BasicCache<K, V>> memory_;
+    std::shared_ptr<BasicCache<K, V>> lower_;
+};
+
+template<typename K, typename V>
+using LruCache = ShardedCache<K, V, LruPolicy<K, V>>;
+
+template<typename K, typename V>
+using LfuCache = ShardedCache<K, V, LfuPolicy<K, V>>;
+
+template<typename K, typename V>
+using ArcCache = ShardedCache<K, V, ArcPolicy<K, V>>;
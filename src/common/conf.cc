@@ -1,5 +1,6 @@
 #include "conf.hh"
 #include "logger.hh"
+#include "quantize.hh"
 
 Config::Config(const std::string& _conf_path):conf_path(_conf_path) {}
 
@@ -99,11 +100,122 @@ void Config::parse() {
         if(!triton_config.isString()) {
             scale = triton_config.get("scale", "null").asString();
             model_name = triton_config.get("model", "null").asString();
+            model_names.clear();
+            auto models_array = triton_config.get("models", Json::Value());
+            if (models_array.isArray()) {
+                for (Json::Value::ArrayIndex i = 0; i < models_array.size(); ++i) {
+                    if (models_array[i].isString()) {
+                        model_names.emplace_back(models_array[i].asString());
+                    }
+                }
+            }
+            if (model_names.empty()) {
+                model_names.emplace_back(model_name);
+            }
+            LOG_INFO("Parsed %ld served models", model_names.size());
             LOG_INFO("Parsed scale: %s, model name: %s", scale.c_str(), model_name.c_str());
+
+            // the triton endpoints of the backend, "urls" takes precedence
+            // over the single "url"
+            triton_urls.clear();
+            auto urls_array = triton_config.get("urls", Json::Value());
+            if (urls_array.isArray()) {
+                for (Json::Value::ArrayIndex i = 0; i < urls_array.size(); ++i) {
+                    if (urls_array[i].isString()) {
+                        triton_urls.emplace_back(urls_array[i].asString());
+                    }
+                }
+            }
+            if (triton_urls.empty()) {
+                triton_urls.emplace_back(triton_config.get("url", "localhost:8001").asString());
+            }
+            for (const auto& url : triton_urls) {
+                LOG_INFO("Parsed triton endpoint: %s", url.c_str());
+            }
+
+            infer_mode = triton_config.get("infer_mode", "sync").asString();
+            max_inflight = triton_config.get("max_inflight", 1).asUInt();
+            if (max_inflight == 0) {
+                max_inflight = 1;
+            }
+            infer_workers = triton_config.get("infer_workers",
+                infer_mode == "async" ? 1 : (uint32_t)triton_urls.size()).asUInt();
+            if (infer_workers == 0) {
+                infer_workers = 1;
+            }
+            LOG_INFO("Parsed infer mode: %s, max inflight batches: %d, infer workers: %d", infer_mode.c_str(), max_inflight, infer_workers);
+
+            use_shm = triton_config.get("use_shm", false).asBool();
+            shm_slots = triton_config.get("shm_slots", max_inflight + 2).asUInt();
+            LOG_INFO("Parsed use shared memory: %d, slots: %d", use_shm, shm_slots);
+
+            feature_precision = triton_config.get("feature_precision", "fp32").asString();
+            FeaturePrecision precision;
+            if (!ParseFeaturePrecision(feature_precision, &precision)) {
+                LOG_ERROR("Unknown feature precision: %s, use fp32", feature_precision.c_str());
+                feature_precision = "fp32";
+            }
+            LOG_INFO("Parsed feature precision: %s", feature_precision.c_str());
+            backup_top_k = triton_config.get("backup_top_k", 0).asUInt();
+            LOG_INFO("Parsed backup top k: %d", backup_top_k);
+            retain_features = triton_config.get("retain_features", false).asBool();
+            retained_feature_ttl_ms = triton_config.get("retained_feature_ttl_ms", 10000).asUInt();
+            retained_feature_bytes = triton_config.get("retained_feature_bytes", Json::UInt64(256) << 20).asUInt64();
+            LOG_INFO("Parsed retain features: %d, ttl: %d ms, bytes: %ld",
+                     retain_features, retained_feature_ttl_ms, retained_feature_bytes);
+
+            engine = triton_config.get("engine", "triton").asString();
+            torch_model_dir = triton_config.get("torch_model_dir", "models").asString();
+            intra_op_threads = triton_config.get("intra_op_threads", 0).asUInt();
+            inter_op_threads = triton_config.get("inter_op_threads", 0).asUInt();
+            if (engine == "torch") {
+                // the torch engine answers every batch before returning and
+                // reads the batches from process memory
+                infer_mode = "sync";
+                use_shm = false;
+                LOG_INFO("Parsed engine: torch, model dir: %s, intra-op threads: %d, inter-op threads: %d",
+                         torch_model_dir.c_str(), intra_op_threads, inter_op_threads);
+            } else if (engine != "triton") {
+                LOG_ERROR("Unknown engine: %s, use triton", engine.c_str());
+                engine = "triton";
+            }
         }else {
             LOG_ERROR("Not find triton config!");
         }
 
+        server_config = root.get("server_config", "null");
+        if (!server_config.isString()) {
+            server_mode = server_config.get("mode", "sync").asString();
+            cq_threads = server_config.get("cq_threads", 4).asUInt();
+            drain_notice_file = server_config.get("drain_notice_file", "").asString();
+            drain_poll_ms = server_config.get("drain_poll_ms", 200).asUInt();
+            drain_timeout_ms = server_config.get("drain_timeout_ms", 20000).asUInt();
+            auto warmup_config = server_config.get("warmup", Json::Value());
+            if (warmup_config.isObject()) {
+                warmup_rounds = warmup_config.get("rounds", 2).asUInt();
+                auto batch_sizes = warmup_config.get("batch_sizes", Json::Value());
+                for (Json::Value::ArrayIndex i = 0; batch_sizes.isArray() && i < batch_sizes.size(); ++i) {
+                    warmup_batch_sizes.push_back(std::max(batch_sizes[i].asUInt(), 1u));
+                }
+            }
+        } else {
+            server_mode = "sync";
+            cq_threads = 4;
+        }
+        if (cq_threads == 0) {
+            cq_threads = 1;
+        }
+        if (drain_poll_ms == 0) {
+            drain_poll_ms = 1;
+        }
+        LOG_INFO("Parsed server mode: %s, completion queue threads: %d", server_mode.c_str(), cq_threads);
+        LOG_INFO("Parsed drain notice file: %s, poll: %d ms, timeout: %d ms",
+                 drain_notice_file.c_str(), drain_poll_ms, drain_timeout_ms);
+        LOG_INFO("Parsed warm-up rounds: %d, batch sizes: %ld", warmup_rounds, warmup_batch_sizes.size());
+
+        // only read by the mock triton server
+        mock_config = root.get("mock_config", "null");
+
         preprocess_config = root.get("preprocess_config", "null");
         if(!preprocess_config.isString()) {
             format = preprocess_config.get("format", "null").asString();
@@ -113,6 +225,10 @@ void Config::parse() {
             width = preprocess_config.get("width", 300).asUInt();
             LOG_INFO("Parsed format: %s, dtype: %s, channels: %d, height: %d, width: %d",
                      format.c_str(), dtype.c_str(), channels, height, width);
+            compressed_backup = preprocess_config.get("compressed_backup", false).asBool();
+            preprocess_threads = std::max(preprocess_config.get("backend_threads", 2).asUInt(), 1u);
+            LOG_INFO("Parsed compressed backup: %d, backend preprocess threads: %d",
+                     compressed_backup, preprocess_threads);
         }else {
             LOG_ERROR("Not find preprocess config!");
         }
@@ -183,12 +299,51 @@ void Config::parse() {
             }
             else if (batch_mode == "auto") {
                 max_batch_size = batch_config.get("max_batch_size", 64).asUInt();
-                inc_value = batch_config.get("inc_value", 10).asUInt();
-                dec_value = batch_config.get("dec_value", 0.1).asDouble();
-                batch_size_1 = max_batch_size/2;
-                batch_size_2 = max_batch_size/2;
+                latency_slo_ms_1 = batch_config.get("latency_slo_ms_1", 100.0).asDouble();
+                latency_slo_ms_2 = batch_config.get("latency_slo_ms_2", 100.0).asDouble();
+                adjust_interval_ms = batch_config.get("adjust_interval_ms", 1000).asUInt();
+                batch_size_1 = batch_config.get("batch_size_1", max_batch_size/2).asUInt();
+                batch_size_2 = batch_config.get("batch_size_2", max_batch_size/2).asUInt();
+                LOG_INFO("Parsed latency slo, backup: %lf ms, cdc: %lf ms, adjust interval: %d ms",
+                         latency_slo_ms_1, latency_slo_ms_2, adjust_interval_ms);
             }
             LOG_INFO("Parsed batch size, batch_size_1: %d, batch_size_2: %d", batch_size_1, batch_size_2);
+            max_queue_delay_us = batch_config.get("max_queue_delay_us", 0).asUInt();
+            LOG_INFO("Parsed max queue delay: %d us", max_queue_delay_us);
+            auto recompute_config = batch_config.get("recompute", Json::Value());
+            if (recompute_config.isObject()) {
+                recompute_batch_size = recompute_config.get("max_batch_size", 0).asUInt();
+                recompute_queue_delay_us = recompute_config.get("max_queue_delay_us", 1000).asUInt();
+            }
+            // a recompute never waits for a full batch
+            recompute_queue_delay_us = std::max(recompute_queue_delay_us, 1u);
+            LOG_INFO("Parsed recompute max batch size: %d, max queue delay: %d us",
+                     recompute_batch_size, recompute_queue_delay_us);
+            auto scheduler_config = batch_config.get("scheduler", Json::Value());
+            if (scheduler_config.isObject()) {
+                scheduler_policy = scheduler_config.get("policy", "fifo").asString();
+                auto weights = scheduler_config.get("weights", Json::Value());
+                if (weights.isObject()) {
+                    recompute_weight = weights.get("recompute", 1).asUInt();
+                    backup_weight = weights.get("backup", 1).asUInt();
+                    cdc_weight = weights.get("cdc", 1).asUInt();
+                }
+                query_deadline_ms = scheduler_config.get("query_deadline_ms", 0.0).asDouble();
+            }
+            LOG_INFO("Parsed scheduler policy: %s, weights recompute: %d, backup: %d, cdc: %d, query deadline: %lf ms",
+                     scheduler_policy.c_str(), recompute_weight, backup_weight, cdc_weight, query_deadline_ms);
+            auto fairness_config = batch_config.get("fairness", Json::Value());
+            if (fairness_config.isObject()) {
+                fairness_policy = fairness_config.get("policy", "fifo").asString();
+                auto weights = fairness_config.get("weights", Json::Value());
+                if (weights.isObject()) {
+                    // keyed by the frontend id
+                    for (const auto& front_id : weights.getMemberNames()) {
+                        frontend_weights[uint32_t(std::strtoul(front_id.c_str(), nullptr, 10))] = std::max(weights[front_id].asUInt(), 1u);
+                    }
+                }
+            }
+            LOG_INFO("Parsed fairness policy: %s, frontend weights: %ld", fairness_policy.c_str(), frontend_weights.size());
         }
         else {
             LOG_ERROR("Not find batch config!");
@@ -36,6 +36,8 @@ public:
     Json::Value client_config;
     Json::Value monitor_config;
     Json::Value arima_config;
+    Json::Value mock_config;
+    Json::Value server_config;
     
     uint32_t backup_num;
     // std::vector<std::pair<std::string, std::vector<std::string>>> backend_IPs{};  //[region, [trace_file_path, ip_list]]
@@ -43,6 +45,49 @@ public:
 
     std::string scale;
     std::string model_name;
+    std::vector<std::string> triton_urls;
+    // the models served by a backend, model_name is the first one
+    std::vector<std::string> model_names;
+    std::string infer_mode;
+    uint32_t max_inflight;
+    uint32_t infer_workers;
+    bool use_shm;
+    uint32_t shm_slots;
+    // fp32, fp16 or int8, the encoding of the features in the replies
+    std::string feature_precision;
+    // the backup queries are answered with this many top classes instead
+    // of the full reply, 0 for the full reply
+    uint32_t backup_top_k = 0;
+    // the irevnet CDC queries are answered with their prediction, the
+    // backend keeps their feature maps for retained_feature_ttl_ms, within
+    // retained_feature_bytes, and the frontend fetches them when a stripe
+    // has to be decoded
+    bool retain_features = false;
+    uint32_t retained_feature_ttl_ms = 10000;
+    uint64_t retained_feature_bytes = 256ull << 20;
+    // triton, or torch to run the models in the backend process from
+    // <torch_model_dir>/<model>.pt on the cpu. 0 threads keeps the default
+    // of libtorch
+    std::string engine = "triton";
+    std::string torch_model_dir;
+    uint32_t intra_op_threads = 0;
+    uint32_t inter_op_threads = 0;
+
+    // backend server config, sync or async, and the completion queue
+    // threads of the async server
+    std::string server_mode;
+    uint32_t cq_threads;
+    // the backend drains on SIGTERM or once drain_notice_file exists,
+    // checked every drain_poll_ms. It answers what it can for
+    // drain_timeout_ms, then rejects the rest
+    std::string drain_notice_file;
+    uint32_t drain_poll_ms = 200;
+    uint32_t drain_timeout_ms = 20000;
+    // before serving, the backend infers warmup_rounds synthetic batches of
+    // every size up to the largest its batchers send, or of
+    // warmup_batch_sizes when set. 0 rounds skips the warm-up
+    uint32_t warmup_rounds = 2;
+    std::vector<uint32_t> warmup_batch_sizes;
 
     // preprocess config
     std::string format;
@@ -52,14 +97,44 @@ public:
     uint32_t channels;
     uint32_t height;
     uint32_t width;
+    // the backup queries are sent as the encoded image and preprocessed by
+    // preprocess_threads threads of the backend
+    bool compressed_backup = false;
+    uint32_t preprocess_threads = 2;
     bool use_cuda;
     std::string batch_mode;
     uint32_t batch_size_1;
     uint32_t batch_size_2;
     uint32_t default_batch_size;
     uint32_t max_batch_size;
-    uint32_t inc_value;
-    double dec_value;
+    // in auto mode the batch sizes of the backup (1) and CDC (2) queries
+    // are the largest whose latency stays within these
+    double latency_slo_ms_1 = 0;
+    double latency_slo_ms_2 = 0;
+    uint32_t adjust_interval_ms = 1000;
+    // a partial batch is flushed once its oldest query waited this long,
+    // 0 waits for a full batch
+    uint32_t max_queue_delay_us = 0;
+    // the recomputes of a model are batched apart, up to
+    // recompute_batch_size queries (0 for the max batch size of the model)
+    // or until the oldest one waited recompute_queue_delay_us
+    uint32_t recompute_batch_size = 0;
+    uint32_t recompute_queue_delay_us = 1000;
+    // the order the backend serves the ready batches in: fifo, weighted or
+    // edf, with the shares of the classes under weighted. The recompute
+    // batches always go first
+    std::string scheduler_policy = "fifo";
+    uint32_t recompute_weight = 1;
+    uint32_t backup_weight = 1;
+    uint32_t cdc_weight = 1;
+    // the frontend gives every query this long to be answered, 0 for no
+    // deadline
+    double query_deadline_ms = 0;
+    // how the batchers pick the queries of a batch among the frontends:
+    // fifo, or drr to give every frontend its weight of queries per round
+    // (1 by default)
+    std::string fairness_policy = "fifo";
+    std::unordered_map<uint32_t, uint32_t> frontend_weights;
 
     // client config
     double query_rate;
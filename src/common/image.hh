@@ -36,6 +36,8 @@ struct ImageClassifyArgs {
   bool is_parity_data_ = false;
   bool end_signal_ = false;
   bool is_recompute_ = false;
+  // data is the encoded image, not the input tensor
+  bool compressed_ = false;
 };
 
 
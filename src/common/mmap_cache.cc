@@ -0,0 +1,262 @@
+#include "mmap_cache.hh"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMmapCacheMagic[8] = {'S', 'P', 'O', 'T', 'C', 'A', 'C', 'H'};
+static const uint32_t kMmapCacheVersion = 1;
+// the index records start after a page of header
+static const size_t kMmapCacheHeaderSize = 4096;
+
+/**
+ * MmapCache
+ *
+ */
+MmapCache::MmapCache(const Json::Value& cache_config):
+                     BasicCache<std::string, std::string>(cache_config),
+                     fd_(-1),
+                     base_(nullptr),
+                     file_size_(0),
+                     slots_offset_(0),
+                     next_slot_(0),
+                     next_seq_(1),
+                     open_ms_(0)
+{
+    auto disk_config = cache_config.get("disk", Json::Value());
+    path_ = disk_config.get("path", "").asString();
+    slot_size_ = std::max(disk_config.get("slot_size", 262144).asUInt(), uint32_t(sizeof(SlotHeader) + 1));
+    slot_num_ = std::max<uint64_t>(disk_config.get("slots", 4096).asUInt64(), 1);
+    sync_ = disk_config.get("sync", false).asBool();
+    capacity_ = slot_num_;
+    if (!use_cache_ || path_.empty()) {
+        use_cache_ = false;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!open()) {
+        use_cache_ = false;
+        return;
+    }
+    rebuild();
+    open_ms_ = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+               (std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("MmapCache %s: %ld slots of %d bytes, %ld entries recovered in %lf ms",
+             path_.c_str(), slot_num_, slot_size_, index_.size(), open_ms_);
+}
+
+MmapCache::~MmapCache() {
+    if (base_ != nullptr) {
+        msync(base_, file_size_, MS_SYNC);
+        munmap(base_, file_size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool MmapCache::open() {
+    size_t page = getpagesize();
+    slots_offset_ = kMmapCacheHeaderSize + (slot_num_ * sizeof(IndexRecord) + page - 1) / page * page;
+    file_size_ = slots_offset_ + slot_num_ * slot_size_;
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("MmapCache open %s failed: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    fstat(fd_, &st);
+    bool fresh = size_t(st.st_size) != file_size_;
+    FileHeader header;
+    if (!fresh) {
+        fresh = pread(fd_, &header, sizeof(header), 0) != sizeof(header) ||
+                memcmp(header.magic_, kMmapCacheMagic, sizeof(kMmapCacheMagic)) != 0 ||
+                header.version_ != kMmapCacheVersion || header.slot_size_ != slot_size_ ||
+                header.slot_num_ != slot_num_;
+    }
+    if (fresh) {
+        // a new file or one of another layout, start empty. The file is
+        // sparse, the slots cost disk space once they are written
+        LOG_INFO("MmapCache %s: creating a new cache file", path_.c_str());
+        if (ftruncate(fd_, 0) != 0 || ftruncate(fd_, file_size_) != 0) {
+            LOG_ERROR("MmapCache resize %s failed: %s", path_.c_str(), strerror(errno));
+            return false;
+        }
+        memcpy(header.magic_, kMmapCacheMagic, sizeof(kMmapCacheMagic));
+        header.version_ = kMmapCacheVersion;
+        header.slot_size_ = slot_size_;
+        header.slot_num_ = slot_num_;
+        if (pwrite(fd_, &header, sizeof(header), 0) != sizeof(header)) {
+            LOG_ERROR("MmapCache write %s failed: %s", path_.c_str(), strerror(errno));
+            return false;
+        }
+    }
+    void* base = mmap(nullptr, file_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR("MmapCache mmap %s failed: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(base);
+    // the index records are all read on startup
+    madvise(base_, slots_offset_, MADV_WILLNEED);
+    return true;
+}
+
+void MmapCache::rebuild() {
+    uint64_t max_seq = 0;
+    uint64_t last_slot = slot_num_ - 1;
+    for (uint64_t i = 0; i < slot_num_; i++) {
+        const IndexRecord* rec = record(i);
+        if (rec->seq_ == 0) {
+            continue;
+        }
+        if (rec->seq_ > max_seq) {
+            max_seq = rec->seq_;
+            last_slot = i;
+        }
+        auto it = index_.find(rec->key_hash_);
+        // a key put twice keeps its latest slot
+        if (it == index_.end() || record(it->second)->seq_ < rec->seq_) {
+            index_[rec->key_hash_] = i;
+        }
+    }
+    next_seq_ = max_seq + 1;
+    next_slot_ = (last_slot + 1) % slot_num_;
+}
+
+uint8_t* MmapCache::slot(uint64_t index) const {
+    return base_ + slots_offset_ + index * slot_size_;
+}
+
+MmapCache::IndexRecord* MmapCache::record(uint64_t index) const {
+    return reinterpret_cast<IndexRecord*>(base_ + kMmapCacheHeaderSize) + index;
+}
+
+uint64_t MmapCache::keyHash(const std::string& key) {
+    // 0 is left for the free slots
+    return std::max<uint64_t>(std::hash<std::string>()(key), 1);
+}
+
+MmapCache::SlotHeader* MmapCache::slotHeader(uint64_t index) const {
+    return reinterpret_cast<SlotHeader*>(slot(index));
+}
+
+uint64_t MmapCache::checksum(uint64_t seq, const char* key, uint32_t key_size,
+                             const char* value, uint32_t value_size) {
+    uint64_t h = std::hash<std::string_view>()(std::string_view(key, key_size));
+    h ^= std::hash<std::string_view>()(std::string_view(value, value_size)) * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t(key_size) << 32 | value_size) * 0xC2B2AE3D27D4EB4Full;
+    return h ^ seq;
+}
+
+bool MmapCache::get(const std::string& key, std::string& value) {
+    if (!use_cache_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto it = index_.find(keyHash(key));
+    if (it == index_.end()) {
+        stats_.miss++;
+        return false;
+    }
+    const SlotHeader* header = slotHeader(it->second);
+    const char* data = reinterpret_cast<const char*>(slot(it->second) + sizeof(SlotHeader));
+    bool valid = header->seq_ != 0 && header->seq_ == record(it->second)->seq_ &&
+                 uint64_t(header->key_size_) + header->value_size_ + sizeof(SlotHeader) <= slot_size_;
+    if (valid && (header->key_size_ != key.size() || memcmp(data, key.data(), key.size()) != 0)) {
+        // another key with the same hash
+        stats_.miss++;
+        return false;
+    }
+    if (!valid || header->checksum_ != checksum(header->seq_, data, header->key_size_,
+                                                data + header->key_size_, header->value_size_)) {
+        // written partly before a crash
+        LOG_ERROR("MmapCache %s: slot %ld is corrupted, dropped", path_.c_str(), it->second);
+        index_.erase(it);
+        stats_.miss++;
+        return false;
+    }
+    value.assign(data + header->key_size_, header->value_size_);
+    stats_.hit++;
+    return true;
+}
+
+void MmapCache::put(const std::string& key, const std::string& value) {
+    if (!use_cache_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (sizeof(SlotHeader) + key.size() + value.size() > slot_size_) {
+        if (stats_.reject == 0) {
+            LOG_ERROR("MmapCache %s: an entry of %ld bytes does not fit in a slot of %d bytes, "
+                      "entries this large are not cached", path_.c_str(),
+                      sizeof(SlotHeader) + key.size() + value.size(), slot_size_);
+        }
+        stats_.reject++;
+        return;
+    }
+    uint64_t index = next_slot_;
+    next_slot_ = (next_slot_ + 1) % slot_num_;
+    SlotHeader* header = slotHeader(index);
+    IndexRecord* rec = record(index);
+    uint8_t* data = slot(index) + sizeof(SlotHeader);
+
+    // drop the entry the slot held, and invalidate the slot before writing
+    // it, so that a crash never leaves the old key over the new value
+    if (rec->seq_ != 0) {
+        auto it = index_.find(rec->key_hash_);
+        if (it != index_.end() && it->second == index) {
+            index_.erase(it);
+            stats_.eviction++;
+        }
+        rec->seq_ = 0;
+        header->seq_ = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    memcpy(data, key.data(), key.size());
+    memcpy(data + key.size(), value.data(), value.size());
+    uint64_t seq = next_seq_++;
+    header->key_size_ = key.size();
+    header->value_size_ = value.size();
+    header->checksum_ = checksum(seq, key.data(), key.size(), value.data(), value.size());
+    uint64_t key_hash = keyHash(key);
+    rec->key_hash_ = key_hash;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->seq_ = seq;
+    rec->seq_ = seq;
+
+    if (sync_) {
+        syncRange(header, data + key.size() + value.size());
+        syncRange(rec, rec + 1);
+    }
+
+    auto it = index_.find(key_hash);
+    if (it != index_.end()) {
+        it->second = index;
+        stats_.update++;
+    } else {
+        index_.emplace(key_hash, index);
+        stats_.insert++;
+    }
+}
+
+void MmapCache::syncRange(const void* begin, const void* end) {
+    // msync works on whole pages
+    uintptr_t page_begin = reinterpret_cast<uintptr_t>(begin) & ~uintptr_t(getpagesize() - 1);
+    msync(reinterpret_cast<void*>(page_begin), reinterpret_cast<uintptr_t>(end) - page_begin, MS_SYNC);
+}
+
+CacheStats MmapCache::getCacheStats() {
+    std::lock_guard<std::mutex> lck(mutex_);
+    CacheStats stats = stats_;
+    stats.size = index_.size();
+    stats.capacity = slot_num_;
+    stats.capacity_bytes = slot_num_ * slot_size_;
+    return stats;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "cache.hh"
+
+/**
+ * MmapCache
+ * A cache in a memory-mapped file, so that a backend restarted after a
+ * preemption finds the results of its previous run. Configured under
+ * cache_config.disk: "path", "slot_size" (bytes), "slots" and "sync".
+ *
+ * The file is a page of header, an index of 16 bytes per slot, and the
+ * fixed-size slots used as a circular log. A put writes the next slot and
+ * overwrites the oldest entry, so the tier evicts in insertion order. Every
+ * slot starts with a header holding a sequence number and a checksum of the
+ * entry, its index record holds the hash of the key and the same sequence
+ * number, and the sequence numbers are written last:
+ *  - an entry cut by a crash fails its checksum and is ignored,
+ *  - on startup the index is rebuilt from the index records alone, a read
+ *    of 1 MiB for 64Ki slots, the slots are checked when they are read,
+ *  - with "sync" every put is flushed to the disk before it returns,
+ *    otherwise the kernel writes the pages back, which survives a crash of
+ *    the process but not of the machine.
+ * Entries that do not fit in a slot are not cached.
+ */
+class MmapCache : public BasicCache<std::string, std::string> {
+public:
+    MmapCache(const Json::Value& cache_config);
+    ~MmapCache();
+
+    bool get(const std::string& key, std::string& value) override;
+    void put(const std::string& key, const std::string& value) override;
+    CacheStats getCacheStats() override;
+
+    // the time taken to map the file and rebuild the index, in ms
+    double OpenTimeMs() const { return open_ms_; }
+
+private:
+    struct FileHeader {
+        char magic_[8];
+        uint32_t version_;
+        uint32_t slot_size_;
+        uint64_t slot_num_;
+    };
+
+    struct IndexRecord {
+        // 0 for a free slot, the seq_ of the slot otherwise
+        uint64_t seq_;
+        uint64_t key_hash_;
+    };
+
+    struct SlotHeader {
+        // 0 for a free or invalidated slot, the order of the puts otherwise
+        uint64_t seq_;
+        uint64_t checksum_;
+        uint32_t key_size_;
+        uint32_t value_size_;
+    };
+
+    bool open();
+    void rebuild();
+    uint8_t* slot(uint64_t index) const;
+    SlotHeader* slotHeader(uint64_t index) const;
+    IndexRecord* record(uint64_t index) const;
+    static uint64_t keyHash(const std::string& key);
+    static void syncRange(const void* begin, const void* end);
+    static uint64_t checksum(uint64_t seq, const char* key, uint32_t key_size,
+                             const char* value, uint32_t value_size);
+
+    std::string path_;
+    uint32_t slot_size_;
+    uint64_t slot_num_;
+    bool sync_;
+
+    int fd_;
+    uint8_t* base_;
+    size_t file_size_;
+    // where the slots start, after the header and the index records
+    size_t slots_offset_;
+
+    std::mutex mutex_;
+    // the slot of every key, by the hash of the key. The key is compared
+    // with the one in the slot on a get
+    std::unordered_map<uint64_t, uint64_t> index_;
+    // the slot written by the next put
+    uint64_t next_slot_;
+    uint64_t next_seq_;
+    CacheStats stats_;
+    double open_ms_;
+};
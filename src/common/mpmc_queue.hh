@@ -0,0 +1,239 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * MpmcQueue
+ * A bounded multi-producer multi-consumer queue, the array queue of Dmitry
+ * Vyukov. Every cell carries a sequence number telling whether it waits for
+ * the producer or the consumer of the current lap, so push and pop only
+ * race on one atomic counter each and take no lock.
+ *
+ * The blocking calls spin for a while and then park on a condition
+ * variable. The mutex is only taken by the other side when someone is
+ * parked, so a busy hand-off never locks. A parked call retries without
+ * waking anyone and wakes the other side once it has let the mutex go, as
+ * both sides may be parked at the same time.
+ */
+template <typename T>
+class MpmcQueue {
+public:
+  // the capacity is rounded up to a power of two
+  explicit MpmcQueue(size_t capacity = 8192) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i++) {
+      cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // returns false if the queue is full
+  bool TryPush(const T& value) {
+    if (!enqueue(value)) {
+      return false;
+    }
+    wake(pop_waiters_, not_empty_cv_);
+    return true;
+  }
+
+  // waits while the queue is full
+  void Push(const T& value) {
+    if (TryPush(value)) {
+      return;
+    }
+    for (int i = 0; i < kSpinCount; i++) {
+      std::this_thread::yield();
+      if (TryPush(value)) {
+        return;
+      }
+    }
+    {
+      std::unique_lock<std::mutex> lock(park_mtx_);
+      push_waiters_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (!enqueue(value)) {
+        not_full_cv_.wait(lock);
+      }
+      push_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    wake(pop_waiters_, not_empty_cv_);
+  }
+
+  // returns false if the queue is empty
+  bool TryPop(T& value) {
+    if (!dequeue(value)) {
+      return false;
+    }
+    wake(push_waiters_, not_full_cv_);
+    return true;
+  }
+
+  // waits for an element
+  T Pop() {
+    T value;
+    waitPop(value, std::chrono::microseconds(-1));
+    return value;
+  }
+
+  // waits at most 'timeout' for an element, a negative timeout waits forever
+  bool Pop(T& value, std::chrono::microseconds timeout) {
+    return waitPop(value, timeout);
+  }
+
+  // waits at most 'timeout' for the first element, then takes the ones that
+  // are already queued, up to max_num in all. Returns the number appended to
+  // 'values'.
+  size_t PopBulk(std::vector<T>& values, size_t max_num, std::chrono::microseconds timeout) {
+    if (max_num == 0) {
+      return 0;
+    }
+    T value;
+    if (!waitPop(value, timeout)) {
+      return 0;
+    }
+    values.push_back(std::move(value));
+    size_t num = 1;
+    while (num < max_num && TryPop(value)) {
+      values.push_back(std::move(value));
+      num++;
+    }
+    return num;
+  }
+
+  // a snapshot, it may be stale as soon as it is returned
+  size_t Size() const {
+    size_t enqueue = enqueue_pos_.load(std::memory_order_acquire);
+    size_t dequeue = dequeue_pos_.load(std::memory_order_acquire);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+private:
+  static const int kSpinCount = 64;
+
+  struct alignas(64) Cell {
+    std::atomic<size_t> sequence_;
+    T data_;
+  };
+
+  bool waitPop(T& value, std::chrono::microseconds timeout) {
+    if (TryPop(value)) {
+      return true;
+    }
+    if (timeout.count() == 0) {
+      return false;
+    }
+    for (int i = 0; i < kSpinCount; i++) {
+      std::this_thread::yield();
+      if (TryPop(value)) {
+        return true;
+      }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool popped = true;
+    {
+      std::unique_lock<std::mutex> lock(park_mtx_);
+      pop_waiters_.fetch_add(1, std::memory_order_relaxed);
+      // pairs with the fence in wake, either the producer sees the waiter or
+      // the dequeue below sees the element
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (!dequeue(value)) {
+        if (timeout.count() < 0) {
+          not_empty_cv_.wait(lock);
+        } else if (not_empty_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+          popped = dequeue(value);
+          break;
+        }
+      }
+      pop_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (popped) {
+      wake(push_waiters_, not_full_cv_);
+    }
+    return popped;
+  }
+
+  // enqueue and dequeue never take park_mtx_, the parked loops call them
+  // with it held
+  bool enqueue(const T& value) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data_ = value;
+    cell->sequence_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool dequeue(T& value) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->data_);
+    cell->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  void wake(std::atomic<int>& waiters, std::condition_variable& cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0) {
+      // taking the mutex makes sure the waiter is either before its check
+      // or already waiting
+      std::lock_guard<std::mutex> lock(park_mtx_);
+      cv.notify_one();
+    }
+  }
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+
+  alignas(64) std::atomic<int> pop_waiters_{0};
+  std::atomic<int> push_waiters_{0};
+  std::mutex park_mtx_;
+  std::condition_variable not_empty_cv_;
+  std::condition_variable not_full_cv_;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * FeaturePrecision
+ * How the backend encodes the irevnet feature map of a reply. fp32 sends the
+ * triton output as is, fp16 sends half floats, int8 sends a float scale
+ * followed by one signed byte per element, x ~= q * scale with
+ * scale = max|x| / 127.
+ */
+enum class FeaturePrecision {
+    FP32,
+    FP16,
+    INT8
+};
+
+inline bool ParseFeaturePrecision(const std::string& name, FeaturePrecision* precision) {
+    if (name == "fp32") {
+        *precision = FeaturePrecision::FP32;
+    } else if (name == "fp16") {
+        *precision = FeaturePrecision::FP16;
+    } else if (name == "int8") {
+        *precision = FeaturePrecision::INT8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline FeaturePrecision ParseFeaturePrecision(const std::string& name) {
+    FeaturePrecision precision = FeaturePrecision::FP32;
+    ParseFeaturePrecision(name, &precision);
+    return precision;
+}
+
+// bytes on the wire of a feature map of fp32_bytes bytes
+inline size_t FeatureWireSize(FeaturePrecision precision, size_t fp32_bytes) {
+    size_t count = fp32_bytes / sizeof(float);
+    switch (precision) {
+    case FeaturePrecision::FP16:
+        return count * sizeof(uint16_t);
+    case FeaturePrecision::INT8:
+        return sizeof(float) + count;
+    default:
+        return fp32_bytes;
+    }
+}
+
+// round to nearest even, out of range values become inf
+inline uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs = bits & 0x7fffffff;
+    if (abs >= 0x7f800000) {
+        // inf, or a quiet nan
+        return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+    }
+    if (abs >= 0x477ff000) {
+        // 65520 and above round past the largest half
+        return sign | 0x7c00;
+    }
+    if (abs < 0x38800000) {
+        // below 2^-14 the half is subnormal, in units of 2^-24
+        if (abs < 0x33000000) {
+            return sign;
+        }
+        uint32_t mantissa = (abs & 0x007fffff) | 0x00800000;
+        int shift = 126 - (abs >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++;
+        }
+        return sign | half;
+    }
+    // rebias the exponent from 127 to 15, a carry of the rounding moves
+    // into the exponent
+    uint32_t half = (abs >> 13) - (112 << 10);
+    uint32_t rest = abs & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return sign | half;
+}
+
+inline float HalfToFloat(uint16_t half) {
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // subnormal half, normalize it
+        exponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// appends the encoded feature of 'count' floats at 'src' to 'dst', 'src'
+// does not need to be aligned
+inline void QuantizeFeature(const uint8_t* src, size_t count, FeaturePrecision precision, std::string* dst) {
+    size_t offset = dst->size();
+    dst->resize(offset + FeatureWireSize(precision, count * sizeof(float)));
+    uint8_t* out = reinterpret_cast<uint8_t*>(&(*dst)[offset]);
+
+    if (precision == FeaturePrecision::FP32) {
+        std::memcpy(out, src, count * sizeof(float));
+        return;
+    }
+    if (precision == FeaturePrecision::FP16) {
+        for (size_t i = 0; i < count; i++) {
+            float value;
+            std::memcpy(&value, src + i * sizeof(float), sizeof(float));
+            uint16_t half = FloatToHalf(value);
+            std::memcpy(out + i * sizeof(uint16_t), &half, sizeof(half));
+        }
+        return;
+    }
+
+    float max_abs = 0;
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        std::memcpy(&value, src + i * sizeof(float), sizeof(float));
+        max_abs = std::max(max_abs, std::fabs(value));
+    }
+    float scale = max_abs / 127.0f;
+    std::memcpy(out, &scale, sizeof(scale));
+    int8_t* q = reinterpret_cast<int8_t*>(out + sizeof(scale));
+    float inv_scale = scale > 0 ? 1.0f / scale : 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        std::memcpy(&value, src + i * sizeof(float), sizeof(float));
+        float scaled = std::min(std::max(value * inv_scale, -127.0f), 127.0f);
+        q[i] = static_cast<int8_t>(std::lrint(scaled));
+    }
+}
+
+// decodes a feature of 'count' floats encoded by QuantizeFeature into 'dst'
+inline void DequantizeFeature(const uint8_t* src, size_t count, FeaturePrecision precision, float* dst) {
+    if (precision == FeaturePrecision::FP32) {
+        std::memcpy(dst, src, count * sizeof(float));
+        return;
+    }
+    if (precision == FeaturePrecision::FP16) {
+        for (size_t i = 0; i < count; i++) {
+            uint16_t half;
+            std::memcpy(&half, src + i * sizeof(uint16_t), sizeof(half));
+            dst[i] = HalfToFloat(half);
+        }
+        return;
+    }
+
+    float scale;
+    std::memcpy(&scale, src, sizeof(scale));
+    const int8_t* q = reinterpret_cast<const int8_t*>(src + sizeof(scale));
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = q[i] * scale;
+    }
+}
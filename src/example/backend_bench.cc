@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+#include "../protocol/elasticcdc.grpc.pb.h"
+#include "../inc/inc.hh"
+#include "../common/conf.hh"
+
+/**
+ * Load on one backend_server over DataTransStream, as a frontend sends it.
+ * It is meant to run against a backend whose triton_config.url points at a
+ * mock_triton_server, so the numbers can be reproduced without a GPU:
+ *
+ *   mock_triton_server conf/config.json
+ *   backend_server conf/config.json
+ *   backend_bench conf/config.json <mode> ...
+ *
+ * The tensors have the input size of the config (channels x height x width
+ * floats), and each query gets its own so the result cache never hits.
+ * Running the same bench on a commit and on its parent gives the change.
+ *
+ * modes:
+ *   load <queries> <queries per second>: backup and CDC queries at a fixed
+ *       rate, the per batch cost of the backend shows in the throughput and
+ *       the latency
+ *   storm <queries>: all the queries are recomputes sent at once, as after
+ *       a preemption, the recompute lane shows in the tail latency
+ *   ready <timeout s>: started together with backend_server, the time
+ *       until the first query is answered, the warm-up included
+ *
+ * usage: backend_bench <config> <mode> [args] [backend address]
+ */
+
+using Clock = std::chrono::steady_clock;
+using elasticcdc::ElasticcdcReply;
+using elasticcdc::ElasticcdcRequest;
+using elasticcdc::ElasticcdcService;
+
+struct Result {
+    int sent;
+    int replied;
+    int rejected;
+    double seconds;
+    double p50_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+ElasticcdcRequest MakeRequest(const std::string& model_name, const std::string& scale, size_t input_size,
+                              int64_t id, const std::string& encode_type, bool recompute) {
+    ElasticcdcRequest request;
+    request.set_model_name(model_name);
+    request.set_scale(scale);
+    request.set_filename("bench_" + std::to_string(id));
+    request.set_id(id);
+    request.set_frontend_id(0);
+    request.set_encode_type(encode_type);
+    request.set_recompute(recompute);
+    std::string* data = request.mutable_data();
+    data->assign(input_size, '\0');
+    memcpy(&(*data)[0], &id, std::min(sizeof(id), input_size));
+    return request;
+}
+
+// sends 'queries' spaced by 'interval' (all at once if 0) on one stream and
+// waits for their replies
+Result Run(ElasticcdcService::Stub& stub, const Config& conf, const std::string& model_name, int queries,
+           std::chrono::microseconds interval, bool recompute) {
+    size_t input_size = size_t(conf.channels) * conf.height * conf.width * sizeof(float);
+    grpc::ClientContext context;
+    auto stream = stub.DataTransStream(&context);
+
+    std::vector<Clock::time_point> sent_time(queries);
+    std::vector<double> latencies;
+    latencies.reserve(queries);
+    std::mutex mtx;
+    int rejected = 0;
+    std::atomic<int> sent{0};
+    std::thread reader([&]() {
+        ElasticcdcReply reply;
+        int replied = 0;
+        while (replied < queries && stream->Read(&reply)) {
+            auto now = Clock::now();
+            std::lock_guard<std::mutex> lock(mtx);
+            if (reply.id() < 0 || reply.id() >= sent.load()) {
+                continue;
+            }
+            replied++;
+            if (reply.rejected()) {
+                rejected++;
+            } else {
+                latencies.push_back(std::chrono::duration<double, std::milli>(now - sent_time[reply.id()]).count());
+            }
+        }
+    });
+
+    auto start = Clock::now();
+    for (int id = 0; id < queries; id++) {
+        auto request = MakeRequest(model_name, conf.scale, input_size, id,
+                                   id % 2 == 0 ? "Backup" : "CDC", recompute);
+        if (interval.count() > 0) {
+            std::this_thread::sleep_until(start + interval * id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            sent_time[id] = Clock::now();
+        }
+        sent++;
+        if (!stream->Write(request)) {
+            std::cout << "the stream broke after " << id << " queries" << std::endl;
+            break;
+        }
+    }
+    // flushes the partial batches, the backend does not reply to it
+    ElasticcdcRequest end;
+    end.set_model_name(model_name);
+    end.set_frontend_id(0);
+    end.set_id(-1);
+    end.set_end_signal(true);
+    stream->Write(end);
+    reader.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stream->WritesDone();
+    stream->Finish();
+
+    Result result;
+    result.sent = sent.load();
+    result.replied = int(latencies.size()) + rejected;
+    result.rejected = rejected;
+    result.seconds = seconds;
+    result.max_ms = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+    result.p50_ms = percentile(latencies, 0.5);
+    result.p99_ms = percentile(latencies, 0.99);
+    return result;
+}
+
+void Print(const std::string& name, const Result& r) {
+    std::cout << name << ": sent " << r.sent << ", replied " << r.replied << ", rejected " << r.rejected
+              << ", " << (r.replied - r.rejected) / r.seconds << " queries/s"
+              << ", p50 " << r.p50_ms << " ms, p99 " << r.p99_ms << " ms, max " << r.max_ms << " ms" << std::endl;
+}
+
+void usage() {
+    std::cout << "Usage: ./backend_bench <config> load <queries> <queries per second> [backend address]" << std::endl;
+    std::cout << "       ./backend_bench <config> storm <queries> [backend address]" << std::endl;
+    std::cout << "       ./backend_bench <config> ready <timeout s> [backend address]" << std::endl;
+    std::cout << "  the backend address is localhost:50051 by default" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        usage();
+        return 0;
+    }
+    Config conf(argv[1]);
+    conf.parse();
+    std::string mode = argv[2];
+    int args = mode == "load" ? 2 : 1;
+    std::string address = argc > 3 + args ? argv[3 + args] : "localhost:50051";
+    std::string model_name = conf.model_name;
+
+    auto channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+    auto stub = ElasticcdcService::NewStub(channel);
+    if (mode == "load" && argc > 4) {
+        int queries = std::stoi(argv[3]);
+        double rate = std::max(std::stod(argv[4]), 1.0);
+        auto interval = std::chrono::microseconds(int64_t(1e6 / rate));
+        Print("load " + model_name, Run(*stub, conf, model_name, queries, interval, false));
+    } else if (mode == "storm") {
+        int queries = std::stoi(argv[3]);
+        Print("storm " + model_name, Run(*stub, conf, model_name, queries, std::chrono::microseconds(0), true));
+    } else if (mode == "ready") {
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::seconds(std::stoi(argv[3]));
+        while (Clock::now() < deadline) {
+            // the first attempts fail until the backend listens
+            if (channel->WaitForConnected(std::chrono::system_clock::now() + std::chrono::milliseconds(100))) {
+                Result r = Run(*stub, conf, model_name, 1, std::chrono::microseconds(0), false);
+                if (r.replied == 1 && r.rejected == 0) {
+                    std::cout << "ready " << model_name << ": first reply after "
+                              << std::chrono::duration<double, std::milli>(Clock::now() - start).count()
+                              << " ms, its latency " << r.p50_ms << " ms" << std::endl;
+                    return 0;
+                }
+            }
+        }
+        std::cout << "ready " << model_name << ": no reply within " << argv[3] << " s" << std::endl;
+        return 1;
+    } else {
+        usage();
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/cache.hh"
+
+/**
+ * Throughput and hit rate of the backend caches.
+ *
+ * Every thread looks its keys up and puts them on a miss, as the backend
+ * does with the replies. The keys follow a zipf distribution (s = 0.99) over
+ * 4x the capacity, so that the policies have something to choose.
+ * "linear-lru" is the LruCache the backend had before: it found the entry of
+ * the list tail by a scan of the map on every eviction, behind one mutex.
+ *
+ * usage: cache_bench [ops per thread] [max threads]
+ */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename K, typename V>
+class LinearLruCache : public BasicCache<K, V> {
+public:
+    LinearLruCache(const Json::Value& config) : BasicCache<K, V>(config) {}
+
+    bool get(const K& key, V& value) override {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (map_.find(key) == map_.end()) {
+            stats_.miss++;
+            return false;
+        }
+        list_.splice(list_.begin(), list_, map_[key]);
+        value = *map_[key];
+        stats_.hit++;
+        return true;
+    }
+
+    void put(const K& key, const V& value) override {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (map_.find(key) != map_.end()) {
+            *map_[key] = value;
+            list_.splice(list_.begin(), list_, map_[key]);
+        } else {
+            if (map_.size() < size_t(this->capacity_)) {
+                map_[key] = list_.insert(list_.begin(), value);
+            } else {
+                map_.erase(find_if(map_.begin(), map_.end(), [&](const auto& x) {
+                    return x.second == (--list_.end());
+                }));
+                list_.pop_back();
+                map_[key] = list_.insert(list_.begin(), value);
+                stats_.eviction++;
+            }
+        }
+    }
+
+    CacheStats getCacheStats() override {
+        std::lock_guard<std::mutex> lck(mutex_);
+        CacheStats stats = stats_;
+        stats.size = map_.size();
+        return stats;
+    }
+
+private:
+    unordered_map<K, typename list<V>::iterator> map_;
+    list<V> list_;
+    std::mutex mutex_;
+    CacheStats stats_;
+};
+
+// samples ranks 0..n-1 with P(i) ~ 1 / (i + 1)^s
+class Zipf {
+public:
+    Zipf(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(i + 1, s);
+            cdf_[i] = sum;
+        }
+        for (auto& c : cdf_) {
+            c /= sum;
+        }
+    }
+
+    size_t Sample(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+struct Result {
+    double ops_per_sec;
+    double hit_rate;
+    uint64_t eviction;
+};
+
+std::shared_ptr<BasicCache<std::string, std::string>> MakeCache(const std::string& policy, size_t capacity) {
+    Json::Value config;
+    config["use_cache"] = true;
+    config["capacity"] = Json::UInt64(capacity);
+    if (policy == "lru") {
+        return std::make_shared<LruCache<std::string, std::string>>(config);
+    } else if (policy == "lfu") {
+        return std::make_shared<LfuCache<std::string, std::string>>(config);
+    } else if (policy == "arc") {
+        return std::make_shared<ArcCache<std::string, std::string>>(config);
+    }
+    return std::make_shared<LinearLruCache<std::string, std::string>>(config);
+}
+
+std::string Key(size_t rank) {
+    // short enough for the small string buffer, the bench measures the cache
+    // and not the allocator
+    return "k" + std::to_string(rank);
+}
+
+Result Run(const std::string& policy, size_t capacity, const Zipf& zipf, int threads, size_t ops) {
+    auto cache = MakeCache(policy, capacity);
+    const std::string value(64, 'v');
+
+    // fill the cache first, the measured part is the steady state
+    std::mt19937_64 warm_rng(1);
+    for (size_t i = 0; i < 2 * capacity; i++) {
+        cache->put(Key(zipf.Sample(warm_rng)), value);
+    }
+    CacheStats before = cache->getCacheStats();
+
+    // the keys are drawn before the clock starts
+    std::vector<std::vector<std::string>> keys(threads);
+    for (int t = 0; t < threads; t++) {
+        std::mt19937_64 rng(100 + t);
+        keys[t].reserve(ops);
+        for (size_t i = 0; i < ops; i++) {
+            keys[t].push_back(Key(zipf.Sample(rng)));
+        }
+    }
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::string got;
+            for (const auto& key : keys[t]) {
+                if (!cache->get(key, got)) {
+                    cache->put(key, value);
+                }
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    CacheStats after = cache->getCacheStats();
+    uint64_t hit = after.hit - before.hit;
+    uint64_t miss = after.miss - before.miss;
+    return Result{threads * ops / secs, double(hit) / (hit + miss), after.eviction - before.eviction};
+}
+
+int main(int argc, char** argv) {
+    size_t ops = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? std::stoi(argv[2]) : 4;
+    // the linear eviction scans the whole map, beyond this it takes minutes
+    const size_t linear_max_capacity = 10000;
+
+    std::printf("%-10s %9s %7s %12s %8s %10s\n", "policy", "capacity", "threads", "ops/s", "hit", "evictions");
+    for (size_t capacity : {10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul}) {
+        Zipf zipf(4 * capacity, 0.99);
+        for (const std::string policy : {"linear-lru", "lru", "lfu", "arc"}) {
+            if (policy == "linear-lru" && capacity > linear_max_capacity) {
+                continue;
+            }
+            for (int threads = 1; threads <= max_threads; threads *= 4) {
+                Result r = Run(policy, capacity, zipf, threads, ops);
+                std::printf("%-10s %9zu %7d %12.0f %8.4f %10lu\n", policy.c_str(), capacity, threads,
+                            r.ops_per_sec, r.hit_rate, r.eviction);
+                std::fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../common/cache.hh"
+#include "../common/mmap_cache.hh"
+
+/**
+ * What the disk tier of the result cache gives a backend restarted after a
+ * preemption.
+ *
+ * A first run serves zipf(0.99) queries over a set of images, with a get
+ * and a put on miss per query as the backend does. The caches are then
+ * dropped and built again, as a restarted backend_server would, and the
+ * first minute of queries is replayed at a fixed rate against a memory-only
+ * cache (cold) and against the memory cache over the disk tier (warm).
+ * The restart is timed with the file in the page cache and after evicting
+ * it, which is closer to a new machine reading a persistent disk.
+ *
+ * usage: disk_cache_bench [cache file] [images] [first run queries]
+ *                         [queries per second]
+ */
+
+using Clock = std::chrono::steady_clock;
+
+class Zipf {
+public:
+    Zipf(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(i + 1, s);
+            cdf_[i] = sum;
+        }
+        for (auto& c : cdf_) {
+            c /= sum;
+        }
+    }
+
+    size_t Sample(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+Json::Value CacheConfig(const std::string& path) {
+    Json::Value config;
+    config["use_cache"] = true;
+    config["strategy"] = "lru";
+    config["capacity_bytes"] = Json::UInt64(64) << 20;
+    if (!path.empty()) {
+        config["disk"]["path"] = path;
+        config["disk"]["slot_size"] = 8192;
+        config["disk"]["slots"] = 65536;
+    }
+    return config;
+}
+
+std::shared_ptr<BasicCache<std::string, std::string>> MakeCache(const std::string& path, double& open_ms) {
+    auto start = Clock::now();
+    auto config = CacheConfig(path);
+    std::shared_ptr<BasicCache<std::string, std::string>> cache =
+        std::make_shared<LruCache<std::string, std::string>>(config);
+    if (!path.empty()) {
+        auto disk = std::make_shared<MmapCache>(config);
+        cache = std::make_shared<TieredCache<std::string, std::string>>(config, cache, disk);
+    }
+    open_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return cache;
+}
+
+std::string Key(size_t image) {
+    // the shape of a ResultCacheKey
+    char key[64];
+    snprintf(key, sizeof(key), "resnet50/fp16/%016llx/602112",
+             static_cast<unsigned long long>(std::hash<size_t>()(image) * 0x9E3779B97F4A7C15ull));
+    return key;
+}
+
+// serves 'queries', returns the hit rate, and the index of the first hit
+double Serve(BasicCache<std::string, std::string>& cache, const Zipf& zipf, uint64_t seed,
+             size_t queries, size_t& first_hit) {
+    // a 2048 float feature vector in fp16
+    const std::string reply(4096, 'r');
+    std::mt19937_64 rng(seed);
+    std::string got;
+    size_t hit = 0;
+    first_hit = queries;
+    for (size_t i = 0; i < queries; i++) {
+        std::string key = Key(zipf.Sample(rng));
+        if (cache.get(key, got)) {
+            hit++;
+            first_hit = std::min(first_hit, i);
+        } else {
+            cache.put(key, reply);
+        }
+    }
+    return double(hit) / queries;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/disk_cache_bench.bin";
+    size_t images = argc > 2 ? std::stoul(argv[2]) : 200000;
+    size_t first_run = argc > 3 ? std::stoul(argv[3]) : 200000;
+    double rate = argc > 4 ? std::stod(argv[4]) : 200;
+    size_t first_minute = size_t(60 * rate);
+
+    Zipf zipf(images, 0.99);
+    unlink(path.c_str());
+    size_t first_hit;
+    double open_ms;
+    {
+        auto cache = MakeCache(path, open_ms);
+        double hit_rate = Serve(*cache, zipf, 1, first_run, first_hit);
+        CacheStats stats = cache->getCacheStats();
+        printf("first run: %zu queries over %zu images, hit rate %.4f, disk entries %zu\n",
+               first_run, images, hit_rate, stats.lower_size);
+    }
+
+    // restart with the file in the page cache
+    {
+        auto cache = MakeCache(path, open_ms);
+        printf("restart, file cached: open %.2f ms, disk entries %zu\n", open_ms, cache->getCacheStats().lower_size);
+    }
+    // restart after evicting the file from the page cache
+    int fd = open(path.c_str(), O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    auto warm = MakeCache(path, open_ms);
+    printf("restart, file evicted: open %.2f ms, disk entries %zu\n", open_ms, warm->getCacheStats().lower_size);
+
+    auto cold = MakeCache("", open_ms);
+    double cold_rate = Serve(*cold, zipf, 2, first_minute, first_hit);
+    printf("first minute (%zu queries at %.0f/s), memory only: hit rate %.4f, first hit at query %zu\n",
+           first_minute, rate, cold_rate, first_hit);
+    auto start = Clock::now();
+    double warm_rate = Serve(*warm, zipf, 2, first_minute, first_hit);
+    double serve_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    CacheStats stats = warm->getCacheStats();
+    printf("first minute (%zu queries at %.0f/s), memory + disk: hit rate %.4f, first hit at query %zu, "
+           "disk hits %lu, %.2f us per query\n",
+           first_minute, rate, warm_rate, first_hit, stats.lower_hit, serve_ms * 1000 / first_minute);
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/quantize.hh"
+
+/**
+ * Bytes on the wire and error of the reply features of each precision.
+ *
+ * The features are random, either gaussian or laplacian, the latter has the
+ * heavy tails that hurt a per-tensor int8 scale the most. Besides the error
+ * of a single feature, it reports the error of the linear decoding of a
+ * stripe, where the lost feature is k * parity - sum(others): every term
+ * carries its quantization error, and the parity one is scaled by k.
+ */
+
+struct ErrorStat {
+    double rmse;
+    double max_abs;
+    double rel_l2;
+};
+
+ErrorStat compare(const std::vector<float>& ref, const std::vector<float>& val) {
+    double se = 0, norm = 0, max_abs = 0;
+    for (size_t i = 0; i < ref.size(); i++) {
+        double diff = double(val[i]) - ref[i];
+        se += diff * diff;
+        norm += double(ref[i]) * ref[i];
+        max_abs = std::max(max_abs, std::fabs(diff));
+    }
+    return ErrorStat{std::sqrt(se / ref.size()), max_abs, norm > 0 ? std::sqrt(se / norm) : 0};
+}
+
+std::vector<float> randomFeature(std::mt19937& gen, size_t count, const std::string& dist) {
+    std::vector<float> feature(count);
+    std::normal_distribution<float> normal(0, 1);
+    std::exponential_distribution<float> exponential(1);
+    std::bernoulli_distribution coin(0.5);
+    for (auto& value : feature) {
+        value = dist == "laplace" ? (coin(gen) ? 1 : -1) * exponential(gen) : normal(gen);
+    }
+    return feature;
+}
+
+std::vector<float> roundTrip(const std::vector<float>& feature, FeaturePrecision precision,
+                             size_t* wire_size, double* encode_ms, double* decode_ms) {
+    std::string wire;
+    auto start = std::chrono::high_resolution_clock::now();
+    QuantizeFeature(reinterpret_cast<const uint8_t*>(feature.data()), feature.size(), precision, &wire);
+    auto mid = std::chrono::high_resolution_clock::now();
+    std::vector<float> decoded(feature.size());
+    DequantizeFeature(reinterpret_cast<const uint8_t*>(wire.data()), feature.size(), precision, decoded.data());
+    auto end = std::chrono::high_resolution_clock::now();
+
+    *wire_size = wire.size();
+    *encode_ms += std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(mid - start).count();
+    *decode_ms += std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - mid).count();
+    return decoded;
+}
+
+void runBench(size_t count, uint32_t k, int rounds, const std::string& dist) {
+    std::mt19937 gen(42);
+    const FeaturePrecision precisions[] = {FeaturePrecision::FP32, FeaturePrecision::FP16, FeaturePrecision::INT8};
+    const char* names[] = {"fp32", "fp16", "int8"};
+
+    std::cout << "distribution: " << dist << ", floats per feature: " << count
+              << ", k: " << k << ", rounds: " << rounds << std::endl;
+    std::cout << "precision\twire bytes\tratio\tencode ms\tdecode ms\tfeature rmse\tfeature max err\tfeature rel l2\tdecoded rel l2" << std::endl;
+    for (int p = 0; p < 3; p++) {
+        size_t wire_size = 0;
+        double encode_ms = 0, decode_ms = 0;
+        ErrorStat feature_err{0, 0, 0};
+        double decoded_rel = 0;
+        for (int r = 0; r < rounds; r++) {
+            // k data features and their parity, the mean of them
+            std::vector<std::vector<float>> data;
+            std::vector<float> parity(count, 0);
+            for (uint32_t i = 0; i < k; i++) {
+                data.push_back(randomFeature(gen, count, dist));
+                for (size_t j = 0; j < count; j++) {
+                    parity[j] += data[i][j] / k;
+                }
+            }
+
+            std::vector<std::vector<float>> received;
+            for (uint32_t i = 0; i + 1 < k; i++) {
+                received.push_back(roundTrip(data[i], precisions[p], &wire_size, &encode_ms, &decode_ms));
+            }
+            auto received_parity = roundTrip(parity, precisions[p], &wire_size, &encode_ms, &decode_ms);
+
+            ErrorStat err = compare(data[0], received[0]);
+            feature_err.rmse += err.rmse / rounds;
+            feature_err.max_abs = std::max(feature_err.max_abs, err.max_abs);
+            feature_err.rel_l2 += err.rel_l2 / rounds;
+
+            // recover the last data feature from the others and the parity
+            std::vector<float> lost(count);
+            for (size_t j = 0; j < count; j++) {
+                float sum = 0;
+                for (const auto& feature : received) {
+                    sum += feature[j];
+                }
+                lost[j] = received_parity[j] * k - sum;
+            }
+            decoded_rel += compare(data[k - 1], lost).rel_l2 / rounds;
+        }
+        int replies = rounds * k;
+        std::cout << names[p] << "\t\t" << wire_size << "\t\t"
+                  << double(count * sizeof(float)) / wire_size << "\t"
+                  << encode_ms / replies << "\t" << decode_ms / replies << "\t"
+                  << feature_err.rmse << "\t" << feature_err.max_abs << "\t"
+                  << feature_err.rel_l2 << "\t" << decoded_rel << std::endl;
+    }
+}
+
+void usage() {
+    std::cout << "Usage: ./feature_quant_bench [floats_per_feature] [k] [rounds]" << std::endl;
+    std::cout << "  floats_per_feature defaults to 512*8*8, the feature of cifar10-irevnet" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 4) {
+        usage();
+        return 0;
+    }
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 512 * 8 * 8;
+    uint32_t k = argc > 2 ? std::stoul(argv[2]) : 4;
+    int rounds = argc > 3 ? std::stoi(argv[3]) : 50;
+    if (k < 2) {
+        std::cout << "k should be at least 2" << std::endl;
+        return 1;
+    }
+    runBench(count, k, rounds, "gaussian");
+    std::cout << std::endl;
+    runBench(count, k, rounds, "laplace");
+    return 0;
+}
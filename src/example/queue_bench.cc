@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/concurrency_queue.hh"
+#include "../common/mpmc_queue.hh"
+
+/**
+ * Hand-off latency and throughput of the queues between the pipeline stages.
+ *
+ * "locked" is how the stages used ConcurrencyQueue: the producer pushes and
+ * notifies under the mutex of the stage, the consumer waits on the condition
+ * variable of the stage for Size() > 0 and pops. "mpmc" is MpmcQueue with its
+ * blocking Push/Pop, "mpmc-bulk" pops with PopBulk like the BatchWorker.
+ *
+ * The saturated run pushes as fast as possible, the paced run pushes one item
+ * every interval, so the latency is the wakeup of an idle consumer.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+struct Item {
+    Clock::time_point pushed;
+    bool stop;
+};
+
+struct Result {
+    double items_per_sec;
+    double p50_us;
+    double p99_us;
+};
+
+class LockedQueue {
+public:
+    LockedQueue() : queue_(std::make_shared<ConcurrencyQueue<Item*>>()),
+                    mtx_(std::make_shared<std::mutex>()),
+                    cv_(std::make_shared<std::condition_variable>()) {}
+
+    void Push(Item* item) {
+        std::unique_lock<std::mutex> lock(*mtx_);
+        queue_->Push(item);
+        lock.unlock();
+        cv_->notify_all();
+    }
+
+    size_t Pop(std::vector<Item*>& items) {
+        std::unique_lock<std::mutex> lock(*mtx_);
+        cv_->wait(lock, [this] { return queue_->Size() > 0; });
+        items.push_back(queue_->Pop());
+        return 1;
+    }
+
+private:
+    std::shared_ptr<ConcurrencyQueue<Item*>> queue_;
+    std::shared_ptr<std::mutex> mtx_;
+    std::shared_ptr<std::condition_variable> cv_;
+};
+
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(bool bulk) : bulk_(bulk) {}
+
+    void Push(Item* item) {
+        queue_.Push(item);
+    }
+
+    size_t Pop(std::vector<Item*>& items) {
+        if (bulk_) {
+            return queue_.PopBulk(items, 64, std::chrono::microseconds(-1));
+        }
+        items.push_back(queue_.Pop());
+        return 1;
+    }
+
+private:
+    bool bulk_;
+    MpmcQueue<Item*> queue_;
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t idx = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+
+template <typename Queue>
+Result run(Queue& queue, int producers, int consumers, int items_per_producer, int interval_us) {
+    std::vector<std::vector<Item>> items(producers, std::vector<Item>(items_per_producer));
+    std::vector<Item> stops(consumers);
+    std::vector<std::vector<double>> latencies(consumers);
+    std::atomic<int> producers_done(0);
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            std::vector<Item*> popped;
+            latencies[c].reserve(size_t(items_per_producer) * producers / consumers + 64);
+            while (true) {
+                popped.clear();
+                queue.Pop(popped);
+                auto now = Clock::now();
+                Item* stop = nullptr;
+                for (auto item : popped) {
+                    if (item->stop) {
+                        // a bulk pop can take the stop of another consumer,
+                        // it is handed back
+                        if (stop != nullptr) {
+                            queue.Push(item);
+                        }
+                        stop = item;
+                        continue;
+                    }
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(now - item->pushed).count());
+                }
+                if (stop != nullptr) {
+                    break;
+                }
+            }
+        });
+    }
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            auto next = Clock::now();
+            for (auto& item : items[p]) {
+                if (interval_us > 0) {
+                    next += std::chrono::microseconds(interval_us);
+                    std::this_thread::sleep_until(next);
+                }
+                item.stop = false;
+                item.pushed = Clock::now();
+                queue.Push(&item);
+            }
+            if (producers_done.fetch_add(1) + 1 == producers) {
+                for (auto& stop : stops) {
+                    stop.stop = true;
+                    queue.Push(&stop);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto& latency : latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    Result result;
+    result.items_per_sec = double(producers) * items_per_producer / elapsed;
+    result.p50_us = percentile(all, 0.5);
+    result.p99_us = percentile(all, 0.99);
+    return result;
+}
+
+void runAll(int producers, int consumers, int items_per_producer, int interval_us) {
+    std::cout << producers << "x" << consumers
+              << (interval_us > 0 ? " paced " + std::to_string(interval_us) + "us" : " saturated") << std::endl;
+    std::cout << "queue\t\titems/s\t\tp50(us)\tp99(us)" << std::endl;
+    {
+        LockedQueue queue;
+        auto r = run(queue, producers, consumers, items_per_producer, interval_us);
+        std::cout << "locked\t\t" << r.items_per_sec << "\t" << r.p50_us << "\t" << r.p99_us << std::endl;
+    }
+    {
+        LockFreeQueue queue(false);
+        auto r = run(queue, producers, consumers, items_per_producer, interval_us);
+        std::cout << "mpmc\t\t" << r.items_per_sec << "\t" << r.p50_us << "\t" << r.p99_us << std::endl;
+    }
+    {
+        LockFreeQueue queue(true);
+        auto r = run(queue, producers, consumers, items_per_producer, interval_us);
+        std::cout << "mpmc-bulk\t" << r.items_per_sec << "\t" << r.p50_us << "\t" << r.p99_us << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void usage() {
+    std::cout << "Usage: ./queue_bench [items_per_producer] [interval_us]" << std::endl;
+    std::cout << "  runs 1x1, 4x1, 4x4 and 8x8 producers x consumers, saturated and paced" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 3) {
+        usage();
+        return 0;
+    }
+    int items = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int interval_us = argc > 2 ? std::stoi(argv[2]) : 50;
+    std::vector<std::pair<int, int>> shapes = {{1, 1}, {4, 1}, {4, 4}, {8, 8}};
+    for (auto& shape : shapes) {
+        runAll(shape.first, shape.second, items, 0);
+    }
+    for (auto& shape : shapes) {
+        runAll(shape.first, shape.second, std::max(items / 20, 1), interval_us);
+    }
+    return 0;
+}
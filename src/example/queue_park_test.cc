@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../common/mpmc_queue.hh"
+
+/**
+ * Checks MpmcQueue when both sides park at the same time.
+ *
+ * A capacity-2 queue, a consumer that parks in Pop on the empty queue and a
+ * producer that pushes more than fits, so it parks on the full queue while
+ * the consumer is still parked or just woke. Every round has to hand over
+ * all items in order within the deadline, a lost wakeup or a self-deadlock
+ * on the park mutex shows up as a timeout.
+ *
+ * The contended run puts several producers and consumers on the same
+ * capacity-2 queue, so a consumer often takes an item inside its parked
+ * loop while a producer is parked on the full queue.
+ */
+
+static const auto kDeadline = std::chrono::seconds(5);
+
+// waits for 'done', or exits the process as the threads are stuck on the queue
+static void waitOrFail(const std::atomic<bool>& done, const char* what) {
+    auto deadline = std::chrono::steady_clock::now() + kDeadline;
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!done) {
+        std::cout << "FAIL: " << what << " did not finish before the deadline" << std::endl;
+        std::_Exit(1);
+    }
+}
+
+static bool runRound(int items, std::chrono::milliseconds consumer_delay) {
+    MpmcQueue<int> queue(2);
+    std::vector<int> popped;
+    std::atomic<bool> done{false};
+
+    std::thread consumer([&]() {
+        for (int i = 0; i < items; i++) {
+            popped.push_back(queue.Pop());
+            if (i == 0) {
+                // lets the producer fill the queue and park on it
+                std::this_thread::sleep_for(consumer_delay);
+            }
+        }
+        done = true;
+    });
+    // lets the consumer park on the empty queue first
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::thread producer([&]() {
+        for (int i = 0; i < items; i++) {
+            queue.Push(i);
+        }
+    });
+
+    waitOrFail(done, "parked round");
+    producer.join();
+    consumer.join();
+    for (int i = 0; i < items; i++) {
+        if (popped[i] != i) {
+            std::cout << "FAIL: item " << i << " came out as " << popped[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool runContended(int threads, int items) {
+    MpmcQueue<int> queue(2);
+    std::atomic<long long> sum{0};
+    std::atomic<int> finished{0};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> workers;
+    for (int c = 0; c < threads; c++) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < items; i++) {
+                sum += queue.Pop();
+            }
+            if (++finished == threads) {
+                done = true;
+            }
+        });
+    }
+    for (int p = 0; p < threads; p++) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < items; i++) {
+                queue.Push(i);
+            }
+        });
+    }
+    waitOrFail(done, "contended run");
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    long long expected = static_cast<long long>(threads) * items * (items - 1) / 2;
+    if (sum != expected) {
+        std::cout << "FAIL: contended sum " << sum << ", expected " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 200;
+    for (int r = 0; r < rounds; r++) {
+        // 3 items is one more than fits, the longer runs park the producer
+        // again on every lap
+        int items = r % 2 == 0 ? 3 : 1000;
+        auto delay = std::chrono::milliseconds(r % 4 < 2 ? 10 : 0);
+        if (!runRound(items, delay)) {
+            return 1;
+        }
+    }
+    if (!runContended(4, 20000)) {
+        return 1;
+    }
+    std::cout << "OK: " << rounds << " rounds and the contended run" << std::endl;
+    return 0;
+}
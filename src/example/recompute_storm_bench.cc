@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * A storm of recomputes against the batching of one model, before and after
+ * the recompute lane.
+ *
+ * The backend is replayed event by event rather than run, so the numbers
+ * hold without a GPU and without triton. Triton is modeled as
+ * mock_triton_server does it, 'instances' batches at a time, a batch of n
+ * taking base_ms + n * per_sample_ms. Backup and CDC queries arrive at a
+ * steady rate, alternating, and are batched by batch_size with no queue
+ * delay, as in conf/config.json. At storm_at_ms all the recomputes arrive
+ * at once.
+ *
+ *   old: a recompute goes to the backup queue, and is sent as a batch of
+ *        one when it reaches the front; the scheduler serves the batches
+ *        first in, first out
+ *   lane: the recomputes have their own batcher, a batch is sent when it
+ *        holds recompute_batch_size queries or its oldest one waited
+ *        recompute_delay_ms; the scheduler serves them first
+ *
+ * It prints the recompute latency, the triton calls and the average batch
+ * size the recomputes took, when the last one was answered, and the latency
+ * of the normal queries meanwhile.
+ *
+ * usage: recompute_storm_bench [recomputes] [normal queries per ms]
+ *                              [recompute batch size] [instances]
+ */
+
+const double kInf = std::numeric_limits<double>::infinity();
+
+struct Params {
+    int recomputes = 256;
+    double rate_per_ms = 0.4;
+    int batch_size = 2;
+    int recompute_batch_size = 64;
+    double recompute_delay_ms = 1;
+    int instances = 1;
+    double base_ms = 2;
+    double per_sample_ms = 0.5;
+    double storm_at_ms = 100;
+    double end_ms = 4000;
+};
+
+struct SimQuery {
+    double arrival_;
+    bool recompute_;
+};
+
+struct SimBatch {
+    std::vector<SimQuery> queries_;
+    bool recompute_;
+};
+
+struct Stats {
+    std::vector<double> recompute_ms;
+    std::vector<double> normal_ms;
+    int recompute_batches = 0;
+    int recompute_calls_queries = 0;
+    double last_recompute_done = 0;
+};
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+class Backend {
+public:
+    Backend(const Params& params, bool lane) : params_(params), lane_(lane),
+                                               busy_until_(params.instances, 0) {}
+
+    void Arrive(const SimQuery& query, bool backup, double now) {
+        if (query.recompute_ && lane_) {
+            recompute_.push_back(query);
+        } else if (query.recompute_ || backup) {
+            backup_.push_back(query);
+        } else {
+            cdc_.push_back(query);
+        }
+        dispatch(now);
+    }
+
+    // the next time the backend acts without an arrival
+    double NextEvent() const {
+        double next = kInf;
+        if (!recompute_.empty()) {
+            next = recompute_.front().arrival_ + params_.recompute_delay_ms;
+        }
+        if (!queue_.empty()) {
+            next = std::min(next, *std::min_element(busy_until_.begin(), busy_until_.end()));
+        }
+        return next;
+    }
+
+    void Advance(double now) {
+        dispatch(now);
+        serve(now);
+    }
+
+    Stats stats_;
+
+private:
+    void dispatch(double now) {
+        // the backup batcher of the old path sends a recompute at its front
+        // alone
+        while (!backup_.empty()) {
+            if (backup_.front().recompute_) {
+                push({{backup_.front()}, true});
+                backup_.pop_front();
+            } else if (int(backup_.size()) >= params_.batch_size) {
+                take(backup_, params_.batch_size, false);
+            } else {
+                break;
+            }
+        }
+        while (int(cdc_.size()) >= params_.batch_size) {
+            take(cdc_, params_.batch_size, false);
+        }
+        while (!recompute_.empty()) {
+            if (int(recompute_.size()) >= params_.recompute_batch_size) {
+                take(recompute_, params_.recompute_batch_size, true);
+            } else if (now >= recompute_.front().arrival_ + params_.recompute_delay_ms) {
+                take(recompute_, recompute_.size(), true);
+            } else {
+                break;
+            }
+        }
+        serve(now);
+    }
+
+    void take(std::deque<SimQuery>& pending, size_t n, bool recompute) {
+        SimBatch batch{{pending.begin(), pending.begin() + n}, recompute};
+        pending.erase(pending.begin(), pending.begin() + n);
+        push(batch);
+    }
+
+    void push(const SimBatch& batch) {
+        if (lane_ && batch.recompute_) {
+            // recompute first, in order among themselves
+            auto it = std::find_if(queue_.begin(), queue_.end(), [](const SimBatch& b) { return !b.recompute_; });
+            queue_.insert(it, batch);
+        } else {
+            queue_.push_back(batch);
+        }
+    }
+
+    void serve(double now) {
+        for (auto& busy_until : busy_until_) {
+            if (queue_.empty()) {
+                return;
+            }
+            if (busy_until > now) {
+                continue;
+            }
+            SimBatch batch = queue_.front();
+            queue_.pop_front();
+            busy_until = now + params_.base_ms + params_.per_sample_ms * batch.queries_.size();
+            int recomputes = 0;
+            for (const auto& query : batch.queries_) {
+                if (query.recompute_) {
+                    stats_.recompute_ms.push_back(busy_until - query.arrival_);
+                    stats_.last_recompute_done = std::max(stats_.last_recompute_done, busy_until);
+                    recomputes++;
+                } else if (query.arrival_ >= params_.storm_at_ms) {
+                    stats_.normal_ms.push_back(busy_until - query.arrival_);
+                }
+            }
+            if (recomputes > 0) {
+                stats_.recompute_batches++;
+                stats_.recompute_calls_queries += recomputes;
+            }
+        }
+    }
+
+    const Params& params_;
+    bool lane_;
+    std::deque<SimQuery> backup_;
+    std::deque<SimQuery> cdc_;
+    std::deque<SimQuery> recompute_;
+    std::deque<SimBatch> queue_;
+    std::vector<double> busy_until_;
+};
+
+Stats Replay(const Params& params, bool lane) {
+    Backend backend(params, lane);
+    double interval = 1.0 / params.rate_per_ms;
+    double next_normal = 0;
+    int normal_num = 0;
+    bool storm_sent = false;
+    double now = 0;
+    while (now < params.end_ms) {
+        double next_storm = storm_sent ? kInf : params.storm_at_ms;
+        double next = std::min({next_normal, next_storm, backend.NextEvent()});
+        if (next == kInf || next > params.end_ms) {
+            break;
+        }
+        now = next;
+        if (now == next_storm) {
+            for (int i = 0; i < params.recomputes; i++) {
+                backend.Arrive(SimQuery{now, true}, true, now);
+            }
+            storm_sent = true;
+        }
+        if (now == next_normal) {
+            backend.Arrive(SimQuery{now, false}, normal_num % 2 == 0, now);
+            normal_num++;
+            next_normal = normal_num * interval;
+        }
+        backend.Advance(now);
+    }
+    return backend.stats_;
+}
+
+void Print(const std::string& name, const Params& params, const Stats& s) {
+    std::cout << name << "\t" << s.recompute_ms.size() << "/" << params.recomputes
+              << "\t" << percentile(s.recompute_ms, 0.5)
+              << "\t" << percentile(s.recompute_ms, 0.99)
+              << "\t" << s.recompute_batches
+              << "\t" << (s.recompute_batches > 0 ? double(s.recompute_calls_queries) / s.recompute_batches : 0)
+              << "\t\t" << s.last_recompute_done - params.storm_at_ms
+              << "\t\t" << percentile(s.normal_ms, 0.5)
+              << "\t" << percentile(s.normal_ms, 0.99) << std::endl;
+}
+
+void usage() {
+    std::cout << "Usage: ./recompute_storm_bench [recomputes] [normal queries per ms] "
+                 "[recompute batch size] [instances]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 5) {
+        usage();
+        return 0;
+    }
+    Params params;
+    if (argc > 1) params.recomputes = std::stoi(argv[1]);
+    if (argc > 2) params.rate_per_ms = std::stod(argv[2]);
+    if (argc > 3) params.recompute_batch_size = std::max(std::stoi(argv[3]), 1);
+    if (argc > 4) params.instances = std::max(std::stoi(argv[4]), 1);
+
+    std::cout << params.recomputes << " recomputes at " << params.storm_at_ms << " ms, "
+              << params.rate_per_ms << " normal queries/ms in batches of " << params.batch_size
+              << ", triton " << params.instances << " instance(s), " << params.base_ms << " + n * "
+              << params.per_sample_ms << " ms per batch" << std::endl;
+    std::cout << "path\tdone\tp50(ms)\tp99(ms)\tcalls\tavg batch\tstorm cleared(ms)\tnormal p50\tp99" << std::endl;
+    Print("old", params, Replay(params, false));
+    Print("lane", params, Replay(params, true));
+    return 0;
+}
@@ -16,6 +16,37 @@ tbb::concurrent_unordered_map<uint64_t, uint32_t>  Worker::backups; //[encode_id
 
 tbb::concurrent_unordered_map<uint64_t, bool>  Worker::is_stripes_completed; //[encode_id, is_completed]
 
+std::vector<uint8_t> Worker::replyFeature(const SingleQuery* query) const {
+    // a RETAIN, rejected or failed reply carries no feature map
+    if (query->reply_info_bytes.size() < featureWireSize()) {
+        LOG_ERROR("reply of query %d has %ld bytes, no feature map of %ld bytes in it",
+                  query->id_, query->reply_info_bytes.size(), featureWireSize());
+        return std::vector<uint8_t>();
+    }
+    size_t fp32_size = DATASETS.at(conf_->model_name).first;
+    std::vector<uint8_t> feature(fp32_size);
+    DequantizeFeature(query->reply_info_bytes.data(), fp32_size / sizeof(float), feature_precision_,
+                      reinterpret_cast<float*>(feature.data()));
+    return feature;
+}
+
+bool Worker::preprocessImage(SingleQuery* query) const {
+    cv::Mat img = imdecode(cv::Mat(query->data_), -1);
+    if (img.empty()) {
+        return false;
+    }
+    int type1, type3;
+    std::vector<uint8_t> input_data;
+    Preprocessor preprocessor;
+    ScaleType scale = preprocessor.ParseScale(query->scale_);
+    preprocessor.ParseType(conf_->dtype, &type1, &type3);
+    preprocessor.Preprocess(img, conf_->format, type1, type3, conf_->channels,
+                            cv::Size(conf_->width, conf_->height), scale, &input_data);
+    query->data_.swap(input_data);
+    query->compressed_ = false;
+    return true;
+}
+
 std::mutex replyMtx;
 std::condition_variable replyCV;
 
@@ -52,13 +83,9 @@ std::vector<std::vector<uint8_t>> generateRandom2DVector(int row, int col) {
  */
 PreprocessWorker::PreprocessWorker(std::shared_ptr<Config> conf_,
                         std::shared_ptr<QueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
                         std::shared_ptr<QueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2,
                         std::shared_ptr<Monitor> monitor):
-                        Worker(conf_, queue_1, mtx_1, cv_1, queue_2, mtx_2, cv_2, monitor)
+                        Worker(conf_, queue_1, queue_2, monitor)
 {
     format = conf_ -> format;
     dtype = conf_ -> dtype;
@@ -77,55 +104,42 @@ void PreprocessWorker::init(){
 };
 
 void PreprocessWorker::run() {
-    int type1, type3;
     while(true) {
-        std::unique_lock<std::mutex> lock(*mtx_1_);
         // LOG_INFO("PreprocessWorker waiting...");
-        cv_1_->wait(lock, [this] { return queue_1_->Size() > 0; });
+        auto popped = queue_1_->Pop();
         auto start = std::chrono::high_resolution_clock::now();
         // pop query from recv queue
         // preprocess 
-        auto query = dynamic_cast<SingleQuery*>(queue_1_->Pop());
+        auto query = dynamic_cast<SingleQuery*>(popped);
 
         // judge whether is the end signal
         if(query->end_signal_) {
-            std::unique_lock<std::mutex> pp_lock(*mtx_2_);
             queue_2_->Push(query);
             LOG_INFO("push end signal to preprocessed queue");
-            cv_2_->notify_all();
             continue;
         }
 
         int id = query->id_;
         std::string filename = query->filename_;
-        std::vector<uint8_t> data = query->data_;
         LOG_INFO("pop query: %d from recv queue", id);
         
-        cv::Mat img = imdecode(cv::Mat(data), -1);
-        if (img.empty()) {
+        if (conf_->compressed_backup) {
+            // the backups are preprocessed by the backend, the EncodeWorker
+            // preprocesses the queries it encodes
+            query->compressed_ = true;
+        }
+        else if (!preprocessImage(query)) {
             LOG_ERROR("error: unable to decode image %s",filename.c_str());
             exit(1);
         }
-
-        std::vector<uint8_t> input_data;
-
-        Preprocessor preprocessor;
-        ScaleType scale = preprocessor.ParseScale(query->scale_);
-        preprocessor.ParseType(dtype,&type1,&type3);
-        preprocessor.Preprocess(img, format, type1, type3, channels, cv::Size(width,height), scale, &input_data);
-        query->data_.assign(input_data.begin(),input_data.end());
         
         // push pp query into pp queue
-        {
-            std::unique_lock<std::mutex> pp_lock(*mtx_2_);
-            queue_2_->Push(query);
-            LOG_INFO("push query: %d to preprocessed queue", id);
-        }
+        queue_2_->Push(query);
+        LOG_INFO("push query: %d to preprocessed queue", id);
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
                             (end_time - start).count();
         std::cout << "Preproccessor Worker time: " << duration_time << std::endl;
-        cv_2_->notify_all();
     }
 }
 
@@ -135,14 +149,10 @@ void PreprocessWorker::run() {
  */
 EncodeWorker::EncodeWorker(std::shared_ptr<Config> conf_,
                         std::shared_ptr<QueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
                         std::shared_ptr<QueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2,
                         std::shared_ptr<Monitor> monitor,
                         std::shared_ptr<Filter> filter):
-                        Worker(conf_, queue_1, mtx_1, cv_1, queue_2, mtx_2, cv_2,monitor)
+                        Worker(conf_, queue_1, queue_2, monitor)
 {
     encode_thread_ = std::thread(&EncodeWorker::run, this);
     backup_num_ = conf_ -> backup_num;
@@ -178,14 +188,11 @@ void EncodeWorker::run() {
     // std::vector<std::vector<uint8_t>> data;
     std::vector<SingleQuery*> querys{};
     while(true) {
-        {
-            std::unique_lock<std::mutex> lock(*mtx_1_);
-            LOG_INFO("EncodeWorker waiting...");
-            cv_1_->wait(lock, [this] { return queue_1_->Size() > 0;});
-        }
+        LOG_INFO("EncodeWorker waiting...");
+        auto popped = queue_1_->Pop();
         auto start = std::chrono::high_resolution_clock::now();
 
-        auto pp_query = dynamic_cast<SingleQuery*>(queue_1_->Pop());
+        auto pp_query = dynamic_cast<SingleQuery*>(popped);
         if(pp_query->end_signal_) { 
 
             for(auto& query_backup: querys) {
@@ -197,7 +204,6 @@ void EncodeWorker::run() {
                     query_backup->encode_id_ = encode_id2;
                     query_backup->encode_type_ = "Backup";
                     backups[encode_id2] = query_backup->id_;
-                    std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                     queue_2_->Push(query_backup);
                     LOG_INFO("push query: %d to encode queue, encode id: %d", query_backup->id_, encode_id2);
                 }
@@ -206,20 +212,15 @@ void EncodeWorker::run() {
                     auto query = new SingleQuery(request_info);
                     query -> id_ = data_id++;
                     query -> filename_ = "backup_" + std::to_string(i) + "_" + std::to_string(encode_id2);
-                    std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                     queue_2_->Push(query);
                     LOG_INFO("push query: %d to encode queue, encode id: %d", query->id_, encode_id2);
-                    encode_lock.unlock();
                 }
                 encode_id2++;
             }
             std::vector<SingleQuery*>().swap(querys);
 
-            std::unique_lock<std::mutex> encode_lock(*mtx_2_);
             queue_2_->Push(pp_query);
             LOG_INFO("push push end signal encode queue");
-            encode_lock.unlock();  
-            cv_2_->notify_all(); 
             continue;
         }
 
@@ -231,6 +232,10 @@ void EncodeWorker::run() {
         filter_->filterWorker(encodeType);
         // CDC 
         if(encodeType == EncodeType::CDC && !pp_query->is_recompute_) {
+            if (pp_query->compressed_ && !preprocessImage(pp_query)) {
+                LOG_ERROR("error: unable to decode image %s", pp_query->filename_.c_str());
+                exit(1);
+            }
             querys.emplace_back(pp_query);
             // {
             //     pp_query->encode_id_ = encode_id1;
@@ -245,12 +250,10 @@ void EncodeWorker::run() {
                 std::vector<std::vector<uint8_t>> data{};
                 for(auto& query: querys) {
                     data.emplace_back(query->data_);
-                    std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                     query->encode_id_ = encode_id1;
                     query->encode_type_ = "CDC";
                     queue_2_->Push(query);
                     LOG_INFO("push query: %d to encode queue, CDC encode id: %d", query->id_, encode_id1);
-                    encode_lock.unlock(); 
                     stripes[encode_id1].insert(query->id_);
                 }
                 
@@ -260,10 +263,8 @@ void EncodeWorker::run() {
                 query->filename_ = "encode_"+ std::to_string(encode_id1);
                 LOG_INFO("Generate query: %d, data size: %ld", query->id_, query->data_.size());
 
-                std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                 queue_2_->Push(query);
                 LOG_INFO("push query: %d to encode queue, CDC encode id: %d", query->id_, encode_id1);
-                encode_lock.unlock();
                 stripes[encode_id1].insert(query->id_);  
 
                 is_stripes_completed[encode_id1] = false;
@@ -282,7 +283,6 @@ void EncodeWorker::run() {
             {
                 pp_query->encode_id_ = encode_id2;
                 pp_query->encode_type_ = "Backup";
-                std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                 backups[encode_id2] = pp_query->id_;
                 queue_2_->Push(pp_query);
                 LOG_INFO("push query: %d to encode queue, encode id: %d", pp_query->id_, encode_id2);
@@ -295,10 +295,8 @@ void EncodeWorker::run() {
                 auto query = new SingleQuery(request_info);
                 query -> id_ = data_id++;
                 query -> filename_ = "backup_" + std::to_string(i) + "_" + std::to_string(encode_id2);
-                std::unique_lock<std::mutex> encode_lock(*mtx_2_);
                 queue_2_->Push(query);
                 LOG_INFO("push query: %d to encode queue, encode id: %d", query->id_, encode_id2);
-                encode_lock.unlock();
             }
             // std::vector<std::vector<uint8_t>>().swap(data);
             encode_id2++;    
@@ -307,8 +305,6 @@ void EncodeWorker::run() {
         auto duration_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
                             (end_time - start).count();
         std::cout << "Encoder Worker time: " << duration_time << std::endl;
-        
-        cv_2_->notify_all(); 
     }
 }
 
@@ -329,6 +325,7 @@ ImageClassifyArgs EncodeWorker::createRequestInfo(const SingleQuery& query,
     request_info.is_parity_data_ = is_parity_data;
     request_info.end_signal_ = is_end_signal;
     request_info.is_recompute_ = is_recompute;
+    request_info.compressed_ = query.compressed_;
     return request_info;
 }
 
@@ -338,23 +335,15 @@ ImageClassifyArgs EncodeWorker::createRequestInfo(const SingleQuery& query,
  */
 InferWorker::InferWorker(std::shared_ptr<Config> conf_,
                         std::shared_ptr<QueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
                         std::shared_ptr<QueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2,
                         std::shared_ptr<QueryQueue> queue_3,
-                        std::shared_ptr<std::mutex> mtx_3,
-                        std::shared_ptr<std::condition_variable> cv_3,
                         std::shared_ptr<Monitor> monitor,
                         std::uint32_t frontend_id):
-                        Worker(conf_, queue_1, mtx_1, cv_1, queue_2, mtx_2, cv_2, monitor)
+                        Worker(conf_, queue_1, queue_2, monitor)
 {
     node_number_ = conf_ -> node_number;
     frontend_id_ = frontend_id;
     queue_3_ = queue_3;
-    mtx_3_ = mtx_3;
-    cv_3_ = cv_3;
 
     mtx_map_ = std::make_shared<std::mutex>();
     mtx_start_time_map_ = std::make_shared<std::mutex>();
@@ -410,15 +399,12 @@ void InferWorker::run() {
     std::unordered_map<std::uint32_t, std::shared_ptr<std::mutex>> chosenRegionMutex;
 
     while(true) {
-        {
-            std::unique_lock<std::mutex> lock(*mtx_1_);
-            LOG_INFO("InferWorker waiting...");
-            cv_1_->wait(lock, [this] { return queue_1_->Size() > 0; });
-        }
+        LOG_INFO("InferWorker waiting...");
+        auto popped = queue_1_->Pop();
 
         auto start = std::chrono::high_resolution_clock::now();
     
-        auto encode_query = dynamic_cast<SingleQuery*>(queue_1_->Pop());
+        auto encode_query = dynamic_cast<SingleQuery*>(popped);
         if(encode_query->end_signal_) {
             for(const auto& stream: streams){
                 ElasticcdcRequest request;
@@ -602,6 +588,21 @@ void InferWorker::run() {
         request.set_frontend_id(frontend_id_);
         request.set_end_signal(false);
         request.set_recompute(encode_query->is_recompute_);
+        request.set_compressed(encode_query->compressed_);
+        if (topkReply(encode_query)) {
+            request.set_output_mode(ElasticcdcRequest::TOPK);
+            request.set_top_k(conf_->backup_top_k);
+        } else if (retainReply(encode_query)) {
+            request.set_output_mode(ElasticcdcRequest::RETAIN);
+        }
+        if (conf_->query_deadline_ms > 0) {
+            // the time left rather than a time point, the backend clock may
+            // differ from ours. A recompute arrives overdue and goes first
+            // under the edf scheduler
+            double elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>
+                             (std::chrono::steady_clock::now() - encode_query->created_).count();
+            request.set_deadline_ms(conf_->query_deadline_ms - elapsed);
+        }
         // std::cout << "encode_query->encode_type_:" << encode_query->encode_type_ << std::endl;
         {
             std::unique_lock<std::mutex> lock(*mtx_);
@@ -616,6 +617,7 @@ void InferWorker::run() {
         
         // assert(streams[node_index] != nullptr);
         // streams[node_index]->Write(request);
+        encode_query->backend_ip_ = backendIP;
         querys_map_[encode_query->id_] = encode_query;
         querys_start_time_map_[encode_query->id_] = std::chrono::high_resolution_clock::now();
         assert(streams[backendIP] != nullptr);
@@ -679,6 +681,13 @@ void InferWorker::ReceiveResponses(std::shared_ptr<grpcStreamClient> stream, std
         //     auto ava_backend_ips = monitor_->get_ava_backendIPs();
         //     is_preempted = std::find(ava_backend_ips.begin(), ava_backend_ips.end(), backend_ip) == ava_backend_ips.end();
         // }
+        if (reply.rejected()) {
+            // the backend drains before its preemption, the query is lost
+            // as on a preemption but known now rather than at the next update
+            LOG_INFO("Query %d rejected by draining backend %s", id, backend_ip.c_str());
+            monitor_->BackendDraining(backend_ip);
+            monitor_->RejectAQuery(backend_ip, id);
+        }
         bool is_preempted = monitor_->IsQueryBroken(backend_ip, id);
         monitor_->DeleteAQueryState(backend_ip, id);
         
@@ -692,13 +701,10 @@ void InferWorker::ReceiveResponses(std::shared_ptr<grpcStreamClient> stream, std
                 && encode_fail_num[recv_query->encode_id_].first > 1) {
                 for(auto& recalc_query : querys_encode_map_[recv_query->encode_id_]) {
                     if(recalc_query->is_parity_data_) continue;
-                    std::unique_lock<std::mutex> recv_lock(*mtx_3_);
                     recalc_query->is_recompute_ = true;
                     queue_3_->Push(recalc_query);
                     LOG_INFO("CDC query %d recompute!", recalc_query->id_);
                     LOG_INFO("push query: %d to recv queue", recalc_query->id_);
-                    recv_lock.unlock();  
-                    cv_3_->notify_all();
                 }
                 
                 {
@@ -718,13 +724,10 @@ void InferWorker::ReceiveResponses(std::shared_ptr<grpcStreamClient> stream, std
 
             if(backup_fail_num[recv_query->encode_id_] == 1 + conf_->backup_num) {
                 auto recalc_query = querys_backup_map_[recv_query->encode_id_][0];
-                std::unique_lock<std::mutex> recv_lock(*mtx_3_);
                 recalc_query->is_recompute_ = true;
                 queue_3_->Push(recalc_query);
                 LOG_INFO("Backup recompute!");
                 LOG_INFO("push query: %d to recv queue", recalc_query->id_);
-                recv_lock.unlock();  
-                cv_3_->notify_all();
                 {
                     std::lock_guard<std::mutex> lock(*mtx_backup_fail_num_);
                     backup_fail_num.unsafe_erase(recv_query->encode_id_);
@@ -881,8 +884,8 @@ void InferWorker::SendToClient(SingleQuery* recv_query) {
         if(!recv_query->is_parity_data_) {
             ElasticcdcReply reply;
             std::vector<std::string> reply_data_vec;
-            if (conf_->model_name.find("irevnet") != std::string::npos) {
-                std::string reply_data(recv_query->reply_info_bytes.begin() + DATASETS.at(model_name_).first,
+            if (conf_->model_name.find("irevnet") != std::string::npos && !retainReply(recv_query)) {
+                std::string reply_data(recv_query->reply_info_bytes.begin() + featureWireSize(),
                                     recv_query->reply_info_bytes.end());
                 reply_data_vec.push_back(reply_data);
             }
@@ -907,11 +910,8 @@ void InferWorker::SendToClient(SingleQuery* recv_query) {
                 }
             }
         } 
-        std::unique_lock<std::mutex> infer_lock(*mtx_2_);
         queue_2_->Push(recv_query);
         LOG_INFO("push query: %d to infered queue", recv_query->id_);
-        infer_lock.unlock(); 
-        cv_2_->notify_all(); 
           
     } else if (recv_query -> encode_type_ == "Backup") {
         {
@@ -924,8 +924,8 @@ void InferWorker::SendToClient(SingleQuery* recv_query) {
         std::cout << "backup_id:" << backup_id << std::endl;
         ElasticcdcReply reply;
         std::vector<std::string> reply_data_vec;
-        if (conf_->model_name.find("irevnet") != std::string::npos) {
-            std::string reply_data(recv_query->reply_info_bytes.begin() + DATASETS.at(model_name_).first,
+        if (conf_->model_name.find("irevnet") != std::string::npos && !topkReply(recv_query)) {
+            std::string reply_data(recv_query->reply_info_bytes.begin() + featureWireSize(),
                                 recv_query->reply_info_bytes.end());
             reply_data_vec.push_back(reply_data);
         }
@@ -961,17 +961,15 @@ void InferWorker::SendToClient(SingleQuery* recv_query) {
  */
 DecodeWorker::DecodeWorker(std::shared_ptr<Config> conf_,
                         std::shared_ptr<QueryQueue> queue_1,
-                        std::shared_ptr<std::mutex> mtx_1,
-                        std::shared_ptr<std::condition_variable> cv_1,
                         std::shared_ptr<QueryQueue> queue_2,
-                        std::shared_ptr<std::mutex> mtx_2,
-                        std::shared_ptr<std::condition_variable> cv_2,
                         std::shared_ptr<Monitor> monitor,
-                        std::shared_ptr<Filter> filter):
-                        Worker(conf_, queue_1, mtx_1, cv_1, queue_2, mtx_2, cv_2, monitor)
+                        std::shared_ptr<Filter> filter,
+                        std::uint32_t frontend_id):
+                        Worker(conf_, queue_1, queue_2, monitor)
 {
     k_ = conf_ -> k;
     filter_ = filter;
+    frontend_id_ = frontend_id;
 
     // std::stringstream ss(conf_->model_name);
     // std::getline(ss, model_name_, '-');
@@ -1034,6 +1032,67 @@ DecodeWorker::~DecodeWorker() {
 void DecodeWorker::init() {
 
 }
+
+bool DecodeWorker::fetchRetainedFeatures(const std::vector<Query*>& querys,
+                                         std::vector<std::vector<uint8_t>>& data) {
+    // one call per backend for the members of the stripe it answered
+    std::unordered_map<std::string, std::unordered_map<int64_t, size_t>> backend_querys;  //[backend_ip, [id, index]]
+    for (size_t i = 0; i < querys.size(); i++) {
+        auto query = dynamic_cast<SingleQuery*>(querys[i]);
+        if (retainReply(query)) {
+            backend_querys[query->backend_ip_][query->id_] = i;
+        }
+    }
+    for (auto& backend : backend_querys) {
+        auto stub_it = feature_stubs_.find(backend.first);
+        if (stub_it == feature_stubs_.end()) {
+            std::shared_ptr<Channel> channel = grpc::CreateChannel(
+                backend.first + ":" + "50051", grpc::InsecureChannelCredentials());
+            stub_it = feature_stubs_.emplace(backend.first, ElasticcdcService::NewStub(channel)).first;
+        }
+        ElasticcdcRequest request;
+        request.set_frontend_id(frontend_id_);
+        for (const auto& id : backend.second) {
+            request.add_feature_ids(id.first);
+        }
+        ElasticcdcReply reply;
+        ClientContext context;
+        // the backend may have been preempted since it replied
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(1));
+        auto start = std::chrono::high_resolution_clock::now();
+        Status status = stub_it->second->FetchFeatures(&context, request, &reply);
+        if (!status.ok()) {
+            LOG_ERROR("fetch features from backend %s failed: %s", backend.first.c_str(), status.error_message().c_str());
+            return false;
+        }
+        for (const auto& feature : reply.features()) {
+            auto index = backend.second.find(feature.id());
+            if (index == backend.second.end() || feature.data().size() != featureWireSize()) {
+                continue;
+            }
+            auto query = dynamic_cast<SingleQuery*>(querys[index->second]);
+            query->reply_info_bytes.assign(feature.data().begin(), feature.data().end());
+            data[index->second] = replyFeature(query);
+            backend.second.erase(index);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        LOG_INFO("fetch %d features from backend %s in %lf ms", reply.features_size(), backend.first.c_str(),
+                 std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count());
+        if (!backend.second.empty()) {
+            // expired or dropped by the backend, see retained_feature_ttl_ms
+            LOG_ERROR("%ld features are no longer kept by backend %s, the stripe is not decoded",
+                      backend.second.size(), backend.first.c_str());
+            return false;
+        }
+    }
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i].empty()) {
+            LOG_ERROR("no feature for query %d, the stripe is not decoded", querys[i]->id_);
+            return false;
+        }
+    }
+    return true;
+}
 void DecodeWorker::run() {
     // int dncode_id1 = 0, dncode_id2 = 0;
     std::unordered_map<int, std::vector<Query*> > querys_id1;   //[decode_id, Querys]
@@ -1048,14 +1107,11 @@ void DecodeWorker::run() {
     decoder_->decode(data, res);
     
     while(true) {
-        {
-            std::unique_lock<std::mutex> lock(*mtx_1_);
-            LOG_INFO("DecodeWorker waiting...");
-            cv_1_->wait(lock, [this] { return queue_1_->Size() > 0; });
-        }
+        LOG_INFO("DecodeWorker waiting...");
+        auto popped = queue_1_->Pop();
 
         auto start = std::chrono::high_resolution_clock::now();
-        auto infer_query = dynamic_cast<SingleQuery*>(queue_1_->Pop());
+        auto infer_query = dynamic_cast<SingleQuery*>(popped);
         LOG_INFO("pop query: %d from infer queue, decode id: %d, decode type %s",
                      infer_query->id_, infer_query->encode_id_, infer_query->encode_type_.c_str());
 
@@ -1176,8 +1232,7 @@ void DecodeWorker::handleCDCQuery(std::unordered_map<int, std::vector<Query*>>&
                 SingleQuery* singleQuery = dynamic_cast<SingleQuery*>(next_query);
                 stripe_ids.erase(singleQuery->id_);
                 if (conf_->model_name.find("irevnet") != std::string::npos)
-                    data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
-                                                         singleQuery->reply_info_bytes.begin() + DATASETS.at(model_name_).first));
+                    data.emplace_back(retainReply(singleQuery) ? std::vector<uint8_t>() : replyFeature(singleQuery));
                 else 
                     data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
                                                          singleQuery->reply_info_bytes.end()));
@@ -1201,7 +1256,7 @@ void DecodeWorker::handleCDCQuery(std::unordered_map<int, std::vector<Query*>>&
 
                 }
             }
-            if (is_need_decode && stream) {
+            if (is_need_decode && stream && fetchRetainedFeatures(querys_it->second, data)) {
                 assert(stripe_ids.size() == 1);
                 auto id = *stripe_ids.cbegin();
                 std::cout << "broken id: " << id << std::endl;
@@ -1332,8 +1387,7 @@ void DecodeWorker::handleCDCQueryFlagAlgBaseline(std::unordered_map<int, std::ve
                 SingleQuery* singleQuery = dynamic_cast<SingleQuery*>(next_query);
                 stripe_ids.erase(singleQuery->id_);
                 if (conf_->model_name.find("irevnet") != std::string::npos)
-                    data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
-                                                         singleQuery->reply_info_bytes.begin() + DATASETS.at(model_name_).first));
+                    data.emplace_back(retainReply(singleQuery) ? std::vector<uint8_t>() : replyFeature(singleQuery));
                 else
                     data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
                                                          singleQuery->reply_info_bytes.end()));
@@ -1357,7 +1411,7 @@ void DecodeWorker::handleCDCQueryFlagAlgBaseline(std::unordered_map<int, std::ve
 
                 }
             }
-            if (is_need_decode && stream) {
+            if (is_need_decode && stream && fetchRetainedFeatures(querys_it->second, data)) {
                 assert(stripe_ids.size() == 1);
                 auto id = *stripe_ids.cbegin();
                 std::cout << "broken id: " << id << std::endl;
@@ -1487,8 +1541,7 @@ void DecodeWorker::handleCDCQueryBaseline(std::unordered_map<int, std::vector<Qu
                 SingleQuery* singleQuery = dynamic_cast<SingleQuery*>(next_query);
                 stripe_ids.erase(singleQuery->id_);
                 if (conf_->model_name.find("irevnet") != std::string::npos)
-                    data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
-                                                        singleQuery->reply_info_bytes.begin() + DATASETS.at(model_name_).first));
+                    data.emplace_back(retainReply(singleQuery) ? std::vector<uint8_t>() : replyFeature(singleQuery));
                 else
                     data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
                                                         singleQuery->reply_info_bytes.end()));
@@ -1512,45 +1565,49 @@ void DecodeWorker::handleCDCQueryBaseline(std::unordered_map<int, std::vector<Qu
                 infer_time = singleQuery -> infer_time;
             }
 
-            std::vector<uint8_t> reply_info;
-            auto start11 = std::chrono::high_resolution_clock::now();
-            std::cout << "decoder performed ~" << std::endl;
-            decoder_->decode(data, reply_info);
-            auto end11 = std::chrono::high_resolution_clock::now();
+            // the retained features are fetched first, a stripe with a
+            // feature missing is not decoded
+            if (fetchRetainedFeatures(querys_it->second, data)) {
+                std::vector<uint8_t> reply_info;
+                auto start11 = std::chrono::high_resolution_clock::now();
+                std::cout << "decoder performed ~" << std::endl;
+                decoder_->decode(data, reply_info);
+                auto end11 = std::chrono::high_resolution_clock::now();
 
-            auto duration11 = std::chrono::duration_cast<std::chrono::milliseconds>(end11 - start11).count();
+                auto duration11 = std::chrono::duration_cast<std::chrono::milliseconds>(end11 - start11).count();
 
-            LOG_INFO("decode time: %ld ms", duration11);
+                LOG_INFO("decode time: %ld ms", duration11);
 
-            // update infer_time and decode_time
-            auto end = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - decode_start_time[decode_id]).count();
+                // update infer_time and decode_time
+                auto end = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - decode_start_time[decode_id]).count();
 
-            auto end1 = std::chrono::steady_clock::now();
-            auto duration1 = std::chrono::duration_cast<std::chrono::milliseconds>(end1 - decode_start_time1[decode_id]);
-            {
-                std::unique_lock<std::mutex> lock(*mtx_);
-                cdc_infer_time_ = infer_time;
-                decode_time_ = duration;
+                auto end1 = std::chrono::steady_clock::now();
+                auto duration1 = std::chrono::duration_cast<std::chrono::milliseconds>(end1 - decode_start_time1[decode_id]);
+                {
+                    std::unique_lock<std::mutex> lock(*mtx_);
+                    cdc_infer_time_ = infer_time;
+                    decode_time_ = duration;
 
-                LOG_INFO("Update cdc infer time:%lf, decode id: %d, decode time:%lf, decode time1:%ld", cdc_infer_time_, decode_id, decode_time_, duration1.count());
-            }
+                    LOG_INFO("Update cdc infer time:%lf, decode id: %d, decode time:%lf, decode time1:%ld", cdc_infer_time_, decode_id, decode_time_, duration1.count());
+                }
 
-            filter_->updateFilterRatio(duration, 0);
+                filter_->updateFilterRatio(duration, 0);
 
-            if(is_need_reply && stream) {
-                assert(stripe_ids.size() == 1);
-                auto id = *stripe_ids.cbegin();
-                ElasticcdcReply reply;
-                std::string reply_data(reply_info.begin(), reply_info.end());
-                reply.set_reply_info(reply_data);
-                reply.set_id(id - start_task_id);
-                reply.set_recompute(is_recompute);
-                std::unique_lock<std::mutex> task_lock(*taskCountMtx);
-                if(!is_stripes_completed[decode_id]) {
-                    stream->Write(reply);
-                    tasks_completed_num++;
-                    is_stripes_completed[decode_id] = true;
+                if(is_need_reply && stream) {
+                    assert(stripe_ids.size() == 1);
+                    auto id = *stripe_ids.cbegin();
+                    ElasticcdcReply reply;
+                    std::string reply_data(reply_info.begin(), reply_info.end());
+                    reply.set_reply_info(reply_data);
+                    reply.set_id(id - start_task_id);
+                    reply.set_recompute(is_recompute);
+                    std::unique_lock<std::mutex> task_lock(*taskCountMtx);
+                    if(!is_stripes_completed[decode_id]) {
+                        stream->Write(reply);
+                        tasks_completed_num++;
+                        is_stripes_completed[decode_id] = true;
+                    }
                 }
             }
             
@@ -1578,8 +1635,8 @@ void DecodeWorker::handleBackupQuery(std::unordered_set<int>& visited_id2,
         ElasticcdcReply reply;
 
         std::vector<std::string> reply_data_vec;
-            if (conf_->model_name.find("irevnet") != std::string::npos) {
-                std::string reply_data(infer_query->reply_info_bytes.begin() + DATASETS.at(model_name_).first,
+            if (conf_->model_name.find("irevnet") != std::string::npos && !topkReply(infer_query)) {
+                std::string reply_data(infer_query->reply_info_bytes.begin() + featureWireSize(),
                                     infer_query->reply_info_bytes.end());
                 reply_data_vec.push_back(reply_data);
             }
@@ -1663,8 +1720,7 @@ for(auto& info: encode_fail_num) {
                 SingleQuery* singleQuery = dynamic_cast<SingleQuery*>(next_query);
                 stripe_ids.erase(singleQuery->id_);
                 if (conf_->model_name.find("irevnet") != std::string::npos)
-                    data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
-                                                         singleQuery->reply_info_bytes.begin() + DATASETS.at(model_name_).first));
+                    data.emplace_back(retainReply(singleQuery) ? std::vector<uint8_t>() : replyFeature(singleQuery));
                 else
                     data.emplace_back(std::vector<uint8_t>(singleQuery->reply_info_bytes.begin(),
                                                          singleQuery->reply_info_bytes.end()));
@@ -1677,7 +1733,7 @@ for(auto& info: encode_fail_num) {
 
                 }
             }
-            if (is_need_decode && stream) {
+            if (is_need_decode && stream && fetchRetainedFeatures(querys_it->second, data)) {
                 assert(stripe_ids.size() == 1);
                 auto id = *stripe_ids.cbegin();
                 std::cout << "broken id: " << id << std::endl;
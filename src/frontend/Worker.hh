@@ -1,10 +1,12 @@
 #pragma once
 #include "../inc/inc.hh"
 #include "../common/concurrency_queue.hh"
+#include "../common/mpmc_queue.hh"
 #include "../common/conf.hh"
 #include "../common/image.hh"
 #include "../common/logger.hh"
 #include "../common/concurrency_set.hh"
+#include "../common/quantize.hh"
 
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 #include <grpcpp/grpcpp.h>
@@ -14,7 +16,7 @@
 #include "encoder.hh"
 #include "decoder.hh"
 #include "query.hh"
-#include "preprocessor.hh"
+#include "../common/preprocessor.hh"
 // #include "monitor.hh"
 #include "monitor2parts.hh"
 #include "../protocol/elasticcdc.pb.h"
@@ -34,7 +36,8 @@ using grpc::ClientReaderWriter;
 using grpc::ServerReaderWriter;
 using grpc::Channel;
 
-using QueryQueue = ConcurrencyQueue<Query*>;
+// the stages wait inside the queues, there is no mutex around them
+using QueryQueue = MpmcQueue<Query*>;
 using QueryIdSet = ConcurrencySet<uint32_t>;
 
 extern int tasks_completed_num;
@@ -52,31 +55,44 @@ public:
 
     Worker(std::shared_ptr<Config> conf_, 
         std::shared_ptr<QueryQueue> queue_1,
-        std::shared_ptr<std::mutex> mtx_1,
-        std::shared_ptr<std::condition_variable> cv_1,
         std::shared_ptr<QueryQueue> queue_2,
-        std::shared_ptr<std::mutex> mtx_2,
-        std::shared_ptr<std::condition_variable> cv_2,
         std::shared_ptr<Monitor> monitor):
         conf_(conf_), 
         queue_1_(queue_1), 
-        mtx_1_(mtx_1), 
-        cv_1_(cv_1), 
         queue_2_(queue_2), 
-        mtx_2_(mtx_2), 
-        cv_2_(cv_2),
-        monitor_(monitor) {};
+        monitor_(monitor),
+        feature_precision_(ParseFeaturePrecision(conf_->feature_precision)) {};
+
+    // the size of the feature at the head of an irevnet reply, the label
+    // follows it
+    size_t featureWireSize() const {
+        return FeatureWireSize(feature_precision_, DATASETS.at(conf_->model_name).first);
+    }
+    // the fp32 feature of an irevnet reply, as the decoders expect it
+    std::vector<uint8_t> replyFeature(const SingleQuery* query) const;
+    // decodes the image of 'query' into the input tensor of the model,
+    // false if it can not be decoded
+    bool preprocessImage(SingleQuery* query) const;
+    // the backups are never decoded, they are answered with their top
+    // classes only when backup_top_k is set
+    bool topkReply(const SingleQuery* query) const {
+        return conf_->backup_top_k > 0 && query->encode_type_ == "Backup";
+    }
+    // the irevnet CDC replies only carry the prediction when retain_features
+    // is set, their backend keeps the feature map for a decode
+    bool retainReply(const SingleQuery* query) const {
+        return conf_->retain_features && query->encode_type_ == "CDC" &&
+               conf_->model_name.find("irevnet") != std::string::npos;
+    }
 
     std::shared_ptr<Config> conf_;
     std::shared_ptr<Monitor> monitor_;
 
     std::shared_ptr<QueryQueue> queue_1_;
-    std::shared_ptr<std::mutex> mtx_1_;
-    std::shared_ptr<std::condition_variable> cv_1_;
 
     std::shared_ptr<QueryQueue> queue_2_;
-    std::shared_ptr<std::mutex> mtx_2_;
-    std::shared_ptr<std::condition_variable> cv_2_;
+
+    FeaturePrecision feature_precision_;
 
     static std::shared_ptr<std::mutex> mtx_;
     static double cdc_infer_time_;
@@ -96,11 +112,7 @@ class PreprocessWorker: private Worker {
 public:
     PreprocessWorker(std::shared_ptr<Config> conf_,
                 std::shared_ptr<QueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
                 std::shared_ptr<QueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2,
                 std::shared_ptr<Monitor> monitor);
     ~PreprocessWorker();
 
@@ -121,11 +133,7 @@ class EncodeWorker: private Worker {
 public:
     EncodeWorker(std::shared_ptr<Config> conf_,
                 std::shared_ptr<QueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
                 std::shared_ptr<QueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2,
                 std::shared_ptr<Monitor> monitor,
                 std::shared_ptr<Filter> filter);
     ~EncodeWorker();
@@ -153,14 +161,8 @@ class InferWorker: private Worker {
 public:
     InferWorker(std::shared_ptr<Config> conf,
                 std::shared_ptr<QueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
                 std::shared_ptr<QueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2,
                 std::shared_ptr<QueryQueue> queue_3,
-                std::shared_ptr<std::mutex> mtx_3,
-                std::shared_ptr<std::condition_variable> cv_3,
                 std::shared_ptr<Monitor> monitor,
                 std::uint32_t frontend_id);
     ~InferWorker();
@@ -178,8 +180,6 @@ private:
     std::uint32_t frontend_id_;
 
     std::shared_ptr<QueryQueue> queue_3_;
-    std::shared_ptr<std::mutex> mtx_3_;
-    std::shared_ptr<std::condition_variable> cv_3_;
     tbb::concurrent_unordered_map<uint64_t, std::vector<Query*>> querys_encode_map_;
     tbb::concurrent_unordered_map<uint64_t, std::vector<Query*>> querys_backup_map_;
     tbb::concurrent_unordered_map<uint64_t, uint32_t>  backup_fail_num; //[encode_id, fail_num]
@@ -209,13 +209,10 @@ class DecodeWorker: private Worker {
 public:
     DecodeWorker(std::shared_ptr<Config> conf_,
                 std::shared_ptr<QueryQueue> queue_1,
-                std::shared_ptr<std::mutex> mtx_1,
-                std::shared_ptr<std::condition_variable> cv_1,
                 std::shared_ptr<QueryQueue> queue_2,
-                std::shared_ptr<std::mutex> mtx_2,
-                std::shared_ptr<std::condition_variable> cv_2,
                 std::shared_ptr<Monitor> monitor,
-                std::shared_ptr<Filter> filter);
+                std::shared_ptr<Filter> filter,
+                std::uint32_t frontend_id);
     ~DecodeWorker();
 
     void run() override;
@@ -228,7 +225,15 @@ private:
     std::shared_ptr<Decoder> decoder_;
     std::shared_ptr<Filter> filter_;
     std::string model_name_;
-
+    std::uint32_t frontend_id_;
+    // the backends the retained features are fetched from, by ip
+    std::unordered_map<std::string, std::unique_ptr<ElasticcdcService::Stub>> feature_stubs_;
+
+    // fills the entries of 'data' left empty for the retained replies of
+    // 'querys' with the features fetched from their backends, false if one
+    // of them is no longer kept
+    bool fetchRetainedFeatures(const std::vector<Query*>& querys,
+                               std::vector<std::vector<uint8_t>>& data);
 
     void handleCDCQuery(std::unordered_map<int, std::vector<Query*>>& querys_id1,
                         std::unordered_set<int>& visited_id1,
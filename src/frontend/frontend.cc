@@ -35,23 +35,12 @@ Frontend::Frontend(std::shared_ptr<Config> conf, std::shared_ptr<Monitor> monito
     encode_queue_ = std::make_shared<QueryQueue>();
     infer_queue_ = std::make_shared<QueryQueue>();
 
-    recv_mutex_ = std::make_shared<std::mutex>();
-    pp_mutex_ = std::make_shared<std::mutex>();
-    encode_mutex_ = std::make_shared<std::mutex>();
-    infer_mutex_ = std::make_shared<std::mutex>();
-
-    recv_cv_ = std::make_shared<std::condition_variable>();
-    pp_cv_ = std::make_shared<std::condition_variable>();
-    encode_cv_ = std::make_shared<std::condition_variable>();
-    infer_cv_ = std::make_shared<std::condition_variable>();
-
     filter_ = filter;
 
-    pp_worker_ = std::make_shared<PreprocessWorker>(conf_, recv_queue_, recv_mutex_, recv_cv_, pp_queue_, pp_mutex_, pp_cv_, monitor);
-    encode_worker_ = std::make_shared<EncodeWorker>(conf_, pp_queue_, pp_mutex_, pp_cv_, encode_queue_, encode_mutex_, encode_cv_, monitor, filter_);
-    infer_worker_ = std::make_shared<InferWorker>(conf_, encode_queue_, encode_mutex_, encode_cv_, infer_queue_, infer_mutex_, infer_cv_,
-                                                    pp_queue_, pp_mutex_, pp_cv_, monitor, frontend_id);
-    decode_worker_ = std::make_shared<DecodeWorker>(conf_, infer_queue_, infer_mutex_, infer_cv_, nullptr, nullptr, nullptr, monitor, filter_);
+    pp_worker_ = std::make_shared<PreprocessWorker>(conf_, recv_queue_, pp_queue_, monitor);
+    encode_worker_ = std::make_shared<EncodeWorker>(conf_, pp_queue_, encode_queue_, monitor, filter_);
+    infer_worker_ = std::make_shared<InferWorker>(conf_, encode_queue_, infer_queue_, pp_queue_, monitor, frontend_id);
+    decode_worker_ = std::make_shared<DecodeWorker>(conf_, infer_queue_, nullptr, monitor, filter_, frontend_id);
     LOG_INFO("Frontend created");
 }
 
@@ -71,10 +60,7 @@ void Frontend::Exec(const ImageArgs& request){
     request_info.is_parity_data_ = request.is_parity_data_;
     // request_info.frontendId = frontend_id;
     
-    std::unique_lock<std::mutex> lock(*recv_mutex_);
     auto query = new SingleQuery(request_info);
     recv_queue_->Push(query);
-    lock.unlock();
     LOG_INFO("push query: %d to recv queue", request_info.id);
-    recv_cv_->notify_all();
 }
@@ -37,20 +37,9 @@ private:
     std::shared_ptr<DecodeWorker> decode_worker_;
 
     std::shared_ptr<QueryQueue> recv_queue_;
-    std::shared_ptr<std::mutex> recv_mutex_;
-    std::shared_ptr<std::condition_variable> recv_cv_;
-    
     std::shared_ptr<QueryQueue> pp_queue_;
-    std::shared_ptr<std::mutex> pp_mutex_;
-    std::shared_ptr<std::condition_variable> pp_cv_;
-
     std::shared_ptr<QueryQueue> encode_queue_;
-    std::shared_ptr<std::mutex> encode_mutex_;
-    std::shared_ptr<std::condition_variable> encode_cv_;
-
     std::shared_ptr<QueryQueue> infer_queue_;
-    std::shared_ptr<std::mutex> infer_mutex_;
-    std::shared_ptr<std::condition_variable> infer_cv_;
 
     std::shared_ptr<Filter> filter_;
 
@@ -6,6 +6,7 @@
 #include "../common/conf.hh"
 #include "../util/ARIMA/ARIMA.hh"
 #include "filter.hh"
+#include <algorithm>
 #include <deque>
 #include <queue>
 #include <cmath>
@@ -148,6 +149,9 @@ private:
     std::vector<std::string> ava_vul_backend_ips_{};
     std::vector<std::string> backend_ips_{};
     std::unordered_set<std::string> new_unava_backend_ips_{};
+    // the backends that rejected a query before a preemption, left out until
+    // the trace reports them unavailable
+    std::unordered_set<std::string> draining_backend_ips_{};
     std::unordered_map<std::string, std::uint32_t> ip_2_zone{};
 
     std::unordered_map<uint32_t, std::vector<std::uint32_t>> region_to_zones_{};
@@ -624,6 +628,13 @@ public:
             new_unava_ips.insert(std::get<2>(ip_list_a_region).begin(), std::get<2>(ip_list_a_region).end());
         }
 
+        for(const auto& ip: new_unava_ips) {
+            draining_backend_ips_.erase(ip);
+        }
+        auto is_draining = [this](const std::string& ip) { return draining_backend_ips_.count(ip) > 0; };
+        ava_invul_ips.erase(std::remove_if(ava_invul_ips.begin(), ava_invul_ips.end(), is_draining), ava_invul_ips.end());
+        ava_vul_ips.erase(std::remove_if(ava_vul_ips.begin(), ava_vul_ips.end(), is_draining), ava_vul_ips.end());
+
         // lock
         ava_invul_backend_ips_ = ava_invul_ips;
         ava_vul_backend_ips_ = ava_vul_ips;
@@ -964,6 +975,31 @@ public:
 
     }
 
+    /*
+     *@brief the backend rejected a query as it drains before a preemption, no query is sent to it any more
+     */
+    void BackendDraining(const std::string& backendip) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if(!draining_backend_ips_.insert(backendip).second) return;
+        LOG_INFO("Backend %s is draining", backendip.c_str());
+        ava_invul_backend_ips_.erase(std::remove(ava_invul_backend_ips_.begin(), ava_invul_backend_ips_.end(), backendip),
+                                     ava_invul_backend_ips_.end());
+        ava_vul_backend_ips_.erase(std::remove(ava_vul_backend_ips_.begin(), ava_vul_backend_ips_.end(), backendip),
+                                   ava_vul_backend_ips_.end());
+    }
+
+    /*
+     *@brief the query and its stripe are broken as on a preemption, without waiting for the next update
+     */
+    void RejectAQuery(std::string backendip, uint32_t query_id) {
+        std::lock_guard<std::mutex> lock(mtx_querys_state_);
+        querys_state[backendip][query_id] = false;
+        if(_cdc_querys.find(query_id) == _cdc_querys.end())
+            return;
+        std::lock_guard<std::mutex> stripes_lock(mtx_stripes_state_);
+        stripes_state[querys_to_stripes[query_id]] = false;
+    }
+
     bool IsQueryBroken(std::string backendip, uint32_t query_id) {
         std::lock_guard<std::mutex> lock(mtx_querys_state_);
         return !querys_state[backendip][query_id];
@@ -44,6 +44,8 @@ public:
         end_signal_ = request_info.end_signal_;
         is_recompute_ = request_info.is_recompute_;
         is_parity_data_ = request_info.is_parity_data_;
+        compressed_ = request_info.compressed_;
+        created_ = std::chrono::steady_clock::now();
     }
     std::shared_ptr<grpcStream> stream_;
     std::vector<uint8_t> data_;
@@ -51,6 +53,14 @@ public:
     std::vector<uint8_t> reply_info_bytes;
     bool end_signal_;
     double infer_time;
+    // the deadline of the query runs from here, a recompute of the query
+    // keeps it
+    std::chrono::steady_clock::time_point created_;
+    // the backend the query was last sent to, which keeps its feature map
+    // when the reply is retained
+    std::string backend_ip_;
+    // data_ is still the image of the client, see Config::compressed_backup
+    bool compressed_ = false;
 };
 
 class BatchQuery: public Query {
@@ -24,6 +24,7 @@ namespace elasticcdc {
 static const char* ElasticcdcService_method_names[] = {
   "/elasticcdc.ElasticcdcService/DataTransStream",
   "/elasticcdc.ElasticcdcService/IsPreempted",
+  "/elasticcdc.ElasticcdcService/FetchFeatures",
 };
 
 std::unique_ptr< ElasticcdcService::Stub> ElasticcdcService::NewStub(const std::shared_ptr< ::grpc::ChannelInterface>& channel, const ::grpc::StubOptions& options) {
@@ -35,6 +36,7 @@ std::unique_ptr< ElasticcdcService::Stub> ElasticcdcService::NewStub(const std::
 ElasticcdcService::Stub::Stub(const std::shared_ptr< ::grpc::ChannelInterface>& channel, const ::grpc::StubOptions& options)
   : channel_(channel), rpcmethod_DataTransStream_(ElasticcdcService_method_names[0], options.suffix_for_stats(),::grpc::internal::RpcMethod::BIDI_STREAMING, channel)
   , rpcmethod_IsPreempted_(ElasticcdcService_method_names[1], options.suffix_for_stats(),::grpc::internal::RpcMethod::NORMAL_RPC, channel)
+  , rpcmethod_FetchFeatures_(ElasticcdcService_method_names[2], options.suffix_for_stats(),::grpc::internal::RpcMethod::NORMAL_RPC, channel)
   {}
 
 ::grpc::ClientReaderWriter< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>* ElasticcdcService::Stub::DataTransStreamRaw(::grpc::ClientContext* context) {
@@ -76,6 +78,29 @@ void ElasticcdcService::Stub::async::IsPreempted(::grpc::ClientContext* context,
   return result;
 }
 
+::grpc::Status ElasticcdcService::Stub::FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::elasticcdc::ElasticcdcReply* response) {
+  return ::grpc::internal::BlockingUnaryCall< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply, ::grpc::protobuf::MessageLite, ::grpc::protobuf::MessageLite>(channel_.get(), rpcmethod_FetchFeatures_, context, request, response);
+}
+
+void ElasticcdcService::Stub::async::FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, std::function<void(::grpc::Status)> f) {
+  ::grpc::internal::CallbackUnaryCall< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply, ::grpc::protobuf::MessageLite, ::grpc::protobuf::MessageLite>(stub_->channel_.get(), stub_->rpcmethod_FetchFeatures_, context, request, response, std::move(f));
+}
+
+void ElasticcdcService::Stub::async::FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, ::grpc::ClientUnaryReactor* reactor) {
+  ::grpc::internal::ClientCallbackUnaryFactory::Create< ::grpc::protobuf::MessageLite, ::grpc::protobuf::MessageLite>(stub_->channel_.get(), stub_->rpcmethod_FetchFeatures_, context, request, response, reactor);
+}
+
+::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* ElasticcdcService::Stub::PrepareAsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+  return ::grpc::internal::ClientAsyncResponseReaderHelper::Create< ::elasticcdc::ElasticcdcReply, ::elasticcdc::ElasticcdcRequest, ::grpc::protobuf::MessageLite, ::grpc::protobuf::MessageLite>(channel_.get(), cq, rpcmethod_FetchFeatures_, context, request);
+}
+
+::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* ElasticcdcService::Stub::AsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+  auto* result =
+    this->PrepareAsyncFetchFeaturesRaw(context, request, cq);
+  result->StartCall();
+  return result;
+}
+
 ElasticcdcService::Service::Service() {
   AddMethod(new ::grpc::internal::RpcServiceMethod(
       ElasticcdcService_method_names[0],
@@ -97,6 +122,16 @@ ElasticcdcService::Service::Service() {
              ::elasticcdc::ElasticcdcReply* resp) {
                return service->IsPreempted(ctx, req, resp);
              }, this)));
+  AddMethod(new ::grpc::internal::RpcServiceMethod(
+      ElasticcdcService_method_names[2],
+      ::grpc::internal::RpcMethod::NORMAL_RPC,
+      new ::grpc::internal::RpcMethodHandler< ElasticcdcService::Service, ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply, ::grpc::protobuf::MessageLite, ::grpc::protobuf::MessageLite>(
+          [](ElasticcdcService::Service* service,
+             ::grpc::ServerContext* ctx,
+             const ::elasticcdc::ElasticcdcRequest* req,
+             ::elasticcdc::ElasticcdcReply* resp) {
+               return service->FetchFeatures(ctx, req, resp);
+             }, this)));
 }
 
 ElasticcdcService::Service::~Service() {
@@ -115,6 +150,13 @@ ElasticcdcService::Service::~Service() {
   return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
 }
 
+::grpc::Status ElasticcdcService::Service::FetchFeatures(::grpc::ServerContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response) {
+  (void) context;
+  (void) request;
+  (void) response;
+  return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+}
+
 
 }  // namespace elasticcdc
 
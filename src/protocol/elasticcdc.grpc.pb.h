@@ -52,12 +52,21 @@ class ElasticcdcService final {
     std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>> PrepareAsyncIsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
       return std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>>(PrepareAsyncIsPreemptedRaw(context, request, cq));
     }
+    virtual ::grpc::Status FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::elasticcdc::ElasticcdcReply* response) = 0;
+    std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>> AsyncFetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+      return std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>>(AsyncFetchFeaturesRaw(context, request, cq));
+    }
+    std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>> PrepareAsyncFetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+      return std::unique_ptr< ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>>(PrepareAsyncFetchFeaturesRaw(context, request, cq));
+    }
     class async_interface {
      public:
       virtual ~async_interface() {}
       virtual void DataTransStream(::grpc::ClientContext* context, ::grpc::ClientBidiReactor< ::elasticcdc::ElasticcdcRequest,::elasticcdc::ElasticcdcReply>* reactor) = 0;
       virtual void IsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, std::function<void(::grpc::Status)>) = 0;
       virtual void IsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, ::grpc::ClientUnaryReactor* reactor) = 0;
+      virtual void FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, std::function<void(::grpc::Status)>) = 0;
+      virtual void FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, ::grpc::ClientUnaryReactor* reactor) = 0;
     };
     typedef class async_interface experimental_async_interface;
     virtual class async_interface* async() { return nullptr; }
@@ -68,6 +77,8 @@ class ElasticcdcService final {
     virtual ::grpc::ClientAsyncReaderWriterInterface< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>* PrepareAsyncDataTransStreamRaw(::grpc::ClientContext* context, ::grpc::CompletionQueue* cq) = 0;
     virtual ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>* AsyncIsPreemptedRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) = 0;
     virtual ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>* PrepareAsyncIsPreemptedRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) = 0;
+    virtual ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>* AsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) = 0;
+    virtual ::grpc::ClientAsyncResponseReaderInterface< ::elasticcdc::ElasticcdcReply>* PrepareAsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) = 0;
   };
   class Stub final : public StubInterface {
    public:
@@ -88,12 +99,21 @@ class ElasticcdcService final {
     std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>> PrepareAsyncIsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
       return std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>>(PrepareAsyncIsPreemptedRaw(context, request, cq));
     }
+    ::grpc::Status FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::elasticcdc::ElasticcdcReply* response) override;
+    std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>> AsyncFetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+      return std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>>(AsyncFetchFeaturesRaw(context, request, cq));
+    }
+    std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>> PrepareAsyncFetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) {
+      return std::unique_ptr< ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>>(PrepareAsyncFetchFeaturesRaw(context, request, cq));
+    }
     class async final :
       public StubInterface::async_interface {
      public:
       void DataTransStream(::grpc::ClientContext* context, ::grpc::ClientBidiReactor< ::elasticcdc::ElasticcdcRequest,::elasticcdc::ElasticcdcReply>* reactor) override;
       void IsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, std::function<void(::grpc::Status)>) override;
       void IsPreempted(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, ::grpc::ClientUnaryReactor* reactor) override;
+      void FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, std::function<void(::grpc::Status)>) override;
+      void FetchFeatures(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response, ::grpc::ClientUnaryReactor* reactor) override;
      private:
       friend class Stub;
       explicit async(Stub* stub): stub_(stub) { }
@@ -110,8 +130,11 @@ class ElasticcdcService final {
     ::grpc::ClientAsyncReaderWriter< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>* PrepareAsyncDataTransStreamRaw(::grpc::ClientContext* context, ::grpc::CompletionQueue* cq) override;
     ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* AsyncIsPreemptedRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) override;
     ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* PrepareAsyncIsPreemptedRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) override;
+    ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* AsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) override;
+    ::grpc::ClientAsyncResponseReader< ::elasticcdc::ElasticcdcReply>* PrepareAsyncFetchFeaturesRaw(::grpc::ClientContext* context, const ::elasticcdc::ElasticcdcRequest& request, ::grpc::CompletionQueue* cq) override;
     const ::grpc::internal::RpcMethod rpcmethod_DataTransStream_;
     const ::grpc::internal::RpcMethod rpcmethod_IsPreempted_;
+    const ::grpc::internal::RpcMethod rpcmethod_FetchFeatures_;
   };
   static std::unique_ptr<Stub> NewStub(const std::shared_ptr< ::grpc::ChannelInterface>& channel, const ::grpc::StubOptions& options = ::grpc::StubOptions());
 
@@ -121,6 +144,7 @@ class ElasticcdcService final {
     virtual ~Service();
     virtual ::grpc::Status DataTransStream(::grpc::ServerContext* context, ::grpc::ServerReaderWriter< ::elasticcdc::ElasticcdcReply, ::elasticcdc::ElasticcdcRequest>* stream);
     virtual ::grpc::Status IsPreempted(::grpc::ServerContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response);
+    virtual ::grpc::Status FetchFeatures(::grpc::ServerContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response);
   };
   template <class BaseClass>
   class WithAsyncMethod_DataTransStream : public BaseClass {
@@ -162,7 +186,27 @@ class ElasticcdcService final {
       ::grpc::Service::RequestAsyncUnary(1, context, request, response, new_call_cq, notification_cq, tag);
     }
   };
-  typedef WithAsyncMethod_DataTransStream<WithAsyncMethod_IsPreempted<Service > > AsyncService;
+  template <class BaseClass>
+  class WithAsyncMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithAsyncMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodAsync(2);
+    }
+    ~WithAsyncMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable synchronous version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+    void RequestFetchFeatures(::grpc::ServerContext* context, ::elasticcdc::ElasticcdcRequest* request, ::grpc::ServerAsyncResponseWriter< ::elasticcdc::ElasticcdcReply>* response, ::grpc::CompletionQueue* new_call_cq, ::grpc::ServerCompletionQueue* notification_cq, void *tag) {
+      ::grpc::Service::RequestAsyncUnary(2, context, request, response, new_call_cq, notification_cq, tag);
+    }
+  };
+  typedef WithAsyncMethod_DataTransStream<WithAsyncMethod_IsPreempted<WithAsyncMethod_FetchFeatures<Service > > > AsyncService;
   template <class BaseClass>
   class WithCallbackMethod_DataTransStream : public BaseClass {
    private:
@@ -213,7 +257,34 @@ class ElasticcdcService final {
     virtual ::grpc::ServerUnaryReactor* IsPreempted(
       ::grpc::CallbackServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/)  { return nullptr; }
   };
-  typedef WithCallbackMethod_DataTransStream<WithCallbackMethod_IsPreempted<Service > > CallbackService;
+  template <class BaseClass>
+  class WithCallbackMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithCallbackMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodCallback(2,
+          new ::grpc::internal::CallbackUnaryHandler< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>(
+            [this](
+                   ::grpc::CallbackServerContext* context, const ::elasticcdc::ElasticcdcRequest* request, ::elasticcdc::ElasticcdcReply* response) { return this->FetchFeatures(context, request, response); }));}
+    void SetMessageAllocatorFor_FetchFeatures(
+        ::grpc::MessageAllocator< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>* allocator) {
+      ::grpc::internal::MethodHandler* const handler = ::grpc::Service::GetHandler(2);
+      static_cast<::grpc::internal::CallbackUnaryHandler< ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>*>(handler)
+              ->SetMessageAllocator(allocator);
+    }
+    ~WithCallbackMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable synchronous version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+    virtual ::grpc::ServerUnaryReactor* FetchFeatures(
+      ::grpc::CallbackServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/)  { return nullptr; }
+  };
+  typedef WithCallbackMethod_DataTransStream<WithCallbackMethod_IsPreempted<WithCallbackMethod_FetchFeatures<Service > > > CallbackService;
   typedef CallbackService ExperimentalCallbackService;
   template <class BaseClass>
   class WithGenericMethod_DataTransStream : public BaseClass {
@@ -250,6 +321,23 @@ class ElasticcdcService final {
     }
   };
   template <class BaseClass>
+  class WithGenericMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithGenericMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodGeneric(2);
+    }
+    ~WithGenericMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable synchronous version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+  };
+  template <class BaseClass>
   class WithRawMethod_DataTransStream : public BaseClass {
    private:
     void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
@@ -290,6 +378,26 @@ class ElasticcdcService final {
     }
   };
   template <class BaseClass>
+  class WithRawMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithRawMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodRaw(2);
+    }
+    ~WithRawMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable synchronous version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+    void RequestFetchFeatures(::grpc::ServerContext* context, ::grpc::ByteBuffer* request, ::grpc::ServerAsyncResponseWriter< ::grpc::ByteBuffer>* response, ::grpc::CompletionQueue* new_call_cq, ::grpc::ServerCompletionQueue* notification_cq, void *tag) {
+      ::grpc::Service::RequestAsyncUnary(2, context, request, response, new_call_cq, notification_cq, tag);
+    }
+  };
+  template <class BaseClass>
   class WithRawCallbackMethod_DataTransStream : public BaseClass {
    private:
     void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
@@ -335,6 +443,28 @@ class ElasticcdcService final {
       ::grpc::CallbackServerContext* /*context*/, const ::grpc::ByteBuffer* /*request*/, ::grpc::ByteBuffer* /*response*/)  { return nullptr; }
   };
   template <class BaseClass>
+  class WithRawCallbackMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithRawCallbackMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodRawCallback(2,
+          new ::grpc::internal::CallbackUnaryHandler< ::grpc::ByteBuffer, ::grpc::ByteBuffer>(
+            [this](
+                   ::grpc::CallbackServerContext* context, const ::grpc::ByteBuffer* request, ::grpc::ByteBuffer* response) { return this->FetchFeatures(context, request, response); }));
+    }
+    ~WithRawCallbackMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable synchronous version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+    virtual ::grpc::ServerUnaryReactor* FetchFeatures(
+      ::grpc::CallbackServerContext* /*context*/, const ::grpc::ByteBuffer* /*request*/, ::grpc::ByteBuffer* /*response*/)  { return nullptr; }
+  };
+  template <class BaseClass>
   class WithStreamedUnaryMethod_IsPreempted : public BaseClass {
    private:
     void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
@@ -361,9 +491,36 @@ class ElasticcdcService final {
     // replace default version of method with streamed unary
     virtual ::grpc::Status StreamedIsPreempted(::grpc::ServerContext* context, ::grpc::ServerUnaryStreamer< ::elasticcdc::ElasticcdcRequest,::elasticcdc::ElasticcdcReply>* server_unary_streamer) = 0;
   };
-  typedef WithStreamedUnaryMethod_IsPreempted<Service > StreamedUnaryService;
+  template <class BaseClass>
+  class WithStreamedUnaryMethod_FetchFeatures : public BaseClass {
+   private:
+    void BaseClassMustBeDerivedFromService(const Service* /*service*/) {}
+   public:
+    WithStreamedUnaryMethod_FetchFeatures() {
+      ::grpc::Service::MarkMethodStreamed(2,
+        new ::grpc::internal::StreamedUnaryHandler<
+          ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>(
+            [this](::grpc::ServerContext* context,
+                   ::grpc::ServerUnaryStreamer<
+                     ::elasticcdc::ElasticcdcRequest, ::elasticcdc::ElasticcdcReply>* streamer) {
+                       return this->StreamedFetchFeatures(context,
+                         streamer);
+                  }));
+    }
+    ~WithStreamedUnaryMethod_FetchFeatures() override {
+      BaseClassMustBeDerivedFromService(this);
+    }
+    // disable regular version of this method
+    ::grpc::Status FetchFeatures(::grpc::ServerContext* /*context*/, const ::elasticcdc::ElasticcdcRequest* /*request*/, ::elasticcdc::ElasticcdcReply* /*response*/) override {
+      abort();
+      return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "");
+    }
+    // replace default version of method with streamed unary
+    virtual ::grpc::Status StreamedFetchFeatures(::grpc::ServerContext* context, ::grpc::ServerUnaryStreamer< ::elasticcdc::ElasticcdcRequest,::elasticcdc::ElasticcdcReply>* server_unary_streamer) = 0;
+  };
+  typedef WithStreamedUnaryMethod_IsPreempted<WithStreamedUnaryMethod_FetchFeatures<Service > > StreamedUnaryService;
   typedef Service SplitStreamedService;
-  typedef WithStreamedUnaryMethod_IsPreempted<Service > StreamedService;
+  typedef WithStreamedUnaryMethod_IsPreempted<WithStreamedUnaryMethod_FetchFeatures<Service > > StreamedService;
 };
 
 }  // namespace elasticcdc
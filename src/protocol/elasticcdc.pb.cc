@@ -23,7 +23,11 @@ namespace _pbi = _pb::internal;
 namespace elasticcdc {
 PROTOBUF_CONSTEXPR ElasticcdcRequest::ElasticcdcRequest(
     ::_pbi::ConstantInitialized): _impl_{
-    /*decltype(_impl_.name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.feature_ids_)*/{}
+  , /*decltype(_impl_._feature_ids_cached_byte_size_)*/{0}
+  , /*decltype(_impl_.name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.image_classify_request_info_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.model_name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.scale_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
@@ -38,9 +42,12 @@ PROTOBUF_CONSTEXPR ElasticcdcRequest::ElasticcdcRequest(
   , /*decltype(_impl_.cdc_infer_time_)*/0
   , /*decltype(_impl_.backup_infer_time_)*/0
   , /*decltype(_impl_.decode_time_)*/0
+  , /*decltype(_impl_.deadline_ms_)*/0
   , /*decltype(_impl_.end_signal_)*/false
   , /*decltype(_impl_.recompute_)*/false
-  , /*decltype(_impl_._cached_size_)*/{}} {}
+  , /*decltype(_impl_.compressed_)*/false
+  , /*decltype(_impl_.output_mode_)*/0
+  , /*decltype(_impl_.top_k_)*/0u} {}
 struct ElasticcdcRequestDefaultTypeInternal {
   PROTOBUF_CONSTEXPR ElasticcdcRequestDefaultTypeInternal()
       : _instance(::_pbi::ConstantInitialized{}) {}
@@ -50,13 +57,29 @@ struct ElasticcdcRequestDefaultTypeInternal {
   };
 };
 PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 ElasticcdcRequestDefaultTypeInternal _ElasticcdcRequest_default_instance_;
+PROTOBUF_CONSTEXPR RetainedFeature::RetainedFeature(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_.data_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.id_)*/int64_t{0}
+  , /*decltype(_impl_._cached_size_)*/{}} {}
+struct RetainedFeatureDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR RetainedFeatureDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~RetainedFeatureDefaultTypeInternal() {}
+  union {
+    RetainedFeature _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 RetainedFeatureDefaultTypeInternal _RetainedFeature_default_instance_;
 PROTOBUF_CONSTEXPR ElasticcdcReply::ElasticcdcReply(
     ::_pbi::ConstantInitialized): _impl_{
-    /*decltype(_impl_.message_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+    /*decltype(_impl_.features_)*/{}
+  , /*decltype(_impl_.message_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.image_classify_reply_info_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.reply_info_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
   , /*decltype(_impl_.id_)*/int64_t{0}
   , /*decltype(_impl_.recompute_)*/false
+  , /*decltype(_impl_.rejected_)*/false
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct ElasticcdcReplyDefaultTypeInternal {
   PROTOBUF_CONSTEXPR ElasticcdcReplyDefaultTypeInternal()
@@ -68,12 +91,12 @@ struct ElasticcdcReplyDefaultTypeInternal {
 };
 PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 ElasticcdcReplyDefaultTypeInternal _ElasticcdcReply_default_instance_;
 }  // namespace elasticcdc
-static ::_pb::Metadata file_level_metadata_elasticcdc_2eproto[2];
-static constexpr ::_pb::EnumDescriptor const** file_level_enum_descriptors_elasticcdc_2eproto = nullptr;
+static ::_pb::Metadata file_level_metadata_elasticcdc_2eproto[3];
+static const ::_pb::EnumDescriptor* file_level_enum_descriptors_elasticcdc_2eproto[1];
 static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_elasticcdc_2eproto = nullptr;
 
 const uint32_t TableStruct_elasticcdc_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
-  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_._has_bits_),
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _internal_metadata_),
   ~0u,  // no _extensions_
   ~0u,  // no _oneof_case_
@@ -96,6 +119,41 @@ const uint32_t TableStruct_elasticcdc_2eproto::offsets[] PROTOBUF_SECTION_VARIAB
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.decode_time_),
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.end_signal_),
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.recompute_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.deadline_ms_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.output_mode_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.top_k_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.feature_ids_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcRequest, _impl_.compressed_),
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  0,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::RetainedFeature, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::RetainedFeature, _impl_.id_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::RetainedFeature, _impl_.data_),
   ~0u,  // no _has_bits_
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _internal_metadata_),
   ~0u,  // no _extensions_
@@ -107,19 +165,23 @@ const uint32_t TableStruct_elasticcdc_2eproto::offsets[] PROTOBUF_SECTION_VARIAB
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _impl_.reply_info_),
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _impl_.id_),
   PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _impl_.recompute_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _impl_.features_),
+  PROTOBUF_FIELD_OFFSET(::elasticcdc::ElasticcdcReply, _impl_.rejected_),
 };
 static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
-  { 0, -1, -1, sizeof(::elasticcdc::ElasticcdcRequest)},
-  { 23, -1, -1, sizeof(::elasticcdc::ElasticcdcReply)},
+  { 0, 28, -1, sizeof(::elasticcdc::ElasticcdcRequest)},
+  { 50, -1, -1, sizeof(::elasticcdc::RetainedFeature)},
+  { 58, -1, -1, sizeof(::elasticcdc::ElasticcdcReply)},
 };
 
 static const ::_pb::Message* const file_default_instances[] = {
   &::elasticcdc::_ElasticcdcRequest_default_instance_._instance,
+  &::elasticcdc::_RetainedFeature_default_instance_._instance,
   &::elasticcdc::_ElasticcdcReply_default_instance_._instance,
 };
 
 const char descriptor_table_protodef_elasticcdc_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
-  "\n\020elasticcdc.proto\022\nelasticcdc\"\337\002\n\021Elast"
+  "\n\020elasticcdc.proto\022\nelasticcdc\"\256\004\n\021Elast"
   "iccdcRequest\022\014\n\004name\030\001 \001(\t\022#\n\033image_clas"
   "sify_request_info\030\002 \001(\t\022\022\n\nmodel_name\030\003 "
   "\001(\t\022\r\n\005scale\030\004 \001(\t\022\020\n\010filename\030\005 \001(\t\022\n\n\002"
@@ -128,21 +190,31 @@ const char descriptor_table_protodef_elasticcdc_2eproto[] PROTOBUF_SECTION_VARIA
   "annels\030\013 \001(\r\022\023\n\013encode_type\030\014 \001(\t\022\026\n\016cdc"
   "_infer_time\030\r \001(\001\022\031\n\021backup_infer_time\030\016"
   " \001(\001\022\023\n\013decode_time\030\017 \001(\001\022\022\n\nend_signal\030"
-  "\020 \001(\010\022\021\n\trecompute\030\021 \001(\010\"x\n\017ElasticcdcRe"
-  "ply\022\017\n\007message\030\001 \001(\t\022!\n\031image_classify_r"
-  "eply_info\030\002 \001(\t\022\022\n\nreply_info\030\003 \001(\014\022\n\n\002i"
-  "d\030\004 \001(\003\022\021\n\trecompute\030\005 \001(\0102\265\001\n\021Elasticcd"
-  "cService\022S\n\017DataTransStream\022\035.elasticcdc"
-  ".ElasticcdcRequest\032\033.elasticcdc.Elasticc"
-  "dcReply\"\000(\0010\001\022K\n\013IsPreempted\022\035.elasticcd"
-  "c.ElasticcdcRequest\032\033.elasticcdc.Elastic"
-  "cdcReply\"\000b\006proto3"
+  "\020 \001(\010\022\021\n\trecompute\030\021 \001(\010\022\030\n\013deadline_ms\030"
+  "\022 \001(\001H\000\210\001\001\022=\n\013output_mode\030\023 \001(\0162(.elasti"
+  "ccdc.ElasticcdcRequest.OutputMode\022\r\n\005top"
+  "_k\030\024 \001(\r\022\023\n\013feature_ids\030\025 \003(\003\022\022\n\ncompres"
+  "sed\030\026 \001(\010\",\n\nOutputMode\022\010\n\004FULL\020\000\022\010\n\004TOP"
+  "K\020\001\022\n\n\006RETAIN\020\002B\016\n\014_deadline_ms\"+\n\017Retai"
+  "nedFeature\022\n\n\002id\030\001 \001(\003\022\014\n\004data\030\002 \001(\014\"\271\001\n"
+  "\017ElasticcdcReply\022\017\n\007message\030\001 \001(\t\022!\n\031ima"
+  "ge_classify_reply_info\030\002 \001(\t\022\022\n\nreply_in"
+  "fo\030\003 \001(\014\022\n\n\002id\030\004 \001(\003\022\021\n\trecompute\030\005 \001(\010\022"
+  "-\n\010features\030\006 \003(\0132\033.elasticcdc.RetainedF"
+  "eature\022\020\n\010rejected\030\007 \001(\0102\204\002\n\021ElasticcdcS"
+  "ervice\022S\n\017DataTransStream\022\035.elasticcdc.E"
+  "lasticcdcRequest\032\033.elasticcdc.Elasticcdc"
+  "Reply\"\000(\0010\001\022K\n\013IsPreempted\022\035.elasticcdc."
+  "ElasticcdcRequest\032\033.elasticcdc.Elasticcd"
+  "cReply\"\000\022M\n\rFetchFeatures\022\035.elasticcdc.E"
+  "lasticcdcRequest\032\033.elasticcdc.Elasticcdc"
+  "Reply\"\000b\006proto3"
   ;
 static ::_pbi::once_flag descriptor_table_elasticcdc_2eproto_once;
 const ::_pbi::DescriptorTable descriptor_table_elasticcdc_2eproto = {
-    false, false, 698, descriptor_table_protodef_elasticcdc_2eproto,
+    false, false, 1095, descriptor_table_protodef_elasticcdc_2eproto,
     "elasticcdc.proto",
-    &descriptor_table_elasticcdc_2eproto_once, nullptr, 0, 2,
+    &descriptor_table_elasticcdc_2eproto_once, nullptr, 0, 3,
     schemas, file_default_instances, TableStruct_elasticcdc_2eproto::offsets,
     file_level_metadata_elasticcdc_2eproto, file_level_enum_descriptors_elasticcdc_2eproto,
     file_level_service_descriptors_elasticcdc_2eproto,
@@ -154,11 +226,38 @@ PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_elasticc
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_elasticcdc_2eproto(&descriptor_table_elasticcdc_2eproto);
 namespace elasticcdc {
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* ElasticcdcRequest_OutputMode_descriptor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&descriptor_table_elasticcdc_2eproto);
+  return file_level_enum_descriptors_elasticcdc_2eproto[0];
+}
+bool ElasticcdcRequest_OutputMode_IsValid(int value) {
+  switch (value) {
+    case 0:
+    case 1:
+    case 2:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#if (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest::FULL;
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest::TOPK;
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest::RETAIN;
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest::OutputMode_MIN;
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest::OutputMode_MAX;
+constexpr int ElasticcdcRequest::OutputMode_ARRAYSIZE;
+#endif  // (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
 
 // ===================================================================
 
 class ElasticcdcRequest::_Internal {
  public:
+  using HasBits = decltype(std::declval<ElasticcdcRequest>()._impl_._has_bits_);
+  static void set_has_deadline_ms(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
 };
 
 ElasticcdcRequest::ElasticcdcRequest(::PROTOBUF_NAMESPACE_ID::Arena* arena,
@@ -171,7 +270,11 @@ ElasticcdcRequest::ElasticcdcRequest(const ElasticcdcRequest& from)
   : ::PROTOBUF_NAMESPACE_ID::Message() {
   ElasticcdcRequest* const _this = this; (void)_this;
   new (&_impl_) Impl_{
-      decltype(_impl_.name_){}
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.feature_ids_){from._impl_.feature_ids_}
+    , /*decltype(_impl_._feature_ids_cached_byte_size_)*/{0}
+    , decltype(_impl_.name_){}
     , decltype(_impl_.image_classify_request_info_){}
     , decltype(_impl_.model_name_){}
     , decltype(_impl_.scale_){}
@@ -186,9 +289,12 @@ ElasticcdcRequest::ElasticcdcRequest(const ElasticcdcRequest& from)
     , decltype(_impl_.cdc_infer_time_){}
     , decltype(_impl_.backup_infer_time_){}
     , decltype(_impl_.decode_time_){}
+    , decltype(_impl_.deadline_ms_){}
     , decltype(_impl_.end_signal_){}
     , decltype(_impl_.recompute_){}
-    , /*decltype(_impl_._cached_size_)*/{}};
+    , decltype(_impl_.compressed_){}
+    , decltype(_impl_.output_mode_){}
+    , decltype(_impl_.top_k_){}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
   _impl_.name_.InitDefault();
@@ -248,8 +354,8 @@ ElasticcdcRequest::ElasticcdcRequest(const ElasticcdcRequest& from)
       _this->GetArenaForAllocation());
   }
   ::memcpy(&_impl_.id_, &from._impl_.id_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.recompute_) -
-    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.recompute_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.top_k_) -
+    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.top_k_));
   // @@protoc_insertion_point(copy_constructor:elasticcdc.ElasticcdcRequest)
 }
 
@@ -258,7 +364,11 @@ inline void ElasticcdcRequest::SharedCtor(
   (void)arena;
   (void)is_message_owned;
   new (&_impl_) Impl_{
-      decltype(_impl_.name_){}
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.feature_ids_){arena}
+    , /*decltype(_impl_._feature_ids_cached_byte_size_)*/{0}
+    , decltype(_impl_.name_){}
     , decltype(_impl_.image_classify_request_info_){}
     , decltype(_impl_.model_name_){}
     , decltype(_impl_.scale_){}
@@ -273,9 +383,12 @@ inline void ElasticcdcRequest::SharedCtor(
     , decltype(_impl_.cdc_infer_time_){0}
     , decltype(_impl_.backup_infer_time_){0}
     , decltype(_impl_.decode_time_){0}
+    , decltype(_impl_.deadline_ms_){0}
     , decltype(_impl_.end_signal_){false}
     , decltype(_impl_.recompute_){false}
-    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.compressed_){false}
+    , decltype(_impl_.output_mode_){0}
+    , decltype(_impl_.top_k_){0u}
   };
   _impl_.name_.InitDefault();
   #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
@@ -318,6 +431,7 @@ ElasticcdcRequest::~ElasticcdcRequest() {
 
 inline void ElasticcdcRequest::SharedDtor() {
   GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.feature_ids_.~RepeatedField();
   _impl_.name_.Destroy();
   _impl_.image_classify_request_info_.Destroy();
   _impl_.model_name_.Destroy();
@@ -337,6 +451,7 @@ void ElasticcdcRequest::Clear() {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  _impl_.feature_ids_.Clear();
   _impl_.name_.ClearToEmpty();
   _impl_.image_classify_request_info_.ClearToEmpty();
   _impl_.model_name_.ClearToEmpty();
@@ -345,13 +460,19 @@ void ElasticcdcRequest::Clear() {
   _impl_.data_.ClearToEmpty();
   _impl_.encode_type_.ClearToEmpty();
   ::memset(&_impl_.id_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.recompute_) -
-      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.recompute_));
+      reinterpret_cast<char*>(&_impl_.decode_time_) -
+      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.decode_time_));
+  _impl_.deadline_ms_ = 0;
+  ::memset(&_impl_.end_signal_, 0, static_cast<size_t>(
+      reinterpret_cast<char*>(&_impl_.top_k_) -
+      reinterpret_cast<char*>(&_impl_.end_signal_)) + sizeof(_impl_.top_k_));
+  _impl_._has_bits_.Clear();
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
 const char* ElasticcdcRequest::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
 #define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
   while (!ctx->Done(&ptr)) {
     uint32_t tag;
     ptr = ::_pbi::ReadTag(ptr, &tag);
@@ -505,6 +626,51 @@ const char* ElasticcdcRequest::_InternalParse(const char* ptr, ::_pbi::ParseCont
         } else
           goto handle_unusual;
         continue;
+      // optional double deadline_ms = 18;
+      case 18:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 145)) {
+          _Internal::set_has_deadline_ms(&has_bits);
+          _impl_.deadline_ms_ = ::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<double>(ptr);
+          ptr += sizeof(double);
+        } else
+          goto handle_unusual;
+        continue;
+      // .elasticcdc.ElasticcdcRequest.OutputMode output_mode = 19;
+      case 19:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 152)) {
+          uint64_t val = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+          _internal_set_output_mode(static_cast<::elasticcdc::ElasticcdcRequest_OutputMode>(val));
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 top_k = 20;
+      case 20:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 160)) {
+          _impl_.top_k_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // repeated int64 feature_ids = 21;
+      case 21:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 170)) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::PackedInt64Parser(_internal_mutable_feature_ids(), ptr, ctx);
+          CHK_(ptr);
+        } else if (static_cast<uint8_t>(tag) == 168) {
+          _internal_add_feature_ids(::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr));
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // bool compressed = 22;
+      case 22:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 176)) {
+          _impl_.compressed_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -521,6 +687,7 @@ const char* ElasticcdcRequest::_InternalParse(const char* ptr, ::_pbi::ParseCont
     CHK_(ptr != nullptr);
   }  // while
 message_done:
+  _impl_._has_bits_.Or(has_bits);
   return ptr;
 failure:
   ptr = nullptr;
@@ -672,6 +839,40 @@ uint8_t* ElasticcdcRequest::_InternalSerialize(
     target = ::_pbi::WireFormatLite::WriteBoolToArray(17, this->_internal_recompute(), target);
   }
 
+  // optional double deadline_ms = 18;
+  if (_internal_has_deadline_ms()) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteDoubleToArray(18, this->_internal_deadline_ms(), target);
+  }
+
+  // .elasticcdc.ElasticcdcRequest.OutputMode output_mode = 19;
+  if (this->_internal_output_mode() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteEnumToArray(
+      19, this->_internal_output_mode(), target);
+  }
+
+  // uint32 top_k = 20;
+  if (this->_internal_top_k() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(20, this->_internal_top_k(), target);
+  }
+
+  // repeated int64 feature_ids = 21;
+  {
+    int byte_size = _impl_._feature_ids_cached_byte_size_.load(std::memory_order_relaxed);
+    if (byte_size > 0) {
+      target = stream->WriteInt64Packed(
+          21, _internal_feature_ids(), byte_size, target);
+    }
+  }
+
+  // bool compressed = 22;
+  if (this->_internal_compressed() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(22, this->_internal_compressed(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -688,6 +889,20 @@ size_t ElasticcdcRequest::ByteSizeLong() const {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  // repeated int64 feature_ids = 21;
+  {
+    size_t data_size = ::_pbi::WireFormatLite::
+      Int64Size(this->_impl_.feature_ids_);
+    if (data_size > 0) {
+      total_size += 2 +
+        ::_pbi::WireFormatLite::Int32Size(static_cast<int32_t>(data_size));
+    }
+    int cached_size = ::_pbi::ToCachedSize(data_size);
+    _impl_._feature_ids_cached_byte_size_.store(cached_size,
+                                    std::memory_order_relaxed);
+    total_size += data_size;
+  }
+
   // string name = 1;
   if (!this->_internal_name().empty()) {
     total_size += 1 +
@@ -789,6 +1004,12 @@ size_t ElasticcdcRequest::ByteSizeLong() const {
     total_size += 1 + 8;
   }
 
+  // optional double deadline_ms = 18;
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000001u) {
+    total_size += 2 + 8;
+  }
+
   // bool end_signal = 16;
   if (this->_internal_end_signal() != 0) {
     total_size += 2 + 1;
@@ -799,6 +1020,24 @@ size_t ElasticcdcRequest::ByteSizeLong() const {
     total_size += 2 + 1;
   }
 
+  // bool compressed = 22;
+  if (this->_internal_compressed() != 0) {
+    total_size += 2 + 1;
+  }
+
+  // .elasticcdc.ElasticcdcRequest.OutputMode output_mode = 19;
+  if (this->_internal_output_mode() != 0) {
+    total_size += 2 +
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_output_mode());
+  }
+
+  // uint32 top_k = 20;
+  if (this->_internal_top_k() != 0) {
+    total_size += 2 +
+      ::_pbi::WireFormatLite::UInt32Size(
+        this->_internal_top_k());
+  }
+
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -817,6 +1056,7 @@ void ElasticcdcRequest::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, cons
   uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
+  _this->_impl_.feature_ids_.MergeFrom(from._impl_.feature_ids_);
   if (!from._internal_name().empty()) {
     _this->_internal_set_name(from._internal_name());
   }
@@ -874,12 +1114,24 @@ void ElasticcdcRequest::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, cons
   if (raw_decode_time != 0) {
     _this->_internal_set_decode_time(from._internal_decode_time());
   }
+  if (from._internal_has_deadline_ms()) {
+    _this->_internal_set_deadline_ms(from._internal_deadline_ms());
+  }
   if (from._internal_end_signal() != 0) {
     _this->_internal_set_end_signal(from._internal_end_signal());
   }
   if (from._internal_recompute() != 0) {
     _this->_internal_set_recompute(from._internal_recompute());
   }
+  if (from._internal_compressed() != 0) {
+    _this->_internal_set_compressed(from._internal_compressed());
+  }
+  if (from._internal_output_mode() != 0) {
+    _this->_internal_set_output_mode(from._internal_output_mode());
+  }
+  if (from._internal_top_k() != 0) {
+    _this->_internal_set_top_k(from._internal_top_k());
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -899,6 +1151,8 @@ void ElasticcdcRequest::InternalSwap(ElasticcdcRequest* other) {
   auto* lhs_arena = GetArenaForAllocation();
   auto* rhs_arena = other->GetArenaForAllocation();
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  _impl_.feature_ids_.InternalSwap(&other->_impl_.feature_ids_);
   ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
       &_impl_.name_, lhs_arena,
       &other->_impl_.name_, rhs_arena
@@ -928,8 +1182,8 @@ void ElasticcdcRequest::InternalSwap(ElasticcdcRequest* other) {
       &other->_impl_.encode_type_, rhs_arena
   );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(ElasticcdcRequest, _impl_.recompute_)
-      + sizeof(ElasticcdcRequest::_impl_.recompute_)
+      PROTOBUF_FIELD_OFFSET(ElasticcdcRequest, _impl_.top_k_)
+      + sizeof(ElasticcdcRequest::_impl_.top_k_)
       - PROTOBUF_FIELD_OFFSET(ElasticcdcRequest, _impl_.id_)>(
           reinterpret_cast<char*>(&_impl_.id_),
           reinterpret_cast<char*>(&other->_impl_.id_));
@@ -943,6 +1197,231 @@ void ElasticcdcRequest::InternalSwap(ElasticcdcRequest* other) {
 
 // ===================================================================
 
+class RetainedFeature::_Internal {
+ public:
+};
+
+RetainedFeature::RetainedFeature(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:elasticcdc.RetainedFeature)
+}
+RetainedFeature::RetainedFeature(const RetainedFeature& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  RetainedFeature* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_.data_){}
+    , decltype(_impl_.id_){}
+    , /*decltype(_impl_._cached_size_)*/{}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (!from._internal_data().empty()) {
+    _this->_impl_.data_.Set(from._internal_data(), 
+      _this->GetArenaForAllocation());
+  }
+  _this->_impl_.id_ = from._impl_.id_;
+  // @@protoc_insertion_point(copy_constructor:elasticcdc.RetainedFeature)
+}
+
+inline void RetainedFeature::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_.data_){}
+    , decltype(_impl_.id_){int64_t{0}}
+    , /*decltype(_impl_._cached_size_)*/{}
+  };
+  _impl_.data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+}
+
+RetainedFeature::~RetainedFeature() {
+  // @@protoc_insertion_point(destructor:elasticcdc.RetainedFeature)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void RetainedFeature::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.data_.Destroy();
+}
+
+void RetainedFeature::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void RetainedFeature::Clear() {
+// @@protoc_insertion_point(message_clear_start:elasticcdc.RetainedFeature)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.data_.ClearToEmpty();
+  _impl_.id_ = int64_t{0};
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* RetainedFeature::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // int64 id = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _impl_.id_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // bytes data = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 18)) {
+          auto str = _internal_mutable_data();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* RetainedFeature::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:elasticcdc.RetainedFeature)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // int64 id = 1;
+  if (this->_internal_id() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt64ToArray(1, this->_internal_id(), target);
+  }
+
+  // bytes data = 2;
+  if (!this->_internal_data().empty()) {
+    target = stream->WriteBytesMaybeAliased(
+        2, this->_internal_data(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:elasticcdc.RetainedFeature)
+  return target;
+}
+
+size_t RetainedFeature::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:elasticcdc.RetainedFeature)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // bytes data = 2;
+  if (!this->_internal_data().empty()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+        this->_internal_data());
+  }
+
+  // int64 id = 1;
+  if (this->_internal_id() != 0) {
+    total_size += ::_pbi::WireFormatLite::Int64SizePlusOne(this->_internal_id());
+  }
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData RetainedFeature::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    RetainedFeature::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*RetainedFeature::GetClassData() const { return &_class_data_; }
+
+
+void RetainedFeature::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<RetainedFeature*>(&to_msg);
+  auto& from = static_cast<const RetainedFeature&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:elasticcdc.RetainedFeature)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  if (!from._internal_data().empty()) {
+    _this->_internal_set_data(from._internal_data());
+  }
+  if (from._internal_id() != 0) {
+    _this->_internal_set_id(from._internal_id());
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void RetainedFeature::CopyFrom(const RetainedFeature& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:elasticcdc.RetainedFeature)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool RetainedFeature::IsInitialized() const {
+  return true;
+}
+
+void RetainedFeature::InternalSwap(RetainedFeature* other) {
+  using std::swap;
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.data_, lhs_arena,
+      &other->_impl_.data_, rhs_arena
+  );
+  swap(_impl_.id_, other->_impl_.id_);
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata RetainedFeature::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_elasticcdc_2eproto_getter, &descriptor_table_elasticcdc_2eproto_once,
+      file_level_metadata_elasticcdc_2eproto[1]);
+}
+
+// ===================================================================
+
 class ElasticcdcReply::_Internal {
  public:
 };
@@ -957,11 +1436,13 @@ ElasticcdcReply::ElasticcdcReply(const ElasticcdcReply& from)
   : ::PROTOBUF_NAMESPACE_ID::Message() {
   ElasticcdcReply* const _this = this; (void)_this;
   new (&_impl_) Impl_{
-      decltype(_impl_.message_){}
+      decltype(_impl_.features_){from._impl_.features_}
+    , decltype(_impl_.message_){}
     , decltype(_impl_.image_classify_reply_info_){}
     , decltype(_impl_.reply_info_){}
     , decltype(_impl_.id_){}
     , decltype(_impl_.recompute_){}
+    , decltype(_impl_.rejected_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
@@ -990,8 +1471,8 @@ ElasticcdcReply::ElasticcdcReply(const ElasticcdcReply& from)
       _this->GetArenaForAllocation());
   }
   ::memcpy(&_impl_.id_, &from._impl_.id_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.recompute_) -
-    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.recompute_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.rejected_) -
+    reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.rejected_));
   // @@protoc_insertion_point(copy_constructor:elasticcdc.ElasticcdcReply)
 }
 
@@ -1000,11 +1481,13 @@ inline void ElasticcdcReply::SharedCtor(
   (void)arena;
   (void)is_message_owned;
   new (&_impl_) Impl_{
-      decltype(_impl_.message_){}
+      decltype(_impl_.features_){arena}
+    , decltype(_impl_.message_){}
     , decltype(_impl_.image_classify_reply_info_){}
     , decltype(_impl_.reply_info_){}
     , decltype(_impl_.id_){int64_t{0}}
     , decltype(_impl_.recompute_){false}
+    , decltype(_impl_.rejected_){false}
     , /*decltype(_impl_._cached_size_)*/{}
   };
   _impl_.message_.InitDefault();
@@ -1032,6 +1515,7 @@ ElasticcdcReply::~ElasticcdcReply() {
 
 inline void ElasticcdcReply::SharedDtor() {
   GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.features_.~RepeatedPtrField();
   _impl_.message_.Destroy();
   _impl_.image_classify_reply_info_.Destroy();
   _impl_.reply_info_.Destroy();
@@ -1047,12 +1531,13 @@ void ElasticcdcReply::Clear() {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  _impl_.features_.Clear();
   _impl_.message_.ClearToEmpty();
   _impl_.image_classify_reply_info_.ClearToEmpty();
   _impl_.reply_info_.ClearToEmpty();
   ::memset(&_impl_.id_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.recompute_) -
-      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.recompute_));
+      reinterpret_cast<char*>(&_impl_.rejected_) -
+      reinterpret_cast<char*>(&_impl_.id_)) + sizeof(_impl_.rejected_));
   _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
@@ -1107,6 +1592,27 @@ const char* ElasticcdcReply::_InternalParse(const char* ptr, ::_pbi::ParseContex
         } else
           goto handle_unusual;
         continue;
+      // repeated .elasticcdc.RetainedFeature features = 6;
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 50)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            ptr = ctx->ParseMessage(_internal_add_features(), ptr);
+            CHK_(ptr);
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<50>(ptr));
+        } else
+          goto handle_unusual;
+        continue;
+      // bool rejected = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _impl_.rejected_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -1174,6 +1680,20 @@ uint8_t* ElasticcdcReply::_InternalSerialize(
     target = ::_pbi::WireFormatLite::WriteBoolToArray(5, this->_internal_recompute(), target);
   }
 
+  // repeated .elasticcdc.RetainedFeature features = 6;
+  for (unsigned i = 0,
+      n = static_cast<unsigned>(this->_internal_features_size()); i < n; i++) {
+    const auto& repfield = this->_internal_features(i);
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+        InternalWriteMessage(6, repfield, repfield.GetCachedSize(), target, stream);
+  }
+
+  // bool rejected = 7;
+  if (this->_internal_rejected() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(7, this->_internal_rejected(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
@@ -1190,6 +1710,13 @@ size_t ElasticcdcReply::ByteSizeLong() const {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  // repeated .elasticcdc.RetainedFeature features = 6;
+  total_size += 1UL * this->_internal_features_size();
+  for (const auto& msg : this->_impl_.features_) {
+    total_size +=
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(msg);
+  }
+
   // string message = 1;
   if (!this->_internal_message().empty()) {
     total_size += 1 +
@@ -1221,6 +1748,11 @@ size_t ElasticcdcReply::ByteSizeLong() const {
     total_size += 1 + 1;
   }
 
+  // bool rejected = 7;
+  if (this->_internal_rejected() != 0) {
+    total_size += 1 + 1;
+  }
+
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -1239,6 +1771,7 @@ void ElasticcdcReply::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const
   uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
+  _this->_impl_.features_.MergeFrom(from._impl_.features_);
   if (!from._internal_message().empty()) {
     _this->_internal_set_message(from._internal_message());
   }
@@ -1254,6 +1787,9 @@ void ElasticcdcReply::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const
   if (from._internal_recompute() != 0) {
     _this->_internal_set_recompute(from._internal_recompute());
   }
+  if (from._internal_rejected() != 0) {
+    _this->_internal_set_rejected(from._internal_rejected());
+  }
   _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
@@ -1273,6 +1809,7 @@ void ElasticcdcReply::InternalSwap(ElasticcdcReply* other) {
   auto* lhs_arena = GetArenaForAllocation();
   auto* rhs_arena = other->GetArenaForAllocation();
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  _impl_.features_.InternalSwap(&other->_impl_.features_);
   ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
       &_impl_.message_, lhs_arena,
       &other->_impl_.message_, rhs_arena
@@ -1286,8 +1823,8 @@ void ElasticcdcReply::InternalSwap(ElasticcdcReply* other) {
       &other->_impl_.reply_info_, rhs_arena
   );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(ElasticcdcReply, _impl_.recompute_)
-      + sizeof(ElasticcdcReply::_impl_.recompute_)
+      PROTOBUF_FIELD_OFFSET(ElasticcdcReply, _impl_.rejected_)
+      + sizeof(ElasticcdcReply::_impl_.rejected_)
       - PROTOBUF_FIELD_OFFSET(ElasticcdcReply, _impl_.id_)>(
           reinterpret_cast<char*>(&_impl_.id_),
           reinterpret_cast<char*>(&other->_impl_.id_));
@@ -1296,7 +1833,7 @@ void ElasticcdcReply::InternalSwap(ElasticcdcReply* other) {
 ::PROTOBUF_NAMESPACE_ID::Metadata ElasticcdcReply::GetMetadata() const {
   return ::_pbi::AssignDescriptors(
       &descriptor_table_elasticcdc_2eproto_getter, &descriptor_table_elasticcdc_2eproto_once,
-      file_level_metadata_elasticcdc_2eproto[1]);
+      file_level_metadata_elasticcdc_2eproto[2]);
 }
 
 // @@protoc_insertion_point(namespace_scope)
@@ -1306,6 +1843,10 @@ template<> PROTOBUF_NOINLINE ::elasticcdc::ElasticcdcRequest*
 Arena::CreateMaybeMessage< ::elasticcdc::ElasticcdcRequest >(Arena* arena) {
   return Arena::CreateMessageInternal< ::elasticcdc::ElasticcdcRequest >(arena);
 }
+template<> PROTOBUF_NOINLINE ::elasticcdc::RetainedFeature*
+Arena::CreateMaybeMessage< ::elasticcdc::RetainedFeature >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::elasticcdc::RetainedFeature >(arena);
+}
 template<> PROTOBUF_NOINLINE ::elasticcdc::ElasticcdcReply*
 Arena::CreateMaybeMessage< ::elasticcdc::ElasticcdcReply >(Arena* arena) {
   return Arena::CreateMessageInternal< ::elasticcdc::ElasticcdcReply >(arena);
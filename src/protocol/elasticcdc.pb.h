@@ -29,6 +29,7 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>  // IWYU pragma: export
 #include <google/protobuf/extension_set.h>  // IWYU pragma: export
+#include <google/protobuf/generated_enum_reflection.h>
 #include <google/protobuf/unknown_field_set.h>
 // @@protoc_insertion_point(includes)
 #include <google/protobuf/port_def.inc>
@@ -51,13 +52,43 @@ extern ElasticcdcReplyDefaultTypeInternal _ElasticcdcReply_default_instance_;
 class ElasticcdcRequest;
 struct ElasticcdcRequestDefaultTypeInternal;
 extern ElasticcdcRequestDefaultTypeInternal _ElasticcdcRequest_default_instance_;
+class RetainedFeature;
+struct RetainedFeatureDefaultTypeInternal;
+extern RetainedFeatureDefaultTypeInternal _RetainedFeature_default_instance_;
 }  // namespace elasticcdc
 PROTOBUF_NAMESPACE_OPEN
 template<> ::elasticcdc::ElasticcdcReply* Arena::CreateMaybeMessage<::elasticcdc::ElasticcdcReply>(Arena*);
 template<> ::elasticcdc::ElasticcdcRequest* Arena::CreateMaybeMessage<::elasticcdc::ElasticcdcRequest>(Arena*);
+template<> ::elasticcdc::RetainedFeature* Arena::CreateMaybeMessage<::elasticcdc::RetainedFeature>(Arena*);
 PROTOBUF_NAMESPACE_CLOSE
 namespace elasticcdc {
 
+enum ElasticcdcRequest_OutputMode : int {
+  ElasticcdcRequest_OutputMode_FULL = 0,
+  ElasticcdcRequest_OutputMode_TOPK = 1,
+  ElasticcdcRequest_OutputMode_RETAIN = 2,
+  ElasticcdcRequest_OutputMode_ElasticcdcRequest_OutputMode_INT_MIN_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::min(),
+  ElasticcdcRequest_OutputMode_ElasticcdcRequest_OutputMode_INT_MAX_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::max()
+};
+bool ElasticcdcRequest_OutputMode_IsValid(int value);
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest_OutputMode_OutputMode_MIN = ElasticcdcRequest_OutputMode_FULL;
+constexpr ElasticcdcRequest_OutputMode ElasticcdcRequest_OutputMode_OutputMode_MAX = ElasticcdcRequest_OutputMode_RETAIN;
+constexpr int ElasticcdcRequest_OutputMode_OutputMode_ARRAYSIZE = ElasticcdcRequest_OutputMode_OutputMode_MAX + 1;
+
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* ElasticcdcRequest_OutputMode_descriptor();
+template<typename T>
+inline const std::string& ElasticcdcRequest_OutputMode_Name(T enum_t_value) {
+  static_assert(::std::is_same<T, ElasticcdcRequest_OutputMode>::value ||
+    ::std::is_integral<T>::value,
+    "Incorrect type passed to function ElasticcdcRequest_OutputMode_Name.");
+  return ::PROTOBUF_NAMESPACE_ID::internal::NameOfEnum(
+    ElasticcdcRequest_OutputMode_descriptor(), enum_t_value);
+}
+inline bool ElasticcdcRequest_OutputMode_Parse(
+    ::PROTOBUF_NAMESPACE_ID::ConstStringParam name, ElasticcdcRequest_OutputMode* value) {
+  return ::PROTOBUF_NAMESPACE_ID::internal::ParseNamedEnum<ElasticcdcRequest_OutputMode>(
+    ElasticcdcRequest_OutputMode_descriptor(), name, value);
+}
 // ===================================================================
 
 class ElasticcdcRequest final :
@@ -178,9 +209,42 @@ class ElasticcdcRequest final :
 
   // nested types ----------------------------------------------------
 
+  typedef ElasticcdcRequest_OutputMode OutputMode;
+  static constexpr OutputMode FULL =
+    ElasticcdcRequest_OutputMode_FULL;
+  static constexpr OutputMode TOPK =
+    ElasticcdcRequest_OutputMode_TOPK;
+  static constexpr OutputMode RETAIN =
+    ElasticcdcRequest_OutputMode_RETAIN;
+  static inline bool OutputMode_IsValid(int value) {
+    return ElasticcdcRequest_OutputMode_IsValid(value);
+  }
+  static constexpr OutputMode OutputMode_MIN =
+    ElasticcdcRequest_OutputMode_OutputMode_MIN;
+  static constexpr OutputMode OutputMode_MAX =
+    ElasticcdcRequest_OutputMode_OutputMode_MAX;
+  static constexpr int OutputMode_ARRAYSIZE =
+    ElasticcdcRequest_OutputMode_OutputMode_ARRAYSIZE;
+  static inline const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor*
+  OutputMode_descriptor() {
+    return ElasticcdcRequest_OutputMode_descriptor();
+  }
+  template<typename T>
+  static inline const std::string& OutputMode_Name(T enum_t_value) {
+    static_assert(::std::is_same<T, OutputMode>::value ||
+      ::std::is_integral<T>::value,
+      "Incorrect type passed to function OutputMode_Name.");
+    return ElasticcdcRequest_OutputMode_Name(enum_t_value);
+  }
+  static inline bool OutputMode_Parse(::PROTOBUF_NAMESPACE_ID::ConstStringParam name,
+      OutputMode* value) {
+    return ElasticcdcRequest_OutputMode_Parse(name, value);
+  }
+
   // accessors -------------------------------------------------------
 
   enum : int {
+    kFeatureIdsFieldNumber = 21,
     kNameFieldNumber = 1,
     kImageClassifyRequestInfoFieldNumber = 2,
     kModelNameFieldNumber = 3,
@@ -196,9 +260,35 @@ class ElasticcdcRequest final :
     kCdcInferTimeFieldNumber = 13,
     kBackupInferTimeFieldNumber = 14,
     kDecodeTimeFieldNumber = 15,
+    kDeadlineMsFieldNumber = 18,
     kEndSignalFieldNumber = 16,
     kRecomputeFieldNumber = 17,
+    kCompressedFieldNumber = 22,
+    kOutputModeFieldNumber = 19,
+    kTopKFieldNumber = 20,
   };
+  // repeated int64 feature_ids = 21;
+  int feature_ids_size() const;
+  private:
+  int _internal_feature_ids_size() const;
+  public:
+  void clear_feature_ids();
+  private:
+  int64_t _internal_feature_ids(int index) const;
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >&
+      _internal_feature_ids() const;
+  void _internal_add_feature_ids(int64_t value);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >*
+      _internal_mutable_feature_ids();
+  public:
+  int64_t feature_ids(int index) const;
+  void set_feature_ids(int index, int64_t value);
+  void add_feature_ids(int64_t value);
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >&
+      feature_ids() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >*
+      mutable_feature_ids();
+
   // string name = 1;
   void clear_name();
   const std::string& name() const;
@@ -369,6 +459,19 @@ class ElasticcdcRequest final :
   void _internal_set_decode_time(double value);
   public:
 
+  // optional double deadline_ms = 18;
+  bool has_deadline_ms() const;
+  private:
+  bool _internal_has_deadline_ms() const;
+  public:
+  void clear_deadline_ms();
+  double deadline_ms() const;
+  void set_deadline_ms(double value);
+  private:
+  double _internal_deadline_ms() const;
+  void _internal_set_deadline_ms(double value);
+  public:
+
   // bool end_signal = 16;
   void clear_end_signal();
   bool end_signal() const;
@@ -387,6 +490,33 @@ class ElasticcdcRequest final :
   void _internal_set_recompute(bool value);
   public:
 
+  // bool compressed = 22;
+  void clear_compressed();
+  bool compressed() const;
+  void set_compressed(bool value);
+  private:
+  bool _internal_compressed() const;
+  void _internal_set_compressed(bool value);
+  public:
+
+  // .elasticcdc.ElasticcdcRequest.OutputMode output_mode = 19;
+  void clear_output_mode();
+  ::elasticcdc::ElasticcdcRequest_OutputMode output_mode() const;
+  void set_output_mode(::elasticcdc::ElasticcdcRequest_OutputMode value);
+  private:
+  ::elasticcdc::ElasticcdcRequest_OutputMode _internal_output_mode() const;
+  void _internal_set_output_mode(::elasticcdc::ElasticcdcRequest_OutputMode value);
+  public:
+
+  // uint32 top_k = 20;
+  void clear_top_k();
+  uint32_t top_k() const;
+  void set_top_k(uint32_t value);
+  private:
+  uint32_t _internal_top_k() const;
+  void _internal_set_top_k(uint32_t value);
+  public:
+
   // @@protoc_insertion_point(class_scope:elasticcdc.ElasticcdcRequest)
  private:
   class _Internal;
@@ -395,6 +525,10 @@ class ElasticcdcRequest final :
   typedef void InternalArenaConstructable_;
   typedef void DestructorSkippable_;
   struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t > feature_ids_;
+    mutable std::atomic<int> _feature_ids_cached_byte_size_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr name_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr image_classify_request_info_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr model_name_;
@@ -410,8 +544,175 @@ class ElasticcdcRequest final :
     double cdc_infer_time_;
     double backup_infer_time_;
     double decode_time_;
+    double deadline_ms_;
     bool end_signal_;
     bool recompute_;
+    bool compressed_;
+    int output_mode_;
+    uint32_t top_k_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_elasticcdc_2eproto;
+};
+// -------------------------------------------------------------------
+
+class RetainedFeature final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:elasticcdc.RetainedFeature) */ {
+ public:
+  inline RetainedFeature() : RetainedFeature(nullptr) {}
+  ~RetainedFeature() override;
+  explicit PROTOBUF_CONSTEXPR RetainedFeature(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  RetainedFeature(const RetainedFeature& from);
+  RetainedFeature(RetainedFeature&& from) noexcept
+    : RetainedFeature() {
+    *this = ::std::move(from);
+  }
+
+  inline RetainedFeature& operator=(const RetainedFeature& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline RetainedFeature& operator=(RetainedFeature&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const RetainedFeature& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const RetainedFeature* internal_default_instance() {
+    return reinterpret_cast<const RetainedFeature*>(
+               &_RetainedFeature_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    1;
+
+  friend void swap(RetainedFeature& a, RetainedFeature& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(RetainedFeature* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(RetainedFeature* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  RetainedFeature* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<RetainedFeature>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const RetainedFeature& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const RetainedFeature& from) {
+    RetainedFeature::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(RetainedFeature* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "elasticcdc.RetainedFeature";
+  }
+  protected:
+  explicit RetainedFeature(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kDataFieldNumber = 2,
+    kIdFieldNumber = 1,
+  };
+  // bytes data = 2;
+  void clear_data();
+  const std::string& data() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_data(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_data();
+  PROTOBUF_NODISCARD std::string* release_data();
+  void set_allocated_data(std::string* data);
+  private:
+  const std::string& _internal_data() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_data(const std::string& value);
+  std::string* _internal_mutable_data();
+  public:
+
+  // int64 id = 1;
+  void clear_id();
+  int64_t id() const;
+  void set_id(int64_t value);
+  private:
+  int64_t _internal_id() const;
+  void _internal_set_id(int64_t value);
+  public:
+
+  // @@protoc_insertion_point(class_scope:elasticcdc.RetainedFeature)
+ private:
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr data_;
+    int64_t id_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -467,7 +768,7 @@ class ElasticcdcReply final :
                &_ElasticcdcReply_default_instance_);
   }
   static constexpr int kIndexInFileMessages =
-    1;
+    2;
 
   friend void swap(ElasticcdcReply& a, ElasticcdcReply& b) {
     a.Swap(&b);
@@ -540,12 +841,32 @@ class ElasticcdcReply final :
   // accessors -------------------------------------------------------
 
   enum : int {
+    kFeaturesFieldNumber = 6,
     kMessageFieldNumber = 1,
     kImageClassifyReplyInfoFieldNumber = 2,
     kReplyInfoFieldNumber = 3,
     kIdFieldNumber = 4,
     kRecomputeFieldNumber = 5,
+    kRejectedFieldNumber = 7,
   };
+  // repeated .elasticcdc.RetainedFeature features = 6;
+  int features_size() const;
+  private:
+  int _internal_features_size() const;
+  public:
+  void clear_features();
+  ::elasticcdc::RetainedFeature* mutable_features(int index);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::elasticcdc::RetainedFeature >*
+      mutable_features();
+  private:
+  const ::elasticcdc::RetainedFeature& _internal_features(int index) const;
+  ::elasticcdc::RetainedFeature* _internal_add_features();
+  public:
+  const ::elasticcdc::RetainedFeature& features(int index) const;
+  ::elasticcdc::RetainedFeature* add_features();
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::elasticcdc::RetainedFeature >&
+      features() const;
+
   // string message = 1;
   void clear_message();
   const std::string& message() const;
@@ -606,6 +927,15 @@ class ElasticcdcReply final :
   void _internal_set_recompute(bool value);
   public:
 
+  // bool rejected = 7;
+  void clear_rejected();
+  bool rejected() const;
+  void set_rejected(bool value);
+  private:
+  bool _internal_rejected() const;
+  void _internal_set_rejected(bool value);
+  public:
+
   // @@protoc_insertion_point(class_scope:elasticcdc.ElasticcdcReply)
  private:
   class _Internal;
@@ -614,11 +944,13 @@ class ElasticcdcReply final :
   typedef void InternalArenaConstructable_;
   typedef void DestructorSkippable_;
   struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::elasticcdc::RetainedFeature > features_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr message_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr image_classify_reply_info_;
     ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr reply_info_;
     int64_t id_;
     bool recompute_;
+    bool rejected_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -1185,6 +1517,215 @@ inline void ElasticcdcRequest::set_recompute(bool value) {
   // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.recompute)
 }
 
+// optional double deadline_ms = 18;
+inline bool ElasticcdcRequest::_internal_has_deadline_ms() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool ElasticcdcRequest::has_deadline_ms() const {
+  return _internal_has_deadline_ms();
+}
+inline void ElasticcdcRequest::clear_deadline_ms() {
+  _impl_.deadline_ms_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline double ElasticcdcRequest::_internal_deadline_ms() const {
+  return _impl_.deadline_ms_;
+}
+inline double ElasticcdcRequest::deadline_ms() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcRequest.deadline_ms)
+  return _internal_deadline_ms();
+}
+inline void ElasticcdcRequest::_internal_set_deadline_ms(double value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.deadline_ms_ = value;
+}
+inline void ElasticcdcRequest::set_deadline_ms(double value) {
+  _internal_set_deadline_ms(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.deadline_ms)
+}
+
+// .elasticcdc.ElasticcdcRequest.OutputMode output_mode = 19;
+inline void ElasticcdcRequest::clear_output_mode() {
+  _impl_.output_mode_ = 0;
+}
+inline ::elasticcdc::ElasticcdcRequest_OutputMode ElasticcdcRequest::_internal_output_mode() const {
+  return static_cast< ::elasticcdc::ElasticcdcRequest_OutputMode >(_impl_.output_mode_);
+}
+inline ::elasticcdc::ElasticcdcRequest_OutputMode ElasticcdcRequest::output_mode() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcRequest.output_mode)
+  return _internal_output_mode();
+}
+inline void ElasticcdcRequest::_internal_set_output_mode(::elasticcdc::ElasticcdcRequest_OutputMode value) {
+  
+  _impl_.output_mode_ = value;
+}
+inline void ElasticcdcRequest::set_output_mode(::elasticcdc::ElasticcdcRequest_OutputMode value) {
+  _internal_set_output_mode(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.output_mode)
+}
+
+// uint32 top_k = 20;
+inline void ElasticcdcRequest::clear_top_k() {
+  _impl_.top_k_ = 0u;
+}
+inline uint32_t ElasticcdcRequest::_internal_top_k() const {
+  return _impl_.top_k_;
+}
+inline uint32_t ElasticcdcRequest::top_k() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcRequest.top_k)
+  return _internal_top_k();
+}
+inline void ElasticcdcRequest::_internal_set_top_k(uint32_t value) {
+  
+  _impl_.top_k_ = value;
+}
+inline void ElasticcdcRequest::set_top_k(uint32_t value) {
+  _internal_set_top_k(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.top_k)
+}
+
+// repeated int64 feature_ids = 21;
+inline int ElasticcdcRequest::_internal_feature_ids_size() const {
+  return _impl_.feature_ids_.size();
+}
+inline int ElasticcdcRequest::feature_ids_size() const {
+  return _internal_feature_ids_size();
+}
+inline void ElasticcdcRequest::clear_feature_ids() {
+  _impl_.feature_ids_.Clear();
+}
+inline int64_t ElasticcdcRequest::_internal_feature_ids(int index) const {
+  return _impl_.feature_ids_.Get(index);
+}
+inline int64_t ElasticcdcRequest::feature_ids(int index) const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcRequest.feature_ids)
+  return _internal_feature_ids(index);
+}
+inline void ElasticcdcRequest::set_feature_ids(int index, int64_t value) {
+  _impl_.feature_ids_.Set(index, value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.feature_ids)
+}
+inline void ElasticcdcRequest::_internal_add_feature_ids(int64_t value) {
+  _impl_.feature_ids_.Add(value);
+}
+inline void ElasticcdcRequest::add_feature_ids(int64_t value) {
+  _internal_add_feature_ids(value);
+  // @@protoc_insertion_point(field_add:elasticcdc.ElasticcdcRequest.feature_ids)
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >&
+ElasticcdcRequest::_internal_feature_ids() const {
+  return _impl_.feature_ids_;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >&
+ElasticcdcRequest::feature_ids() const {
+  // @@protoc_insertion_point(field_list:elasticcdc.ElasticcdcRequest.feature_ids)
+  return _internal_feature_ids();
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >*
+ElasticcdcRequest::_internal_mutable_feature_ids() {
+  return &_impl_.feature_ids_;
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< int64_t >*
+ElasticcdcRequest::mutable_feature_ids() {
+  // @@protoc_insertion_point(field_mutable_list:elasticcdc.ElasticcdcRequest.feature_ids)
+  return _internal_mutable_feature_ids();
+}
+
+// bool compressed = 22;
+inline void ElasticcdcRequest::clear_compressed() {
+  _impl_.compressed_ = false;
+}
+inline bool ElasticcdcRequest::_internal_compressed() const {
+  return _impl_.compressed_;
+}
+inline bool ElasticcdcRequest::compressed() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcRequest.compressed)
+  return _internal_compressed();
+}
+inline void ElasticcdcRequest::_internal_set_compressed(bool value) {
+  
+  _impl_.compressed_ = value;
+}
+inline void ElasticcdcRequest::set_compressed(bool value) {
+  _internal_set_compressed(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcRequest.compressed)
+}
+
+// -------------------------------------------------------------------
+
+// RetainedFeature
+
+// int64 id = 1;
+inline void RetainedFeature::clear_id() {
+  _impl_.id_ = int64_t{0};
+}
+inline int64_t RetainedFeature::_internal_id() const {
+  return _impl_.id_;
+}
+inline int64_t RetainedFeature::id() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.RetainedFeature.id)
+  return _internal_id();
+}
+inline void RetainedFeature::_internal_set_id(int64_t value) {
+  
+  _impl_.id_ = value;
+}
+inline void RetainedFeature::set_id(int64_t value) {
+  _internal_set_id(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.RetainedFeature.id)
+}
+
+// bytes data = 2;
+inline void RetainedFeature::clear_data() {
+  _impl_.data_.ClearToEmpty();
+}
+inline const std::string& RetainedFeature::data() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.RetainedFeature.data)
+  return _internal_data();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void RetainedFeature::set_data(ArgT0&& arg0, ArgT... args) {
+ 
+ _impl_.data_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:elasticcdc.RetainedFeature.data)
+}
+inline std::string* RetainedFeature::mutable_data() {
+  std::string* _s = _internal_mutable_data();
+  // @@protoc_insertion_point(field_mutable:elasticcdc.RetainedFeature.data)
+  return _s;
+}
+inline const std::string& RetainedFeature::_internal_data() const {
+  return _impl_.data_.Get();
+}
+inline void RetainedFeature::_internal_set_data(const std::string& value) {
+  
+  _impl_.data_.Set(value, GetArenaForAllocation());
+}
+inline std::string* RetainedFeature::_internal_mutable_data() {
+  
+  return _impl_.data_.Mutable(GetArenaForAllocation());
+}
+inline std::string* RetainedFeature::release_data() {
+  // @@protoc_insertion_point(field_release:elasticcdc.RetainedFeature.data)
+  return _impl_.data_.Release();
+}
+inline void RetainedFeature::set_allocated_data(std::string* data) {
+  if (data != nullptr) {
+    
+  } else {
+    
+  }
+  _impl_.data_.SetAllocated(data, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.data_.IsDefault()) {
+    _impl_.data_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:elasticcdc.RetainedFeature.data)
+}
+
 // -------------------------------------------------------------------
 
 // ElasticcdcReply
@@ -1379,16 +1920,88 @@ inline void ElasticcdcReply::set_recompute(bool value) {
   // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcReply.recompute)
 }
 
+// repeated .elasticcdc.RetainedFeature features = 6;
+inline int ElasticcdcReply::_internal_features_size() const {
+  return _impl_.features_.size();
+}
+inline int ElasticcdcReply::features_size() const {
+  return _internal_features_size();
+}
+inline void ElasticcdcReply::clear_features() {
+  _impl_.features_.Clear();
+}
+inline ::elasticcdc::RetainedFeature* ElasticcdcReply::mutable_features(int index) {
+  // @@protoc_insertion_point(field_mutable:elasticcdc.ElasticcdcReply.features)
+  return _impl_.features_.Mutable(index);
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::elasticcdc::RetainedFeature >*
+ElasticcdcReply::mutable_features() {
+  // @@protoc_insertion_point(field_mutable_list:elasticcdc.ElasticcdcReply.features)
+  return &_impl_.features_;
+}
+inline const ::elasticcdc::RetainedFeature& ElasticcdcReply::_internal_features(int index) const {
+  return _impl_.features_.Get(index);
+}
+inline const ::elasticcdc::RetainedFeature& ElasticcdcReply::features(int index) const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcReply.features)
+  return _internal_features(index);
+}
+inline ::elasticcdc::RetainedFeature* ElasticcdcReply::_internal_add_features() {
+  return _impl_.features_.Add();
+}
+inline ::elasticcdc::RetainedFeature* ElasticcdcReply::add_features() {
+  ::elasticcdc::RetainedFeature* _add = _internal_add_features();
+  // @@protoc_insertion_point(field_add:elasticcdc.ElasticcdcReply.features)
+  return _add;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField< ::elasticcdc::RetainedFeature >&
+ElasticcdcReply::features() const {
+  // @@protoc_insertion_point(field_list:elasticcdc.ElasticcdcReply.features)
+  return _impl_.features_;
+}
+
+// bool rejected = 7;
+inline void ElasticcdcReply::clear_rejected() {
+  _impl_.rejected_ = false;
+}
+inline bool ElasticcdcReply::_internal_rejected() const {
+  return _impl_.rejected_;
+}
+inline bool ElasticcdcReply::rejected() const {
+  // @@protoc_insertion_point(field_get:elasticcdc.ElasticcdcReply.rejected)
+  return _internal_rejected();
+}
+inline void ElasticcdcReply::_internal_set_rejected(bool value) {
+  
+  _impl_.rejected_ = value;
+}
+inline void ElasticcdcReply::set_rejected(bool value) {
+  _internal_set_rejected(value);
+  // @@protoc_insertion_point(field_set:elasticcdc.ElasticcdcReply.rejected)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
 // -------------------------------------------------------------------
 
+// -------------------------------------------------------------------
+
 
 // @@protoc_insertion_point(namespace_scope)
 
 }  // namespace elasticcdc
 
+PROTOBUF_NAMESPACE_OPEN
+
+template <> struct is_proto_enum< ::elasticcdc::ElasticcdcRequest_OutputMode> : ::std::true_type {};
+template <>
+inline const EnumDescriptor* GetEnumDescriptor< ::elasticcdc::ElasticcdcRequest_OutputMode>() {
+  return ::elasticcdc::ElasticcdcRequest_OutputMode_descriptor();
+}
+
+PROTOBUF_NAMESPACE_CLOSE
+
 // @@protoc_insertion_point(global_scope)
 
 #include <google/protobuf/port_undef.inc>